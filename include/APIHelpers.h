@@ -25,6 +25,7 @@
 #include "ForwardDecls.h"
 
 #include <QString>
+#include <vector>
 
 extern "C"
 {
@@ -73,4 +74,16 @@ QString oscapErrDesc();
  */
 QString oscapErrGetFullError();
 
+/**
+ * Recursively collects all rules under current that are selected by the given policy
+ *
+ * Unfortunately, xccdf_policy won't let us see its "selected-final" hashmap.
+ * Instead we have to gather all rules and for each rule ID we check the policy.
+ * Rules are appended to result in the order of the benchmark.
+ *
+ * @exception nothrow This function is guaranteed to not throw any exceptions.
+ */
+void gatherAllSelectedRules(struct xccdf_policy* policy, struct xccdf_item* current,
+    std::vector<struct xccdf_rule*>& result);
+
 #endif
@@ -26,7 +26,7 @@
 /**
  * @brief Central application
  *
- * Constructs the MainWindow.
+ * Constructs the MainWindow, or just a HeadlessScan if --headless was passed.
  * Technically, this class is a singleton because of the qApp global pointer
  * and the QCoreApplication::instance() static method.
  *
@@ -35,6 +35,8 @@
  */
 class Application : public QApplication
 {
+    Q_OBJECT
+
     public:
         /**
          * Make *sure* argc will be valid during lifetime of this class, you are
@@ -44,12 +46,35 @@ class Application : public QApplication
         Application(int& argc, char** argv);
         virtual ~Application();
 
+    private slots:
+        /// Exits the event loop with mExitCode, used when CLI processing fails in headless mode
+        void quitWithExitCode();
+
     private:
+        /**
+         * @brief Checks argv for --headless before QApplication parses it
+         *
+         * Needed to decide whether QApplication should be GUI enabled.
+         */
+        static bool headlessRequested(int argc, char** argv);
+
         /**
          * @brief Processes command line arguments and acts accordingly
          */
         void processCLI(QStringList& args);
 
+        /**
+         * @brief Processes command line arguments specific to the headless mode
+         */
+        void processHeadlessCLI(QStringList& args, const QString& tailoringFile);
+
+        /**
+         * @brief Removes given option and its value from args
+         *
+         * @return false if the option is present but not followed by a value
+         */
+        bool takeOptionValue(QStringList& args, const QString& option, QString& value);
+
         /**
          * @brief Opens the SSG integration dialog to let user open SSG
          */
@@ -72,7 +97,12 @@ class Application : public QApplication
 
         /// Whether the application should quit
         bool mShouldQuit;
+        /// Exit code used when quitting in headless mode
+        int mExitCode;
+        /// If true, no widgets are constructed, see HeadlessScan
+        bool mHeadless;
         /// Needed for QObject::tr(..) to work properly, loaded on app startup
         QTranslator mTranslator;
         MainWindow* mMainWindow;
+        HeadlessScan* mHeadlessScan;
 };
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+#ifndef SCAP_WORKBENCH_ARCHIVE_HELPERS_H_
+#define SCAP_WORKBENCH_ARCHIVE_HELPERS_H_
+
+#include "ForwardDecls.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+
+/**
+ * @brief Returns true if scap-workbench can compress and decompress gzip data
+ *
+ * This depends on whether zlib was found at build time.
+ *
+ * @exception nothrow This function is guaranteed to not throw any exceptions.
+ */
+bool isGzipSupported();
+
+/**
+ * @brief Checks the magic bytes at the start of data
+ *
+ * @exception nothrow This function is guaranteed to not throw any exceptions.
+ */
+bool isGzipCompressed(const QByteArray& data);
+
+/**
+ * @brief Decompresses everything readable from input in gzip format (RFC 1952) into output
+ *
+ * Data are processed in chunks, neither input nor output is held in memory
+ * as a whole. Both devices have to be open already.
+ *
+ * @exception ArchiveHelpersException Data are corrupted or truncated,
+ * reading or writing failed or scap-workbench was built without zlib.
+ */
+void gzipDecompress(QIODevice& input, QIODevice& output);
+
+/**
+ * @brief Compresses everything readable from input into output in gzip format
+ *
+ * Data are processed in chunks, neither input nor output is held in memory
+ * as a whole. Both devices have to be open already.
+ *
+ * @exception ArchiveHelpersException Reading or writing failed or
+ * scap-workbench was built without zlib.
+ */
+void gzipCompress(QIODevice& input, QIODevice& output);
+
+/**
+ * @brief Extracts chosen regular files from a tar archive read from given device
+ *
+ * Both POSIX ustar and GNU tar archives are supported as long as the file
+ * names fit in the header. Leading "./" is stripped from the file names,
+ * directories, other special entries and files not in destinations are
+ * skipped. Files are copied in chunks, none of them is held in memory as
+ * a whole. The archive has to be open already.
+ *
+ * @param destinations Maps names in the archive to local paths, existing files are overwritten
+ * @param extracted Names of the extracted files are appended
+ * @exception ArchiveHelpersException The archive is corrupted or truncated
+ * or a file can't be written.
+ */
+void extractTarArchive(QIODevice& archive, const QMap<QString, QString>& destinations, QStringList& extracted);
+
+/**
+ * @brief Writes given local files to output as a POSIX ustar archive
+ *
+ * Files are copied in chunks, none of them is held in memory as a whole.
+ * The output has to be open already.
+ *
+ * @param files Maps names in the archive (up to 99 characters) to paths of local files
+ * @exception ArchiveHelpersException Any of the files can't be read or
+ * writing failed.
+ */
+void writeTarArchive(const QMap<QString, QString>& files, QIODevice& output);
+
+#endif
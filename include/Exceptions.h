@@ -39,12 +39,21 @@ class NAME : public std::runtime_error \
         {} \
 };
 
+SCAP_WORKBENCH_SIMPLE_EXCEPTION(ArchiveHelpersException,
+    "There was a problem with ArchiveHelpers!\n");
+
 SCAP_WORKBENCH_SIMPLE_EXCEPTION(MainWindowException,
     "There was a problem with MainWindow!\n");
 
+SCAP_WORKBENCH_SIMPLE_EXCEPTION(ResultMergerException,
+    "There was a problem with ResultMerger!\n");
+
 SCAP_WORKBENCH_SIMPLE_EXCEPTION(RuleResultsTreeException,
     "There was a problem with RuleResultsTree!\n");
 
+SCAP_WORKBENCH_SIMPLE_EXCEPTION(ScanArtifactsException,
+    "There was a problem with ScanArtifacts!\n");
+
 SCAP_WORKBENCH_SIMPLE_EXCEPTION(ScanningSessionException,
     "There was a problem with ScanningSession!\n");
 
@@ -60,9 +69,15 @@ SCAP_WORKBENCH_SIMPLE_EXCEPTION(TailoringWindowException,
 SCAP_WORKBENCH_SIMPLE_EXCEPTION(TemporaryDirException,
     "There was a problem with TemporaryDir!\n");
 
+SCAP_WORKBENCH_SIMPLE_EXCEPTION(OscapScannerBaseException,
+    "There was a problem with OscapScannerBase!\n");
+
 SCAP_WORKBENCH_SIMPLE_EXCEPTION(OscapScannerRemoteSshException,
     "There was a problem with OscapScannerRemoteSsh!\n");
 
+SCAP_WORKBENCH_SIMPLE_EXCEPTION(FleetScanSchedulerException,
+    "There was a problem with FleetScanScheduler!\n");
+
 SCAP_WORKBENCH_SIMPLE_EXCEPTION(RPMOpenHelperException,
     "There was a problem with RPMOpenHelper!\n");
 
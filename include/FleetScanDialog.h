@@ -0,0 +1,92 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_FLEET_SCAN_DIALOG_H_
+#define SCAP_WORKBENCH_FLEET_SCAN_DIALOG_H_
+
+#include "ForwardDecls.h"
+#include "FleetScanScheduler.h"
+
+#include <QDialog>
+#include <QMap>
+
+#include "ui_FleetScanDialog.h"
+
+class QSettings;
+class QTreeWidgetItem;
+
+/**
+ * @brief Lets the user scan many remote machines with the loaded content
+ *
+ * Targets are entered one per line, they are scanned by FleetScanScheduler
+ * and the state of every target is shown in a single table.
+ */
+class FleetScanDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        explicit FleetScanDialog(ScanningSession* session, QWidget* parent = 0);
+        virtual ~FleetScanDialog();
+
+        void setSkipValid(bool skip);
+        void setFetchRemoteResources(bool fetch);
+
+    protected:
+        /// reimplemented to make sure we cancel the fleet scan before closing
+        virtual void closeEvent(QCloseEvent* event);
+        virtual void reject();
+
+    private slots:
+        void startScan();
+        void cancelScan();
+        void browseOutputDirectory();
+
+        void targetStarted(const QString& target);
+        /// Counts the evaluated rules of given target, the counter is updated once per batch
+        void targetProgressReportBatch(const QString& target, const QStringList& ruleIDs, const QStringList& results);
+        void targetInfoMessage(const QString& target, const QString& message);
+        void targetWarningMessage(const QString& target, const QString& message);
+        void targetErrorMessage(const QString& target, const QString& message);
+        void targetEnded(const QString& target, FleetScanScheduler::TargetState state);
+        void fleetProgress(unsigned int done, unsigned int total);
+        void fleetFinished();
+
+    private:
+        /// Parses the targets text edit, appends the default port where it is missing
+        QStringList parseTargets() const;
+        void setScanningUIState(bool scanning);
+
+        void syncFromQSettings();
+        void syncToQSettings();
+
+        Ui_FleetScanDialog mUI;
+        QSettings* mQSettings;
+
+        FleetScanScheduler* mScheduler;
+
+        QMap<QString, QTreeWidgetItem*> mTargetItems;
+        QMap<QString, unsigned int> mEvaluatedRules;
+        QMap<QString, QString> mLastRuleIDs;
+};
+
+#endif
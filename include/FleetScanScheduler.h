@@ -0,0 +1,201 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_FLEET_SCAN_SCHEDULER_H_
+#define SCAP_WORKBENCH_FLEET_SCAN_SCHEDULER_H_
+
+#include "ForwardDecls.h"
+#include "Scanner.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QMap>
+#include <QTemporaryFile>
+
+class QTimer;
+
+/**
+ * @brief Scans many remote targets with a bounded number of concurrent scanners
+ *
+ * Each target (in the username@hostname:port format RemoteMachineComboBox
+ * produces) gets its own OscapScannerRemoteSsh running in its own QThread.
+ * At most getMaxConcurrency() scanners are running at any given time, the
+ * remaining targets wait in a queue and are started as soon as a slot frees up.
+ *
+ * Results of every target are written to the output directory as soon as
+ * that target finishes, the scanner is destroyed right after. This keeps
+ * memory usage bounded no matter how many targets are in the fleet.
+ *
+ * All the per-scanner signals are aggregated and re-emitted with the target
+ * attached so that a single view can display progress of the whole fleet.
+ */
+class FleetScanScheduler : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum TargetState
+        {
+            TS_QUEUED,
+            TS_RUNNING,
+            TS_FINISHED,
+            /// The scan completed and its results were saved, but errors were reported
+            TS_FINISHED_WITH_ERRORS,
+            /// The scan didn't complete because of an error, nothing was saved
+            TS_FAILED,
+            TS_CANCELED,
+            TS_TIMED_OUT
+        };
+
+        explicit FleetScanScheduler(QObject* parent = 0);
+        virtual ~FleetScanScheduler();
+
+        /**
+         * @brief Sets the session all targets will be scanned with
+         *
+         * The session has to stay loaded and unchanged until the whole fleet
+         * has been scanned. Only source datastreams are supported.
+         *
+         * The tailoring of the session is exported once when the fleet scan
+         * starts, all scanners share that file and never write to it.
+         */
+        void setSession(ScanningSession* session);
+        void setTargets(const QStringList& targets);
+        const QStringList& getTargets() const;
+
+        /// How many targets may be scanned at the same time, 0 is treated as 1
+        void setMaxConcurrency(unsigned int maxConcurrency);
+        unsigned int getMaxConcurrency() const;
+
+        /**
+         * @brief Sets timeout for scanning a single target, in seconds
+         *
+         * The timer starts when the target's scanner is started. Targets that
+         * take longer are canceled and reported as timed out. 0 disables the timeout.
+         */
+        void setTargetTimeout(unsigned int seconds);
+        unsigned int getTargetTimeout() const;
+
+        /// Directory where per-target XCCDF results, HTML reports and ARFs are written
+        void setOutputDirectory(const QString& dir);
+        const QString& getOutputDirectory() const;
+
+        void setScannerMode(ScannerMode mode);
+        void setSkipValid(bool skip);
+        void setFetchRemoteResources(bool fetch);
+
+        /// Returns true while at least one target is queued or being scanned
+        bool isRunning() const;
+
+        TargetState getTargetState(const QString& target) const;
+        static QString targetStateToString(TargetState state);
+
+        /**
+         * @brief Converts target to a string usable as a file name prefix
+         */
+        static QString targetToFileName(const QString& target);
+
+    public slots:
+        /**
+         * @brief Starts scanning the fleet, returns immediately
+         *
+         * Asserts that the scheduler isn't already running.
+         */
+        void start();
+
+        /**
+         * @brief Cancels all running scans and drops all queued targets
+         */
+        void cancel();
+
+    signals:
+        void targetStarted(const QString& target);
+        /// Results of rules evaluated since the last batch of given target, ruleIDs and results have the same size
+        void targetProgressReportBatch(const QString& target, const QStringList& ruleIDs, const QStringList& results);
+        void targetInfoMessage(const QString& target, const QString& message);
+        void targetWarningMessage(const QString& target, const QString& message);
+        void targetErrorMessage(const QString& target, const QString& message);
+        void targetEnded(const QString& target, FleetScanScheduler::TargetState state);
+
+        /**
+         * @brief Emitted whenever a target ends (for whatever reason)
+         *
+         * @param done number of targets that have already ended
+         * @param total number of targets in the fleet
+         */
+        void fleetProgress(unsigned int done, unsigned int total);
+
+        /// Emitted once all targets have ended
+        void fleetFinished();
+
+    private slots:
+        void scannerProgressReportBatch(const QStringList& ruleIDs, const QStringList& results);
+        void scannerInfoMessage(const QString& message);
+        void scannerWarningMessage(const QString& message);
+        void scannerErrorMessage(const QString& message);
+        void scannerCanceled();
+        void scannerFinished();
+        void targetTimedOut();
+
+    private:
+        struct ActiveScan
+        {
+            QString target;
+            QThread* thread;
+            QTimer* timeoutTimer;
+            bool timedOut;
+            /// The scanner reported an error, the state still depends on how the scan ended
+            bool hadErrors;
+        };
+
+        /// Exports tailoring of the session for all the scanners to read
+        void exportTailoring();
+        /// Starts queued targets until the concurrency limit is reached
+        void startQueuedTargets();
+        void startTarget(const QString& target);
+        void endTarget(Scanner* scanner, bool canceled);
+        void saveTargetResults(Scanner* scanner, const QString& target);
+        QString senderTarget() const;
+
+        ScanningSession* mSession;
+        QStringList mTargets;
+        unsigned int mMaxConcurrency;
+        unsigned int mTargetTimeout;
+        QString mOutputDirectory;
+        ScannerMode mScannerMode;
+        bool mSkipValid;
+        bool mFetchRemoteResources;
+
+        /// Tailoring of the session as exported by exportTailoring
+        QTemporaryFile mTailoringFile;
+        /// Empty if the session has no tailoring
+        QString mTailoringFilePath;
+
+        /// Targets waiting for a free slot
+        QStringList mQueue;
+        /// Scanners that are running right now
+        QMap<Scanner*, ActiveScan> mActive;
+        QMap<QString, TargetState> mStates;
+        unsigned int mDoneCount;
+};
+
+#endif
@@ -27,25 +27,46 @@
 class Application;
 class CommandLineArgsDialog;
 class DiagnosticsDialog;
+class FleetScanDialog;
+class FleetScanScheduler;
+class HeadlessScan;
 class MainWindow;
 class OscapCapabilities;
+class OscapCapabilitiesCache;
 class OscapScannerBase;
+class OscapScannerInProcess;
 class OscapScannerLocal;
 class OscapScannerRemoteSsh;
 class ProfilePropertiesDockWidget;
 class ProfileTitleChangeUndoCommand;
 class ProfileDescriptionChangeUndoCommand;
 class RemoteMachineComboBox;
+class ResultMerger;
 class ResultViewer;
 class RPMOpenHelper;
 class RuleResultItem;
 class RuleResultsTree;
+class RuleTimingModel;
+class RuleTimingReport;
+class RuleTimingsDialog;
 class SaveAsRPMDialog;
+class ScanArtifacts;
 class ScanningSession;
 class Scanner;
+class ScanTrace;
+class SessionLoader;
+class SessionMetadataCache;
+class SessionPool;
+struct SessionPoolKey;
+class ValidationCache;
+struct SessionMetadata;
+struct SessionProfileItem;
+struct SessionRuleItem;
 class SshConnection;
+class SshConnectionPool;
 class SshSyncProcess;
 class ScpSyncProcess;
+class ScratchSpace;
 class SyncProcess;
 class SSGIntegrationDialog;
 class TailoringWindow;
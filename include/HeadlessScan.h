@@ -0,0 +1,111 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_HEADLESS_SCAN_H_
+#define SCAP_WORKBENCH_HEADLESS_SCAN_H_
+
+#include "ForwardDecls.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+/**
+ * @brief Evaluates a single target without constructing any widgets
+ *
+ * Used by Application when SCAP Workbench is started with --headless. Opens
+ * the content, selects the profile, runs a scanner in a separate thread and
+ * writes XCCDF results, HTML report and ARF to the output directory. With
+ * several profiles these are written for each of them.
+ *
+ * The application exits once evaluation ends, exit code is 0 on success
+ * and 1 if anything went wrong.
+ */
+class HeadlessScan : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit HeadlessScan(QObject* parent = 0);
+        virtual ~HeadlessScan();
+
+        void setSkipValid(bool skipValid);
+        void setFetchRemoteResources(bool fetch);
+        void setOnlineRemediation(bool remediate);
+
+        void setInputFile(const QString& path);
+        void setTailoringFile(const QString& path);
+        /// Empty profile ID means the (default) profile
+        void setProfile(const QString& profileID);
+        /**
+         * @brief Sets profiles evaluated in the same pass as the profile set by setProfile
+         *
+         * Requires the in-process scanner, see OscapScannerInProcess. Output
+         * file names get the profile ID appended if this is not empty.
+         */
+        void setAdditionalProfiles(const QStringList& profileIDs);
+        /// "localhost" or username@hostname[:port]
+        void setTarget(const QString& target);
+        void setOutputDirectory(const QString& dir);
+
+    public slots:
+        /**
+         * @brief Starts the evaluation, has to be called from the event loop
+         *
+         * QCoreApplication::exit has no effect before the event loop is entered.
+         */
+        void start();
+
+    private slots:
+        void scanInfoMessage(const QString& message);
+        void scanWarningMessage(const QString& message);
+        void scanErrorMessage(const QString& message);
+        void scanCanceled();
+        void scanFinished();
+
+    private:
+        /// Writes all results to the output directory, returns false on failure
+        bool saveResults();
+        /// Copies results, report and ARF to the output directory
+        bool saveArtifacts(const ScanArtifacts& artifacts, const QString& baseName);
+        bool saveFile(const QString& fileName, const QByteArray& data);
+        static QString getOutputBaseName(const QString& baseName, const QString& profileID);
+        void exitWith(int exitCode);
+
+        bool mSkipValid;
+        bool mFetchRemoteResources;
+        bool mOnlineRemediation;
+
+        QString mInputFile;
+        QString mTailoringFile;
+        QString mProfile;
+        QStringList mAdditionalProfiles;
+        QString mTarget;
+        QString mOutputDirectory;
+
+        ScanningSession* mScanningSession;
+        QThread* mScanThread;
+        Scanner* mScanner;
+};
+
+#endif
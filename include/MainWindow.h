@@ -24,11 +24,14 @@
 
 #include "ForwardDecls.h"
 #include "Scanner.h"
+#include "SessionMetadataCache.h"
 
 #include <QMainWindow>
 #include <QThread>
 #include <QMenu>
 #include <QMessageBox>
+#include <QList>
+#include <QProgressDialog>
 
 extern "C"
 {
@@ -131,6 +134,13 @@ class MainWindow : public QMainWindow
          */
         void offlineRemediateAsync();
 
+        /**
+         * @brief Re-evaluates only rules that failed in the results in ResultViewer
+         *
+         * Results of the re-checked rules are spliced into the previous results.
+         */
+        void rescanFailedAsync();
+
         /**
          * @brief Cancels scanning in separate thread
          *
@@ -141,6 +151,16 @@ class MainWindow : public QMainWindow
          */
         void cancelScanAsync();
 
+        /**
+         * @brief Opens a modal dialog that scans many remote machines at once
+         *
+         * The currently loaded content, tailoring and profile are used for
+         * all the machines.
+         *
+         * @see FleetScanScheduler
+         */
+        void openFleetScanDialog();
+
         /**
          * @brief calls setEnable(true)
          *
@@ -183,14 +203,51 @@ class MainWindow : public QMainWindow
          * @note This method does attempt to "keep" the previous selection if possible.
          */
         void refreshProfiles();
+        /// Same as refreshProfiles but with items already built by SessionLoader
+        void refreshProfiles(const QList<SessionProfileItem>& profiles);
+        void addProfileItems(const QList<SessionProfileItem>& profiles);
+
+        /**
+         * @brief Fills widgets with metadata of content that is still being loaded
+         *
+         * The session is not touched, see SessionLoader::metadataLoaded
+         */
+        void showSessionMetadata(const SessionMetadata& metadata);
+
+        /**
+         * @brief Refreshes widgets showing the loaded session, see reloadSession
+         */
+        void showLoadedSession(const QList<SessionProfileItem>& profiles);
+
+        /**
+         * @brief Runs given loader in a separate thread and waits until it finishes
+         *
+         * Events are processed while waiting, a progress dialog that doesn't
+         * block the window shows stages of the loading. The session must not
+         * be touched until this returns, see disableSessionActions.
+         *
+         * @param cancelable Whether the progress dialog has a cancel button
+         */
+        void runSessionLoader(SessionLoader& loader, bool cancelable);
+
+        /**
+         * @brief Disables widgets and actions that would touch the session while it loads
+         *
+         * Scanning, tailoring, choosing a checklist or a profile, opening and
+         * saving wait for the load. The rest of the window stays usable, rules
+         * shown from cached metadata can be browsed for example.
+         */
+        void disableSessionActions();
+        /// Enables what disableSessionActions has disabled
+        void restoreSessionActions();
 
         /**
          * @brief Refreshes the checklists combobox from scratch
          *
-         * @note Does not keep the previous selection!
-         * @note Throws exceptions!
+         * @note Does not keep the previous selection! Selects the checklist
+         *       the metadata were loaded with without reloading the session.
          */
-        void refreshChecklists();
+        void refreshChecklists(const SessionMetadata& metadata);
 
         /**
          * @brief Destroys the scanning thread and associated data
@@ -228,6 +285,8 @@ class MainWindow : public QMainWindow
          * @see Scanner
          */
         Scanner* mScanner;
+        /// True once the scanner estimates progress from rule durations, counting results is not used then
+        bool mProgressEstimated;
 
         /// Remembers old tailoring combobox ID in case we want to revert to it when user cancels
         int mOldTailoringComboBoxIdx;
@@ -236,6 +295,17 @@ class MainWindow : public QMainWindow
         /// If true, the profile combobox change signal is ignored, this avoids unnecessary profile refreshes
         bool mIgnoreProfileComboBox;
 
+        /// Shows progress of runSessionLoader, NULL if no session is being loaded
+        QProgressDialog* mSessionLoadProgress;
+        /// Widgets and actions that were enabled before disableSessionActions
+        QList<QWidget*> mSessionLoadDisabledWidgets;
+        QList<QAction*> mSessionLoadDisabledActions;
+
+        /// Rules of mPreparedRulesProfileID gathered while opening, valid if mHasPreparedRules
+        bool mHasPreparedRules;
+        QString mPreparedRulesProfileID;
+        QList<SessionRuleItem> mPreparedRules;
+
     signals:
         /**
          * @brief We signal this to show the dialog
@@ -275,6 +345,11 @@ class MainWindow : public QMainWindow
         /// Profile change, we simply change the profile id in the session
         void profileComboboxChanged(int index);
 
+        /// Updates the session loading progress dialog
+        void sessionLoadStageStarted(int stage, const QString& description);
+        /// Shows cached metadata of the content being opened, see SessionLoader
+        void sessionMetadataLoaded();
+
     private:
         /**
          * @brief Refreshes the list of tailoring profiles and loads the first tailored one
@@ -306,6 +381,16 @@ class MainWindow : public QMainWindow
          */
         void scanProgressReport(const QString& rule_id, const QString& result);
 
+        /**
+         * @brief Batched variant of scanProgressReport, this is what the scanner triggers
+         */
+        void scanProgressReportBatch(const QStringList& ruleIDs, const QStringList& results);
+
+        /**
+         * @brief Scanner triggers this with progress weighed by rule durations from previous scans
+         */
+        void scanProgressEstimate(double progress, int remainingSeconds);
+
         /**
          * @brief Scanner triggers this to show a message about progress
          *
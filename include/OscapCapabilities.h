@@ -98,6 +98,13 @@ class OscapCapabilities
          */
         bool tailoringSupport() const;
 
+        /**
+         * @brief Returns true if evaluation can be limited to a set of rules
+         *
+         * This means that 'oscap xccdf eval' accepts --rule multiple times.
+         */
+        bool multipleRuleFilters() const;
+
         const QString& XCCDFVersion() const;
         const QString& OVALVersion() const;
         const QString& CPEVersion() const;
@@ -111,6 +118,7 @@ class OscapCapabilities
         bool mSourceDataStreams;
         bool mARFInput;
         bool mTailoringSupport;
+        bool mMultipleRuleFilters;
         bool mSCE;
 
         QString mXCCDFVersion;
@@ -119,4 +127,37 @@ class OscapCapabilities
         QString mSCEVersion;
 };
 
+/**
+ * @brief Remembers verbatim 'oscap -V' output of scanned machines
+ *
+ * Entries are persisted in QSettings and keyed by target. Each entry also
+ * holds identity of the oscap binary it was queried from (path, size and
+ * modification time), callers must only use the cached output if the
+ * identity still matches. Entries older than the TTL are never returned.
+ *
+ * QSettings is reentrant, the methods can be called from scan threads.
+ */
+class OscapCapabilitiesCache
+{
+    public:
+        /// How long entries stay valid, in seconds
+        static const int TTL = 24 * 60 * 60;
+
+        /**
+         * @brief Looks up a valid entry for given target
+         *
+         * @return true if found, binaryIdentity and versionOutput are filled in that case
+         */
+        static bool lookup(const QString& target, QString& binaryIdentity, QString& versionOutput);
+        static void store(const QString& target, const QString& binaryIdentity, const QString& versionOutput);
+
+        /**
+         * @brief Forgets cached capabilities of given target
+         *
+         * Call this when the cached capabilities turn out to be insufficient,
+         * the next scan will query them again.
+         */
+        static void invalidate(const QString& target);
+};
+
 #endif
@@ -26,9 +26,14 @@
 
 #include "Scanner.h"
 #include "OscapCapabilities.h"
+#include "RuleTimingModel.h"
+#include "ResultMerger.h"
 
 #include <QStringList>
 #include <QProcess>
+#include <QTemporaryFile>
+
+class QTimer;
 
 class OscapScannerBase : public Scanner
 {
@@ -40,14 +45,35 @@ class OscapScannerBase : public Scanner
 
         virtual void cancel();
 
-        virtual void getResults(QByteArray& destination);
-        virtual void getReport(QByteArray& destination);
-        virtual void getARF(QByteArray& destination);
+        /**
+         * @brief Reads everything the evaluation needs from the session
+         *
+         * Scanners evaluate in their own threads and fleet scans run several
+         * of them at once. The evaluation only uses what has been read here,
+         * it doesn't touch the libopenscap session. Has to be called from
+         * the thread that owns the session.
+         */
+        virtual void setSession(ScanningSession* session);
+
+        virtual ScanArtifacts* takeArtifacts();
+        virtual void getRuleTimings(QHash<QString, qint64>& destination);
+
+        virtual void setPreviousArtifacts(ScanArtifacts* artifacts);
 
     protected:
         virtual void signalCompletion(bool canceled);
 
         bool checkPrerequisites();
+
+        /**
+         * @brief Starts measuring durations of rules and estimating progress
+         *
+         * Call when the evaluation is about to start, the measured durations
+         * are stored when the evaluation completes.
+         */
+        void startRuleTiming();
+        void finishRuleTiming();
+
         QString surroundQuote(const QString& input)const;
         QStringList buildEvaluationArgs(const QString& inputFile,
                                         const QString& tailoringFile,
@@ -55,46 +81,86 @@ class OscapScannerBase : public Scanner
                                         const QString& reportFile,
                                         const QString& arfFile,
                                         bool onlineRemediation,
-                                        bool ignoreCapabilities = false) const;
+                                        bool ignoreCapabilities = false,
+                                        const QStringList& rules = QStringList()) const;
+        /**
+         * @brief Merges results of several oscap runs into mArtifacts
+         *
+         * The first files are the base, see ResultMerger. The HTML report is
+         * generated from the merged ARF by local oscap. Sets mCancelRequested
+         * if the results can't be merged.
+         */
+        void mergeResults(const QStringList& resultFiles, const QStringList& arfFiles);
+
+        /**
+         * @brief Splices results of re-checked rules into the previous results
+         *
+         * Used at the end of evaluation in SM_RESCAN_FAILED mode, mArtifacts
+         * are expected to contain results of the re-checked rules.
+         */
+        void spliceRescanResults();
+
         QStringList buildOfflineRemediationArgs(const QString& resultInputFile,
                                                 const QString& resultFile,
                                                 const QString& reportFile,
                                                 const QString& arfFile,
                                                 bool ignoreCapabilities = false) const;
 
-        /// Last read rule id
+        /// Last read rule id, "processing" has been reported for it
         QString mLastRuleID;
         /// Last downloading file
         QString mLastDownloadingFile;
 
-        enum ReadingState
-        {
-            RS_READING_PREFIX,
-            RS_READING_RULE_RESULT,
-            RS_READING_DOWNLOAD_FILE,
-            RS_READING_DOWNLOAD_FILE_STATUS
-        };
-
-        ReadingState mReadingState;
-
-        /// We keep filling this buffer until we reach : or \n
-        QString mReadBuffer;
+        /// Incomplete last line of stdout, kept until the rest of it is read
+        QByteArray mReadBuffer;
 
         /**
-         * @brief Tries to read something (at least one character) from stdout
+         * @brief Parses one complete line of stdout (without the trailing newline)
          *
-         * @note ReadChannel must be set properly before calling this method!
-         * @returns false when there is nothing to be read, true otherwise
-         * @see readStdOut
+         * Parsed rule results are appended to ruleIDs and results.
          */
-        bool tryToReadStdOutChar(QProcess& process);
+        void parseStdOutLine(const char* line, int length, QString& lastRuleID,
+            QStringList& ruleIDs, QStringList& results);
+
+        /**
+         * @brief Reports "processing" of the rule whose ID is in the incomplete line
+         */
+        void parseStdOutPartialLine(const QByteArray& readBuffer, QString& lastRuleID,
+            QStringList& ruleIDs, QStringList& results);
+
+        void parseDownloadingLine(const QString& line, bool complete);
 
         /**
-         * @brief Reads as much as possible from stdout of given process
+         * @brief Reads everything available from stdout of given process
+         *
+         * Reads whole chunks and splits them into lines. All rule results
+         * parsed from a chunk are emitted as one progressReportBatch.
          */
         void readStdOut(QProcess& process);
+        /**
+         * @brief Same as readStdOut but with read state kept by the caller
+         *
+         * This allows reading output of several oscap processes at once.
+         */
+        void readStdOut(QProcess& process, QByteArray& readBuffer, QString& lastRuleID);
+        /**
+         * @brief Parses a chunk of oscap --progress output, no matter where it got split
+         *
+         * The incomplete last line is kept in readBuffer for the next chunk.
+         */
+        void parseStdOutChunk(const QByteArray& chunk, QByteArray& readBuffer, QString& lastRuleID);
         void watchStdErr(QProcess& process);
 
+        /**
+         * @brief Runs the event loop until the oscap process exits or cancel is requested
+         *
+         * Output of the process is read as soon as it arrives (readyRead
+         * signals), there is no polling. When cancel is requested the process is
+         * terminated (or killed right away if killOnCancel is true) and this
+         * method returns once it has exited.
+         */
+        void waitForScanProcess(QProcess& process, bool killOnCancel);
+
         /**
          * @brief Converts OpenSCAP CLI messages to SCAP Workbench GUI messages.
          */
@@ -102,11 +168,47 @@ class OscapScannerBase : public Scanner
 
         bool mCancelRequested;
 
+        /// Rules that failed in the previous results, evaluated in SM_RESCAN_FAILED mode
+        QStringList mRescanRules;
+
+        /// Read from the session by setSession
+        QString mInputFile;
+        bool mInputIsSDS;
+        QString mDatastreamID;
+        QString mComponentID;
+        QString mProfileID;
+        QString mBenchmarkID;
+        QStringList mSelectedRuleIDs;
+        /// Has the scoring hierarchy of the benchmark, mergeResults merges with copies of it
+        ResultMerger mScoringMerger;
+        /// Tailoring exported by setSession unless a file has been set with setTailoringFile
+        QTemporaryFile mOwnTailoringFile;
+
+    signals:
+        /// Emitted by cancel(), wakes up waitForScanProcess immediately
+        void cancelRequested();
+
+    protected slots:
+        void reportProgressEstimate();
+
+    private slots:
+        void readScanProcessStdOut();
+        void readScanProcessStdErr();
+
+    protected:
+        /// Valid only while waitForScanProcess is running
+        QProcess* mScanProcess;
+
         OscapCapabilities mCapabilities;
 
-        QByteArray mResults;
-        QByteArray mReport;
-        QByteArray mARF;
+        RuleTimingModel mRuleTiming;
+        /// Durations measured in the last evaluation, kept after mRuleTiming is reset
+        QHash<QString, qint64> mRuleDurations;
+        /// Keeps the estimate moving while oscap is busy with a long rule
+        QTimer* mProgressEstimateTimer;
+
+        /// Scanners write results here, the files are handed over by takeArtifacts
+        ScanArtifacts* mArtifacts;
 };
 
 #endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_OSCAP_SCANNER_IN_PROCESS_H_
+#define SCAP_WORKBENCH_OSCAP_SCANNER_IN_PROCESS_H_
+
+#include "ForwardDecls.h"
+#include "OscapScannerBase.h"
+
+#include <QElapsedTimer>
+#include <QMap>
+
+extern "C"
+{
+#include <xccdf_policy.h>
+}
+
+/**
+ * @brief Evaluates the local machine with libopenscap in the scanning thread
+ *
+ * Unlike OscapScannerLocal no oscap process is started, the xccdf_session that
+ * ScanningSession has already loaded is evaluated directly. The content isn't
+ * parsed and validated again and progress comes from rule callbacks instead of
+ * parsed stdout. Results are exported to a private temporary directory and
+ * read back.
+ *
+ * The evaluation runs with privileges of the user running scap-workbench.
+ * Rules that need root privileges will end with errors, that's why this
+ * scanner is optional, see isEnabled.
+ *
+ * Several profiles can be evaluated in one pass, see setAdditionalProfiles.
+ *
+ * @note The ScanningSession must not be modified while the scan is running.
+ */
+class OscapScannerInProcess : public OscapScannerBase
+{
+    Q_OBJECT
+
+    public:
+        OscapScannerInProcess();
+        virtual ~OscapScannerInProcess();
+
+        /**
+         * @brief Returns true if local scans should be evaluated in-process
+         *
+         * Enabled by the SCAP_WORKBENCH_IN_PROCESS_SCAN environment variable
+         * or the "in-process-local-scan" setting.
+         */
+        static bool isEnabled();
+
+        /**
+         * @brief Returns true if this scanner can evaluate a scan with given settings
+         *
+         * Only plain scans are supported. Remediation needs root privileges
+         * and fetching remote resources requires reloading the session.
+         */
+        static bool supports(ScannerMode mode, bool fetchRemoteResources);
+
+        virtual QStringList getCommandLineArgs() const;
+        virtual void evaluate();
+
+        /**
+         * @brief Sets profiles evaluated after the profile selected in the session
+         *
+         * All profiles are evaluated with the same xccdf_policy_model, OVAL
+         * objects collected for one profile are reused by the others unless
+         * the profiles set different values of the OVAL variables. Results of
+         * the selected profile are available via takeArtifacts.
+         *
+         * Empty profile ID means the (default) profile.
+         */
+        void setAdditionalProfiles(const QStringList& profileIDs);
+        const QStringList& getAdditionalProfiles() const;
+
+        /**
+         * @brief Hands over results of one of the additional profiles
+         *
+         * @return Artifacts owned by the caller, NULL if the profile hasn't been evaluated
+         * @note This will only work after "evaluate()" finished successfully.
+         */
+        ScanArtifacts* takeAdditionalArtifacts(const QString& profileID);
+
+    private:
+        static int ruleStartedCallback(struct xccdf_rule* rule, void* userData);
+        static int ruleFinishedCallback(struct xccdf_rule_result* ruleResult, void* userData);
+
+        /// Emits results gathered by the callbacks as one progressReportBatch
+        void flushProgress();
+
+        /**
+         * @brief Evaluates the profile selected in the session and exports its results
+         *
+         * @return false if canceled or failed, mCancelRequested is set then
+         */
+        bool evaluateSelectedProfile(struct xccdf_session* session, ScanArtifacts& artifacts);
+
+        /**
+         * @brief Exports results of the last evaluation of the session
+         *
+         * @return false if the export failed, an error message has been emitted
+         */
+        bool exportResults(struct xccdf_session* session, ScanArtifacts& artifacts);
+
+        /// Valid only while evaluating, used to skip rules that are not selected
+        struct xccdf_policy* mPolicy;
+
+        /// Results gathered by the callbacks since the last flushProgress
+        QStringList mPendingRuleIDs;
+        QStringList mPendingResults;
+        QElapsedTimer mSinceFlush;
+
+        QStringList mAdditionalProfiles;
+        /// Results of the additional profiles, profile ID -> owned artifacts
+        QMap<QString, ScanArtifacts*> mAdditionalArtifacts;
+};
+
+#endif
@@ -23,10 +23,13 @@
 #define SCAP_WORKBENCH_OSCAP_SCANNER_LOCAL_H_
 
 #include <QTemporaryFile>
+#include <QList>
 
 #include "ForwardDecls.h"
 #include "OscapScannerBase.h"
 
+class QEventLoop;
+
 
 class OscapScannerLocal : public OscapScannerBase
 {
@@ -48,13 +51,86 @@ class OscapScannerLocal : public OscapScannerBase
          */
         static QString getOscapProgramAndAdaptArgs(QStringList& args);
 
+    private slots:
+        void readShardStdOut();
+        void readShardStdErr();
+        void shardFinished();
+
     private:
         static QString getPkexecOscapPath();
+        /// Same as getOscapProgramAndAdaptArgs but oscap is run directly, never elevated
+        static QString getUnprivilegedOscapProgramAndAdaptArgs(QStringList& args);
         void fillInCapabilities();
 
+        /**
+         * @brief Returns how many oscap processes may evaluate one scan at once
+         *
+         * Defaults to the number of CPU cores, capped. Can be overridden by
+         * the SCAP_WORKBENCH_LOCAL_SCAN_SHARDS environment variable, 1 disables
+         * sharding.
+         */
+        static int getMaxShardCount();
+
+        /**
+         * @brief Splits the selected rules into shards evaluated in parallel
+         *
+         * Returns an empty list if the scan should not be sharded, that is
+         * when oscap can't filter rules, the scan remediates or there are
+         * too few rules.
+         */
+        QList<QStringList> planShards() const;
+
+        /**
+         * @brief Evaluates each shard in its own oscap process and merges the results
+         *
+         * The first process is started alone, the rest once it reports
+         * whether it runs with elevated privileges. All processes run with
+         * the same privileges and the user is asked for authentication just
+         * once. If the first process was not elevated the rest run oscap
+         * directly. If it was and the rest fail to elevate the scan fails.
+         */
+        void evaluateSharded(const QList<QStringList>& shards);
+        void startShard(int index);
+        void startRemainingShards();
+        /**
+         * @brief Reads the elevation report of the first shard from stderr
+         *
+         * The wrapper script writes it as the first line before it starts
+         * oscap. Returns true once mShardElevation is known.
+         */
+        bool readShardElevation(QProcess& process);
+        int findShard(QObject* process) const;
+        void mergeShardResults();
+
+        struct Shard
+        {
+            QProcess* process;
+            TemporaryDir* workingDir;
+            /// Arguments of oscap, the program is decided when the shard is started
+            QStringList args;
+            QString resultFile;
+            QString arfFile;
+            QByteArray readBuffer;
+            QString lastRuleID;
+            bool started;
+        };
+
+        enum ShardElevation
+        {
+            SHARD_ELEVATION_UNKNOWN,
+            SHARD_ELEVATION_ELEVATED,
+            SHARD_ELEVATION_UNPRIVILEGED
+        };
+
+        QList<Shard> mShards;
+        int mRunningShards;
+        /// Privileges the first shard runs with, all the others use the same
+        ShardElevation mShardElevation;
+        /// Valid only while evaluateSharded is waiting for the processes
+        QEventLoop* mShardLoop;
+
         void evaluateWithOfflineRemediation();
         void evaluateWithOtherSettings();
-        static void setFilenameToTempFile(QTemporaryFile& file);
 };
 
 #endif
@@ -43,20 +43,52 @@ class OscapScannerRemoteSsh : public OscapScannerBase
         virtual void evaluate();
 
     private:
-        void ensureConnected();
+        /// Quotes input for the POSIX shell on the remote machine
+        static QString shellQuote(const QString& input);
+
+        /**
+         * @brief Builds a shell snippet providing the input file in the working directory
+         *
+         * The input is taken from the remote content cache if cached is true,
+         * otherwise the uploaded input, already extracted in the working
+         * directory, is added to the cache. An empty contentHash bypasses the cache.
+         */
+        static QString buildInputScript(const QString& contentHash, bool cached);
+        /// Builds a shell snippet removing least recently used files over the cache size limit
+        static QString buildCachePruneScript();
 
-        QString copyFileOver(const QString& localPath);
-        QString copyInputFileOver();
+        void ensureConnected();
 
-        QString createRemoteTemporaryFile(bool cancelOnFailure = true);
-        QString createRemoteTemporaryDirectory(bool cancelOnFailure = true);
+        /**
+         * @brief Locates oscap, creates the working directory and queries capabilities
+         *
+         * Also checks whether the input with given hash is in the remote
+         * content cache and whether gzip is available there. All of that is
+         * done in a single SSH round-trip.
+         * Emits an error message and returns false on failure.
+         */
+        bool bootstrapRemoteSession(QString& workingDir, const QString& contentHash, bool& contentCached);
 
-        QString readRemoteFile(const QString& path, const QString& desc);
+        /**
+         * @brief Emits an error message and returns false if the evaluation script failed
+         *
+         * Tells failures to set up the evaluation (working directory, upload
+         * of the input and tailoring) apart from errors of oscap itself.
+         */
+        bool checkEvaluationExitCode(QProcess& process);
 
-        void removeRemoteFile(const QString& path, const QString& desc);
-        void removeRemoteDirectory(const QString& path, const QString& desc);
+        /**
+         * @brief Reads all results back and removes the working directory in one round-trip
+         *
+         * Emits an error message and sets mCancelRequested if any of the
+         * results is missing.
+         */
+        void fetchResultsAndCleanUp(const QString& workingDir);
+        void removeRemoteWorkingDirectory(const QString& workingDir);
 
         SshConnection mSshConnection;
+        /// Set by bootstrapRemoteSession
+        bool mRemoteGzipAvailable;
 };
 
 #endif
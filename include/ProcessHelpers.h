@@ -32,8 +32,13 @@
 /// This class is never exposed, it is internal only
 class ProcessProgressDialog;
 
+class QEventLoop;
+
 /**
  * @brief Runs a process and pumps event queue of given thread
+ *
+ * The event queue is pumped by a local QEventLoop that quits as soon as
+ * the process exits, there is no polling of the process state.
  */
 class SyncProcess : public QObject
 {
@@ -109,14 +114,30 @@ class SyncProcess : public QObject
          */
         void cancel();
 
+    private slots:
+        /// Quits the local event loop if the external cancel request source was set
+        void checkCancelRequest();
+        void readProcessIntoDialog();
+
     public:
         bool isRunning() const;
 
         void setStdInFile(const QString& path);
         const QString& getStdInFile() const;
 
+        /**
+         * @brief Writes stdout of the process to given file instead of memory
+         *
+         * Meant for large outputs, the stdout contents stay empty then.
+         * The file is truncated when the process starts.
+         */
+        void setStdOutFile(const QString& path);
+        const QString& getStdOutFile() const;
+
         int getExitCode() const;
         const QString& getStdOutContents() const;
+        /// Stdout exactly as the process wrote it, use this for binary output
+        const QByteArray& getRawStdOutContents() const;
         const QString& getStdErrContents() const;
         const QString& getDiagnosticInfo() const;
 
@@ -131,12 +152,22 @@ class SyncProcess : public QObject
 
         void readAllChannelsIntoDialog(QProcess& process, ProcessProgressDialog& dialog);
 
+        /**
+         * @brief Pumps the event queue until the process exits or cancel is requested
+         *
+         * If cancel was requested the process is terminated and killed if it
+         * doesn't exit within mTermLimit msec.
+         *
+         * @param dialog if not NULL, output of the process is shown in it as it comes
+         */
+        void waitForProcess(QProcess& process, ProcessProgressDialog* dialog);
+
         QString mCommand;
         QStringList mArguments;
         QProcessEnvironment mEnvironment;
         QString mWorkingDirectory;
 
-        /// How often do we poll for status, in msec
+        /// How often do we check the external cancel request source, in msec
         unsigned int mPollInterval;
         /// How long will we wait for the process to exit after term is signaled, in msec
         unsigned int mTermLimit;
@@ -148,11 +179,22 @@ class SyncProcess : public QObject
         /// Was cancellation requested locally (cancel() slot)
         bool mLocalCancelRequested;
 
+        /// Valid only while waitForProcess is running
+        QProcess* mProcess;
+        ProcessProgressDialog* mDialog;
+        QEventLoop* mEventLoop;
+
         QString mStdInFile;
+        QString mStdOutFile;
         int mExitCode;
-        QString mStdOutContents;
+        QByteArray mRawStdOutContents;
+        /// Decoded from mRawStdOutContents on first use
+        mutable QString mStdOutContents;
+        mutable bool mStdOutDecoded;
         QString mStdErrContents;
-        QString mDiagnosticInfo;
+        /// stdout and stderr are appended on first use
+        mutable QString mDiagnosticInfo;
+        mutable bool mDiagnosticInfoComplete;
 };
 
 #endif
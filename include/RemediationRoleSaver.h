@@ -98,33 +98,33 @@ class PuppetProfileRemediationSaver : public ProfileBasedRemediationSaver
 class ResultBasedProcessRemediationSaver : public RemediationSaverBase
 {
     public:
-        ResultBasedProcessRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents,
+        ResultBasedProcessRemediationSaver(QWidget* parentWindow, const QString& arfPath,
                 const QString& saveMessage, const QString& filetypeExtension, const QString& filetypeTemplate, const QString& fixType);
 
     private:
         virtual void saveToFile(const QString& filename);
-        QTemporaryFile mArfFile;
+        const QString mArfPath;
 };
 
 
 class BashResultRemediationSaver : public ResultBasedProcessRemediationSaver
 {
     public:
-        BashResultRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents);
+        BashResultRemediationSaver(QWidget* parentWindow, const QString& arfPath);
 };
 
 
 class AnsibleResultRemediationSaver : public ResultBasedProcessRemediationSaver
 {
     public:
-        AnsibleResultRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents);
+        AnsibleResultRemediationSaver(QWidget* parentWindow, const QString& arfPath);
 };
 
 
 class PuppetResultRemediationSaver : public ResultBasedProcessRemediationSaver
 {
     public:
-        PuppetResultRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents);
+        PuppetResultRemediationSaver(QWidget* parentWindow, const QString& arfPath);
 };
 
 #else  // i.e. SCAP_WORKBENCH_USE_LIBRARY_FOR_RESULT_BASED_REMEDIATION_ROLES_GENERATION is defined
@@ -133,33 +133,33 @@ class PuppetResultRemediationSaver : public ResultBasedProcessRemediationSaver
 class ResultBasedLibraryRemediationSaver : public RemediationSaverBase
 {
     public:
-        ResultBasedLibraryRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents,
+        ResultBasedLibraryRemediationSaver(QWidget* parentWindow, const QString& arfPath,
                 const QString& saveMessage, const QString& filetypeExtension, const QString& filetypeTemplate, const QString& fixType);
 
     private:
         virtual void saveToFile(const QString& filename);
-        QTemporaryFile mArfFile;
+        const QString mArfPath;
 };
 
 
 class BashResultRemediationSaver : public ResultBasedLibraryRemediationSaver
 {
     public:
-        BashResultRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents);
+        BashResultRemediationSaver(QWidget* parentWindow, const QString& arfPath);
 };
 
 
 class AnsibleResultRemediationSaver : public ResultBasedLibraryRemediationSaver
 {
     public:
-        AnsibleResultRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents);
+        AnsibleResultRemediationSaver(QWidget* parentWindow, const QString& arfPath);
 };
 
 
 class PuppetResultRemediationSaver : public ResultBasedLibraryRemediationSaver
 {
     public:
-        PuppetResultRemediationSaver(QWidget* parentWindow, const QByteArray& arfContents);
+        PuppetResultRemediationSaver(QWidget* parentWindow, const QString& arfPath);
 };
 
 #endif  // SCAP_WORKBENCH_USE_LIBRARY_FOR_RESULT_BASED_REMEDIATION_ROLES_GENERATION
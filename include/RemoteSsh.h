@@ -26,6 +26,9 @@
 #include "ProcessHelpers.h"
 #include "TemporaryDir.h"
 #include <QObject>
+#include <QDateTime>
+#include <QList>
+#include <QMutex>
 
 class SshConnection : public QObject
 {
@@ -46,6 +49,16 @@ class SshConnection : public QObject
 
         void setCancelRequestSource(bool* source);
 
+        /**
+         * @brief Makes the connection use SshConnectionPool
+         *
+         * A pooled connection reuses an existing master connection to the
+         * same target if there is one and hands the master over to the pool
+         * on disconnect instead of closing it. Default is false.
+         */
+        void setPooled(bool pooled);
+        bool isPooled() const;
+
         void connect();
         void disconnect();
         bool isConnected() const;
@@ -62,10 +75,77 @@ class SshConnection : public QObject
         QProcessEnvironment mEnvironment;
 
         bool mConnected;
+        bool mPooled;
 
         bool* mCancelRequestSource;
 };
 
+/**
+ * @brief Keeps SSH master connections alive between scans
+ *
+ * Masters are keyed by target and port. Each master is used by at most one
+ * SshConnection at a time, it is taken out of the pool when acquired and
+ * put back when released. Masters idle for longer than the idle timeout are
+ * closed, ssh itself closes them after the same time (ControlPersist) in
+ * case scap-workbench doesn't get to do it. Every master is checked using
+ * 'ssh -O check' before it is handed out.
+ *
+ * All methods are thread safe, scanners connect from their scan threads.
+ */
+class SshConnectionPool
+{
+    public:
+        static SshConnectionPool& getInstance();
+
+        /**
+         * @brief Sets how long unused masters are kept alive, in seconds
+         *
+         * Only applies to masters created after this call. Default is 10 minutes.
+         */
+        void setIdleTimeout(unsigned int seconds);
+        unsigned int getIdleTimeout() const;
+
+        /**
+         * @brief Takes a working master for given target out of the pool
+         *
+         * @return true if a master was found, ownership of socketDir passes to the caller
+         */
+        bool acquire(const QString& target, unsigned short port, TemporaryDir*& socketDir, QString& masterSocket);
+
+        /**
+         * @brief Puts a master back to the pool, the pool takes ownership of socketDir
+         */
+        void release(const QString& target, unsigned short port, TemporaryDir* socketDir, const QString& masterSocket);
+
+        /**
+         * @brief Closes all masters in the pool
+         *
+         * Masters acquired by connections at the moment are not affected.
+         */
+        void closeAll();
+
+    private:
+        struct Master
+        {
+            QString target;
+            unsigned short port;
+            TemporaryDir* socketDir;
+            QString masterSocket;
+            QDateTime releasedAt;
+        };
+
+        SshConnectionPool();
+        ~SshConnectionPool();
+
+        /// Removes masters idle for too long from the pool, has to be called with mMutex locked
+        QList<Master> takeExpiredMasters();
+        static void closeMaster(const Master& master);
+
+        mutable QMutex mMutex;
+        QList<Master> mMasters;
+        unsigned int mIdleTimeout;
+};
+
 class SshSyncProcess : public SyncProcess
 {
     Q_OBJECT
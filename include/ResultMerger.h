@@ -0,0 +1,216 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+#ifndef SCAP_WORKBENCH_RESULT_MERGER_H_
+#define SCAP_WORKBENCH_RESULT_MERGER_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QMap>
+#include <QPair>
+#include <QByteArray>
+#include <QDateTime>
+
+extern "C"
+{
+#include <xccdf_benchmark.h>
+}
+
+class QIODevice;
+class QXmlStreamReader;
+class QXmlStreamWriter;
+class QXmlStreamAttributes;
+
+/**
+ * @brief Merges results of several evaluations of the same benchmark into one
+ *
+ * Inputs are either all XCCDF result documents or all ARFs, typically from
+ * evaluations limited to a subset of rules (sharded scans, re-runs of failed
+ * rules, partial scans). The first input is the base, the output is a copy of
+ * it with rule-results taken from whichever input takes precedence for each
+ * rule, see Precedence. Rule-results missing in the base are inserted after
+ * its last rule-result. Rules evaluated with multi-check have several
+ * rule-results, all of them are taken from the same input.
+ *
+ * Scores of the TestResult are recomputed from the merged rule-results.
+ * The flat, flat-unweighted and absolute models are exact. The default model
+ * needs weights of groups, it is exact only if setScoringHierarchy was called,
+ * otherwise all rules are treated as direct children of the benchmark.
+ * Every rule-result of a multi-check rule counts in the flat models, in the
+ * default model the rule scores the average of its rule-results.
+ * Scores of unknown scoring systems are kept as they are in the base.
+ *
+ * When merging ARFs, OVAL reports of other inputs are appended to the output
+ * with their IDs made unique, so that check results referenced from the
+ * merged rule-results are available. Relationships of the appended reports
+ * are copied along with them, provided the base has a relationships element.
+ *
+ * All documents are processed with QXmlStreamReader and QXmlStreamWriter,
+ * none of them is loaded into memory as a whole. Only the rule-results and
+ * relationships taken from inputs other than the base are kept in memory.
+ */
+class ResultMerger
+{
+    public:
+        /**
+         * @brief Decides which rule-result wins if several inputs have one for the same rule
+         *
+         * In both cases an evaluated result beats notchecked and notselected.
+         */
+        enum Precedence
+        {
+            /// Result from the input added last wins, for re-runs of rules
+            PRECEDENCE_LATEST,
+            /// The worst result wins (fail, error, unknown, pass, ...), for independent scans
+            PRECEDENCE_STRICTEST
+        };
+
+        ResultMerger();
+        ~ResultMerger();
+
+        /**
+         * @brief Adds a file to merge, the first one added is the base
+         */
+        void addInput(const QString& path);
+        const QStringList& getInputs() const;
+
+        void setPrecedence(Precedence precedence);
+        Precedence getPrecedence() const;
+
+        /**
+         * @brief Takes groups and their weights from the benchmark to compute the default score exactly
+         */
+        void setScoringHierarchy(struct xccdf_benchmark* benchmark);
+
+        /**
+         * @brief Writes the merged document to given open device
+         *
+         * @exception ResultMergerException Any of the inputs can't be read or
+         * parsed or the inputs are results of different benchmarks.
+         */
+        void merge(QIODevice& output);
+
+        /**
+         * @brief Reads IDs and results of all rule-results in an XCCDF result document or ARF
+         *
+         * The document is streamed from given open device, it is not read into memory.
+         *
+         * @exception ResultMergerException The document can't be parsed.
+         */
+        static void getRuleResults(QIODevice& document, QStringList& ruleIDs, QStringList& results);
+
+        /**
+         * @brief Returns IDs of rules that have a failed result in given document, see isFailed
+         *
+         * @exception ResultMergerException The document can't be parsed.
+         */
+        static QStringList getFailedRules(QIODevice& document);
+
+        /// True for fail, error and unknown - results worth re-checking after remediation
+        static bool isFailed(const QString& result);
+
+    private:
+        /// One rule-result of the input that takes precedence for a rule
+        struct RuleResult
+        {
+            /// Index of the input it comes from
+            int input;
+            QString result;
+            /// Weight from the rule-result element, negative if it has none
+            double weight;
+            /// The rule-result element serialized on its own, empty if it comes from the base
+            QByteArray fragment;
+        };
+
+        /// Benchmark, group or rule as far as the default scoring model is concerned
+        struct ScoringItem
+        {
+            QString parentID;
+            double weight;
+        };
+
+        /// All rule-results of a rule from one input, more than one for multi-check rules
+        typedef QList<RuleResult> RuleResults;
+
+        void collectInput(int input);
+        void writeMergedDocument(QXmlStreamReader& reader, QXmlStreamWriter& writer);
+        void writeRemainingRuleResults(QXmlStreamWriter& writer, const QSet<QString>& written) const;
+        void writeScore(QXmlStreamReader& reader, QXmlStreamWriter& writer) const;
+        void writeTestResultStart(const QXmlStreamReader& reader, QXmlStreamWriter& writer) const;
+        void copyOVALReports(int input, QXmlStreamWriter& writer);
+        void writeOVALRelationships(int input, QXmlStreamWriter& writer) const;
+
+        bool takesPrecedence(const QString& candidate, const QString& current) const;
+        /// The result that decides precedence of all rule-results of a rule, the strictest evaluated one
+        static QString combinedResult(const RuleResults& ruleResults);
+        static int resultStrictness(const QString& result);
+        static bool isEvaluated(const QString& result);
+        static bool isCounted(const QString& result);
+        static bool isPassed(const QString& result);
+
+        double getRuleWeight(const QString& ruleID, const RuleResult& ruleResult) const;
+        void computeFlatScore(bool unweighted, double& score, double& maximum) const;
+        double computeDefaultScore() const;
+        bool computeDefaultItemScore(const QString& id, const QMap<QString, QStringList>& children,
+            double& score) const;
+        void addScoringItems(struct xccdf_item* item, const QString& parentID);
+
+        /// Reads the current element including all its children into a standalone fragment
+        static QByteArray captureElement(QXmlStreamReader& reader, QString& result);
+        /// Writes a fragment made by captureElement, hrefs and subjects pointing to OVAL reports of input are adjusted
+        void writeFragment(const QByteArray& fragment, int input, QXmlStreamWriter& writer) const;
+        /// Copies the current element including all its children, the id attribute is replaced if not empty
+        static void copyElement(QXmlStreamReader& reader, QXmlStreamWriter& writer, const QString& id = QString());
+        static void copyCurrentToken(QXmlStreamReader& reader, QXmlStreamWriter& writer);
+        /// Writes start of the current element with its namespace declarations and given attributes
+        static void writeStartElement(const QXmlStreamReader& reader, QXmlStreamWriter& writer,
+            const QXmlStreamAttributes& attributes);
+
+        static bool isXCCDFElement(const QXmlStreamReader& reader, const QString& name);
+        static bool isRuleResult(const QXmlStreamReader& reader);
+        static bool isARFReport(const QXmlStreamReader& reader);
+        QString uniqueReportID(const QString& id, int input) const;
+
+        QStringList mInputs;
+        Precedence mPrecedence;
+
+        QMap<QString, RuleResults> mRuleResults;
+        /// IDs of all rules with a rule-result, in the order they were first seen
+        QStringList mRuleOrder;
+        /// IDs of ARF reports with OVAL results in each input
+        QMap<int, QSet<QString> > mOVALReportIDs;
+        /// Subjects and fragments of ARF relationships in each input but the base
+        QMap<int, QList<QPair<QString, QByteArray> > > mRelationships;
+
+        QString mBenchmarkID;
+        /// Earliest start-time and latest end-time of all TestResults
+        QDateTime mStartTime;
+        QDateTime mEndTime;
+
+        QMap<QString, ScoringItem> mScoringItems;
+        /// ID of the benchmark, empty if there is no scoring hierarchy
+        QString mScoringRootID;
+};
+
+#endif
@@ -23,9 +23,9 @@
 #define SCAP_WORKBENCH_RESULT_VIEWER_H_
 
 #include "ForwardDecls.h"
+#include "ScanArtifacts.h"
 
 #include <QWidget>
-#include <QTemporaryFile>
 #include <QUrl>
 #include <QMenu>
 #include <QLabel>
@@ -56,16 +56,20 @@ class ResultViewer : public QWidget
         void clear();
 
         /**
-         * @brief Loads and keeps results and report in given scanner
+         * @brief Takes over results and report of given scanner
          */
         void loadContent(Scanner* scanner);
 
         /**
-         * @brief Retrieve currently loaded ARF
+         * @brief Hands over currently loaded results, the caller deletes them
          *
          * This can be used to perform offline remediation for example.
+         * Returns 0 if there are no results, the viewer has none afterwards.
          */
-        const QByteArray& getARF() const;
+        ScanArtifacts* takeArtifacts();
+
+        /// Path of the loaded XCCDF results, empty if there are none
+        QString getResultsPath() const;
 
     private slots:
         /// Pops up a save dialog for HTML report
@@ -90,15 +94,21 @@ class ResultViewer : public QWidget
         QAction* mSaveResultsAction;
         QAction* mSaveARFAction;
         QAction* mSaveReportAction;
+        QAction* mSaveRuleTimingsCSVAction;
+        QAction* mSaveRuleTimingsJSONAction;
         QMenu* mSaveMenu;
 
         QString mInputBaseName;
 
-        QByteArray mResults;
-        QByteArray mReport;
-        /// If user requests to open the file via desktop services
-        QTemporaryFile* mReportFile;
-        QByteArray mARF;
+        /// Results of the last scan, 0 if there are none
+        ScanArtifacts* mArtifacts;
+
+        /// Path of the loaded ARF, empty if there is none
+        QString getARFPath() const;
+        /// Copies given artifact to filename, pops up an error message on failure
+        void saveArtifact(ScanArtifacts::Artifact artifact, const QString& filename);
+
+        RuleTimingsDialog* mRuleTimingsDialog;
 };
 
 #endif
@@ -31,6 +31,8 @@ class RuleResultItem : public QWidget
 
     public:
         explicit RuleResultItem(struct xccdf_rule* rule, struct xccdf_policy* policy, QWidget* parent = 0);
+        /// Title and description already made readable, see SessionRuleItem
+        RuleResultItem(const QString& title, const QString& descriptionHTML, QWidget* parent = 0);
         virtual ~RuleResultItem();
 
         void setRuleResult(const QString& result);
@@ -47,6 +49,8 @@ class RuleResultItem : public QWidget
         void showDescriptionToggled(bool checked);
 
     private:
+        void init(const QString& title, const QString& descriptionHTML);
+
         Ui_RuleResultItem mUi;
         QString mDescriptionHTML;
 };
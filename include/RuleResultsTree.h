@@ -24,6 +24,7 @@
 
 #include "ForwardDecls.h"
 #include <QWidget>
+#include <QList>
 
 #include "ui_RuleResultsTree.h"
 
@@ -49,6 +50,8 @@ class RuleResultsTree : public QWidget
          * @param scanningSession Session from which we will determine which rules are selected
          */
         void refreshSelectedRules(ScanningSession* scanningSession);
+        /// Same as above but with rules already gathered, see SessionLoader::buildRuleList
+        void refreshSelectedRules(const QList<SessionRuleItem>& rules);
 
         /**
          * @brief How many rules does RuleResultTree think are selected?
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_RULE_TIMING_MODEL_H_
+#define SCAP_WORKBENCH_RULE_TIMING_MODEL_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+/**
+ * @brief Estimates scan progress from durations of rules measured in previous scans
+ *
+ * Durations of rules vary wildly, a few rules walking the filesystem can take
+ * most of the scan time. Counting evaluated rules is therefore a poor progress
+ * estimate. This model remembers how long each rule took last time for each
+ * benchmark and target (in QSettings) and weighs the rules accordingly.
+ * Rules without history are assumed to take as long as an average known rule.
+ *
+ * The scanner reports when rules start and finish, a rule is assumed to start
+ * right after the previous one finished if its start wasn't reported.
+ */
+class RuleTimingModel
+{
+    public:
+        RuleTimingModel();
+        ~RuleTimingModel();
+
+        /**
+         * @brief Loads history of given benchmark on given target and starts measuring
+         *
+         * @param ruleIDs Rules that are going to be evaluated
+         */
+        void start(const QString& benchmarkID, const QString& target, const QStringList& ruleIDs);
+
+        /**
+         * @brief Stores measured durations, they are merged with the history
+         */
+        void save();
+
+        bool isStarted() const;
+
+        void ruleStarted(const QString& ruleID);
+        void ruleFinished(const QString& ruleID);
+
+        /**
+         * @brief Returns estimated progress of the scan between 0 and 1
+         */
+        double getProgress() const;
+
+        /**
+         * @brief Returns estimated number of seconds until the scan finishes, -1 if unknown
+         */
+        int getRemainingSeconds() const;
+
+        /**
+         * @brief Returns durations of rules finished in this scan, rule ID -> ms
+         */
+        const QHash<QString, qint64>& getMeasuredDurations() const;
+
+    private:
+        qint64 getExpectedDuration(const QString& ruleID) const;
+        static QString settingsKey(const QString& benchmarkID, const QString& target);
+
+        QString mBenchmarkID;
+        QString mTarget;
+
+        /// Rule ID -> duration in ms, from previous scans
+        QHash<QString, qint64> mHistory;
+        /// Rule ID -> duration in ms, from this scan
+        QHash<QString, qint64> mMeasured;
+
+        QSet<QString> mPlannedRules;
+        qint64 mTotalExpected;
+        qint64 mFinishedExpected;
+        qint64 mDefaultDuration;
+
+        /// Rule ID -> timestamp in ms of rules being evaluated right now
+        QHash<QString, qint64> mRunning;
+
+        qint64 mStartTime;
+        qint64 mLastFinishTime;
+};
+
+#endif
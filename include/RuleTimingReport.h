@@ -0,0 +1,92 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_RULE_TIMING_REPORT_H_
+#define SCAP_WORKBENCH_RULE_TIMING_REPORT_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+
+extern "C"
+{
+#include <xccdf_benchmark.h>
+#include <xccdf_policy.h>
+}
+
+/**
+ * @brief Durations of rules and groups measured during one scan, slowest first
+ *
+ * Duration of a group is the sum of durations of all rules inside it,
+ * including rules in nested groups.
+ */
+class RuleTimingReport
+{
+    public:
+        struct Entry
+        {
+            QString id;
+            QString title;
+            /// In milliseconds
+            qint64 duration;
+            /// Number of evaluated rules, 1 for rules
+            int ruleCount;
+        };
+
+        RuleTimingReport();
+        ~RuleTimingReport();
+
+        /**
+         * @param durations Rule ID -> duration in milliseconds, see Scanner::getRuleTimings
+         * @param session Provides titles of rules and groups they belong to, may be NULL
+         */
+        void build(const QHash<QString, qint64>& durations, ScanningSession* session);
+        void clear();
+
+        bool isEmpty() const;
+
+        const QList<Entry>& getRules() const;
+        const QList<Entry>& getGroups() const;
+        /// Sum of durations of all rules
+        qint64 getTotalDuration() const;
+
+        QByteArray toCSV() const;
+        QByteArray toJSON() const;
+
+    private:
+        void addGroups(struct xccdf_item* item, struct xccdf_policy* policy,
+            const QHash<QString, qint64>& durations, QList<int>& groupStack);
+
+        static bool slowerThan(const Entry& a, const Entry& b);
+        static QString csvQuote(const QString& value);
+        static void appendJSONEntries(QString& json, const QList<Entry>& entries, bool groups);
+
+        QList<Entry> mRules;
+        QList<Entry> mGroups;
+        qint64 mTotalDuration;
+};
+
+#endif
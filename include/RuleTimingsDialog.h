@@ -0,0 +1,65 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_RULE_TIMINGS_DIALOG_H_
+#define SCAP_WORKBENCH_RULE_TIMINGS_DIALOG_H_
+
+#include "ForwardDecls.h"
+#include "RuleTimingReport.h"
+
+#include <QDialog>
+
+#include "ui_RuleTimingsDialog.h"
+
+/**
+ * @brief Shows the slowest rules and groups of the last scan in sortable tables
+ */
+class RuleTimingsDialog : public QDialog
+{
+    Q_OBJECT
+
+    public:
+        explicit RuleTimingsDialog(QWidget* parent = 0);
+        virtual ~RuleTimingsDialog();
+
+        /**
+         * @param baseName Used to suggest file names when saving
+         */
+        void setReport(const RuleTimingReport& report, const QString& baseName);
+
+    public slots:
+        /// Pops up a save dialog for the report in CSV
+        void saveCSV();
+        /// Pops up a save dialog for the report in JSON
+        void saveJSON();
+
+    private:
+        void fillTable(QTableWidget* table, const QList<RuleTimingReport::Entry>& entries, bool groups);
+        void saveFile(const QString& caption, const QString& fileName, const QString& filter, const QByteArray& data);
+
+        Ui_RuleTimingsDialog mUI;
+
+        RuleTimingReport mReport;
+        QString mBaseName;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_SCAN_ARTIFACTS_H_
+#define SCAP_WORKBENCH_SCAN_ARTIFACTS_H_
+
+#include "ForwardDecls.h"
+#include "TemporaryDir.h"
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @brief XCCDF results, HTML report and ARF of one scan, kept as files
+ *
+ * Results of large scans can have hundreds of MB, especially ARFs with OVAL
+ * results. They are kept in a private temporary directory and passed around
+ * by path, consumers that only save or open them never read them into memory.
+ *
+ * Scanners write the artifacts directly to the paths returned by getPath
+ * where possible. The directory is removed when this object is destroyed.
+ */
+class ScanArtifacts
+{
+    public:
+        enum Artifact
+        {
+            ARTIFACT_RESULTS,
+            ARTIFACT_REPORT,
+            ARTIFACT_ARF
+        };
+
+        ScanArtifacts();
+        ~ScanArtifacts();
+
+        /**
+         * @brief Path where given artifact is stored, the file may not exist yet
+         *
+         * @exception TemporaryDirException Failed to create the directory
+         */
+        QString getPath(Artifact artifact) const;
+
+        /// Returns true if given artifact exists and isn't empty
+        bool has(Artifact artifact) const;
+        qint64 getSize(Artifact artifact) const;
+
+        /**
+         * @brief Moves given file into this object, the file is copied if it can't be renamed
+         *
+         * @exception ScanArtifactsException Failed to move or copy the file
+         */
+        void adopt(Artifact artifact, const QString& path);
+
+        /**
+         * @brief Replaces given artifact with data
+         *
+         * Meant for data that only exist in memory, prefer writing to getPath.
+         *
+         * @exception ScanArtifactsException Failed to write the file
+         */
+        void write(Artifact artifact, const QByteArray& data);
+
+        /**
+         * @brief Reads whole artifact into memory
+         *
+         * Use only if the contents have to be parsed, returns empty array
+         * if the artifact doesn't exist.
+         */
+        QByteArray read(Artifact artifact) const;
+
+        /**
+         * @brief Copies given artifact to destination, overwriting it
+         *
+         * The file is copied in chunks, it is never fully loaded.
+         *
+         * @exception ScanArtifactsException Failed to read or write
+         */
+        void copyTo(Artifact artifact, const QString& destination) const;
+
+        /// Removes all artifacts
+        void clear();
+
+        /**
+         * @brief Name of the file given artifact is saved as in batch output
+         *
+         * Headless and fleet scans name their outputs the same way,
+         * e.g. "<baseName>-xccdf.report.html".
+         */
+        static QString getOutputFileName(Artifact artifact, const QString& baseName);
+
+    private:
+        // the directory is removed on destruction, copies would remove it twice
+        ScanArtifacts(const ScanArtifacts&);
+        ScanArtifacts& operator=(const ScanArtifacts&);
+
+        TemporaryDir mDir;
+};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_SCAN_TRACE_H_
+#define SCAP_WORKBENCH_SCAN_TRACE_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+/**
+ * @brief Records phases of one scan as spans, written as a Chrome trace-event JSON file
+ *
+ * Tracing is enabled by the SCAP_WORKBENCH_TRACE_DIR environment variable or
+ * the "scan-trace-directory" setting, one file per scan is written into that
+ * directory. The files can be opened in chrome://tracing or Perfetto UI.
+ *
+ * The scanner makes its trace current for the scanning thread, code running
+ * in that thread records spans into it using ScanTrace::Span without knowing
+ * about the scanner. Spans are no-ops if there is no current trace.
+ */
+class ScanTrace
+{
+    public:
+        /// Key/value pairs shown with a span
+        typedef QList<QPair<QString, QString> > Arguments;
+
+        /**
+         * @brief Measures the time between its construction and end() or destruction
+         */
+        class Span
+        {
+            public:
+                explicit Span(const QString& name, const QString& category = "phase");
+                ~Span();
+
+                void setArgument(const QString& key, const QString& value);
+                /// Records the span now instead of in the destructor
+                void end();
+
+            private:
+                ScanTrace* mTrace;
+                QString mName;
+                QString mCategory;
+                qint64 mStart;
+                Arguments mArguments;
+        };
+
+        /**
+         * @brief Creates a trace for a scan of given target if tracing is enabled
+         *
+         * @return NULL if tracing is disabled
+         */
+        static ScanTrace* createIfEnabled(const QString& target);
+
+        ~ScanTrace();
+
+        /// Microseconds since the trace was created
+        qint64 now() const;
+
+        void addSpan(const QString& name, const QString& category, qint64 start, qint64 duration,
+            const Arguments& arguments = Arguments());
+
+        /**
+         * @brief Writes all recorded spans into the trace file
+         *
+         * @return Path of the written file, empty if writing failed
+         */
+        QString write() const;
+
+        /// Makes given trace current for the calling thread, NULL clears it
+        static void setCurrent(ScanTrace* trace);
+        static ScanTrace* getCurrent();
+
+    private:
+        ScanTrace(const QString& directory, const QString& target);
+
+        struct Event
+        {
+            QString name;
+            QString category;
+            qint64 start;
+            qint64 duration;
+            int thread;
+            Arguments arguments;
+        };
+
+        int currentThreadIndex();
+
+        const QString mDirectory;
+        const QString mTarget;
+        const QDateTime mCreated;
+        QElapsedTimer mTimer;
+
+        mutable QMutex mMutex;
+        QList<Event> mEvents;
+        /// Threads get small sequential IDs, the first one is the scanning thread
+        QHash<Qt::HANDLE, int> mThreads;
+};
+
+#endif
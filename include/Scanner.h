@@ -26,6 +26,8 @@
 
 #include <QObject>
 #include <QByteArray>
+#include <QStringList>
+#include <QHash>
 
 extern "C"
 {
@@ -36,7 +38,9 @@ enum ScannerMode
 {
     SM_SCAN,
     SM_SCAN_ONLINE_REMEDIATION,
-    SM_OFFLINE_REMEDIATION
+    SM_OFFLINE_REMEDIATION,
+    /// Evaluates only rules that failed in the previous results and splices the new results into them
+    SM_RESCAN_FAILED
 };
 
 /**
@@ -79,6 +83,15 @@ class Scanner : public QObject
         bool getFetchRemoteResources() const;
         virtual void setSession(ScanningSession* session);
         ScanningSession* getSession() const;
+
+        /**
+         * @brief Sets a tailoring file exported in advance, the scanner only reads it
+         *
+         * Has to be called before setSession. Scanners without it export
+         * the tailoring of the session to a file of their own.
+         */
+        virtual void setTailoringFile(const QString& path);
+        const QString& getTailoringFile() const;
         virtual void setTarget(const QString& target);
         const QString& getTarget() const;
 
@@ -86,31 +99,35 @@ class Scanner : public QObject
         ScannerMode getScannerMode() const;
 
         /**
-         * @brief Retrieves XCCDF results from the scan
+         * @brief Hands over XCCDF results, HTML report and ARF of the scan
+         *
+         * The results are kept as files, see ScanArtifacts. The caller owns
+         * the returned object, the scanner continues with empty artifacts.
          *
-         * @param destination QByteArray that will be filled with XCCDF result
          * @note This will only work after "evaluate()" finished successfully.
          */
-        virtual void getResults(QByteArray& destination) = 0;
+        virtual ScanArtifacts* takeArtifacts() = 0;
 
         /**
-         * @brief Retrieves HTML report from the scan
+         * @brief Retrieves how long evaluation of each rule took
          *
-         * @param destination QByteArray that will be filled with HTML report
-         * @note This will only work after "evaluate()" finished successfully.
+         * @param destination Filled with rule ID -> duration in milliseconds
+         * @note This will only work after "evaluate()" finished.
          */
-        virtual void getReport(QByteArray& destination) = 0;
+        virtual void getRuleTimings(QHash<QString, qint64>& destination) = 0;
 
         /**
-         * @brief Retrieves results in Result DataStream (ARF) format
+         * @brief Takes over results of the previous scan, the scanner deletes them
          *
-         * @param destination QByteArray that will be filled with ARF results
-         * @note This will only work after "evaluate()" finished successfully.
+         * Used in case scanner mode is SM_OFFLINE_REMEDIATION (its ARF is
+         * remediated) or SM_RESCAN_FAILED (its failed rules are re-checked).
+         * The files are used directly, they are never read into memory.
          */
-        virtual void getARF(QByteArray& destination) = 0;
-
-        virtual void setARFForRemediation(const QByteArray& results);
-        const QByteArray& getARFForRemediation() const;
+        virtual void setPreviousArtifacts(ScanArtifacts* artifacts);
+        /// Path of the XCCDF results of the previous scan, empty if there are none
+        QString getPreviousResultsPath() const;
+        /// Path of the ARF of the previous scan, empty if there is none
+        QString getPreviousARFPath() const;
 
         virtual QStringList getCommandLineArgs() const = 0;
 
@@ -154,8 +171,23 @@ class Scanner : public QObject
          * progress. Some of the data returned may be misleading, skewed or downright
          * false! You should use the resulting XCCDF report or ARF results for
          * conclusive results instead of data returned via this signal.
+         *
+         * Carries all the results read at once, ruleIDs and results have
+         * the same length, results[i] belongs to ruleIDs[i]. The result is
+         * "processing" when evaluation of the rule has just started.
+         */
+        void progressReportBatch(const QStringList& ruleIDs, const QStringList& results);
+
+        /**
+         * @brief Estimated progress weighed by durations of rules measured in previous scans
+         *
+         * @param progress Between 0 and 1
+         * @param remainingSeconds Estimated time until the evaluation finishes, -1 if unknown
+         *
+         * Emitted periodically during evaluation, prefer it over counting results
+         * from progressReportBatch once it is emitted.
          */
-        void progressReport(const QString& rule_id, const QString& result);
+        void progressEstimate(double progress, int remainingSeconds);
 
         /**
          * @brief Scanner signals this when it wants to give high-level progress
@@ -209,9 +241,11 @@ class Scanner : public QObject
         ScanningSession* mSession;
         /// Target machine we should be scanning
         QString mTarget;
+        /// Tailoring of the session as a file, empty if the session has no tailoring
+        QString mTailoringFile;
 
-        /// Stores results that will be used in case scanner mode is SM_OFFLINE_REMEDIATION
-        QByteArray mARFForRemediation;
+        /// Results used in case scanner mode is SM_OFFLINE_REMEDIATION or SM_RESCAN_FAILED, 0 if there are none
+        ScanArtifacts* mPreviousArtifacts;
 
         /**
          * A helper method that will signal completion and finish off the thread.
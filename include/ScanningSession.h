@@ -23,6 +23,7 @@
 #define SCAP_WORKBENCH_SCANNING_SESSION_H_
 
 #include "ForwardDecls.h"
+#include "SessionPool.h"
 
 #include <QTemporaryFile>
 #include <QSet>
@@ -45,8 +46,12 @@ class ScanningSession
 
         /**
          * @brief Sets whether openscap validation should be skipped when loading
+         *
+         * Even if validation is not skipped, content known to be valid is not
+         * validated again, see ValidationCache.
          */
         void setSkipValid(bool skipValid);
+        bool getSkipValid() const;
 
         /**
          * @brief Retrieves the internal xccdf_session structure
@@ -60,8 +65,11 @@ class ScanningSession
          *
          * Passed file may be an XCCDF file (any openscap supported version)
          * or source datastream (SDS) file (any openscap supported version)
+         *
+         * @param load If false the content is only loaded by the next reloadSession,
+         *             tailoring can be set up before that without loading twice
          */
-        void openFile(const QString& path);
+        void openFile(const QString& path, bool load = true);
 
         /**
          * @brief Closes currently opened file (if any)
@@ -249,14 +257,16 @@ class ScanningSession
         /**
          * @brief Reloads the session if needed, datastream split is potentially done again
          *
-         * @param forceReload if true, the reload is forced no matter what mSessionDirty is
+         * @param forceReload if true, the reload is forced no matter what mDirtyLayers are
          *
          * The main purpose of this method is to allow to reload the session when
          * parameters that affect "loading" of the session change. These parameters
          * are mainly datastream ID and component ID.
          *
-         * mSessionDirty is automatically set to true whenever crucial parameters of
+         * mDirtyLayers are automatically set whenever crucial parameters of
          * the session change. reloadSession will early out if reload is not necessary.
+         * If only the tailoring file has changed, just the tailoring is loaded and
+         * swapped into the policy model, the benchmark is not parsed again.
          */
         void reloadSession(bool forceReload = false) const;
 
@@ -272,11 +282,42 @@ class ScanningSession
         const struct xccdf_version_info* getXCCDFVersionInfo();
 
     private:
+        /// Parts of the session that have to be loaded again, see reloadSession
+        enum DirtyLayer
+        {
+            /// The input file has to be loaded (and validated) again
+            DIRTY_CONTENT = 1 << 0,
+            /// Only the tailoring file has to be loaded into the policy model
+            DIRTY_TAILORING = 1 << 1
+        };
+
         struct xccdf_benchmark* getXCCDFInputBenchmark();
         void ensureTailoringExists();
 
+        /**
+         * @brief Loads mUserTailoringFile (or no tailoring) into the already loaded policy model
+         *
+         * @return false if the policy model has policies of profiles the new
+         * tailoring would change, nothing is changed then and the session
+         * has to be loaded fully
+         */
+        bool reloadTailoring() const;
+
+        /// Key of the content the session would be loaded with right now
+        SessionPoolKey getPoolKey() const;
+        /**
+         * @brief Puts mSession to mSessionPool if it can be reused, frees it otherwise
+         *
+         * mSession is NULL afterwards.
+         */
+        void releaseSession() const;
+
         /// This is our central point of interaction with openscap
-        struct xccdf_session* mSession;
+        mutable struct xccdf_session* mSession;
+        /// What mSession has been loaded with, not valid if it hasn't been loaded yet
+        mutable SessionPoolKey mLoadedKey;
+        /// Sessions loaded before, reloadSession takes them from here instead of loading
+        mutable SessionPool mSessionPool;
         /// Our own tailoring that may or may not initially be loaded from a file
         mutable struct xccdf_tailoring* mTailoring;
 
@@ -288,8 +329,8 @@ class ScanningSession
         /// Whether or not validation should be skipped
         bool mSkipValid;
 
-        /// If true, the session will be reloaded
-        mutable bool mSessionDirty;
+        /// DirtyLayer flags, the session is reloaded if any are set
+        mutable int mDirtyLayers;
         /// If true, we no longer allow changing tailoring entirely
         /// (loading new file, setting it to load from datastream, ...)
         /// user changes to the tailoring would be lost if we reloaded.
@@ -297,6 +338,10 @@ class ScanningSession
 
         QString mUserTailoringFile;
         QString mUserTailoringCID;
+
+        /// Requested by setDatastreamID and setComponentID, empty if openscap picks them
+        QString mRequestedDatastreamID;
+        QString mRequestedComponentID;
 };
 
 #endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_SCRATCH_SPACE_H_
+#define SCAP_WORKBENCH_SCRATCH_SPACE_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+
+/**
+ * @brief Chooses the directory where scans keep their temporary files
+ *
+ * Results of local scans are written, merged and handed over as files, on
+ * hosts with slow or encrypted /tmp this I/O is a noticeable part of the scan.
+ * A directory on tmpfs is preferred if it has enough free space.
+ *
+ * The directory can be set with the SCAP_WORKBENCH_SCRATCH_DIR environment
+ * variable or the "scratch-directory" setting, for example when the tmpfs
+ * is too small for the results of a scan.
+ */
+class ScratchSpace
+{
+    public:
+        /**
+         * @brief Returns the directory to create temporary directories and files in
+         *
+         * The first usable of: configured directory, $XDG_RUNTIME_DIR, /dev/shm
+         * and the default temporary directory. An unusable configured directory
+         * is reported on stderr the first time it is skipped.
+         */
+        static QString getDirectory();
+
+        /// Returns QTemporaryFile template for a file in the scratch directory
+        static QString getFileTemplate();
+
+    private:
+        ScratchSpace();
+};
+
+#endif
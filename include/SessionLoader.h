@@ -0,0 +1,143 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_SESSION_LOADER_H_
+#define SCAP_WORKBENCH_SESSION_LOADER_H_
+
+#include "ForwardDecls.h"
+#include "SessionMetadataCache.h"
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QAtomicInt>
+
+/**
+ * @brief Opens or reloads a ScanningSession outside of the GUI thread
+ *
+ * Loading a large source datastream (parsing, schema validation and building
+ * the policy model) takes seconds. The loader is moved to a QThread and run
+ * there. Nothing else may touch the session until finished is emitted.
+ *
+ * Cancellation is checked between stages, the libopenscap calls themselves
+ * can't be interrupted. A canceled open closes the file again.
+ *
+ * When opening, SessionMetadataCache is looked up first. On a hit,
+ * metadataLoaded is emitted right away so that the content can be shown
+ * while it loads, and the metadata aren't derived again.
+ */
+class SessionLoader : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Stage
+        {
+            /// Reading the file and detecting its type
+            STAGE_OPEN,
+            /// Parsing and validating the content, building the policy model
+            STAGE_LOAD,
+            /// Counting selected rules of all profiles, gathering the rules shown after opening
+            STAGE_METADATA,
+
+            STAGE_COUNT
+        };
+
+        explicit SessionLoader(ScanningSession* session);
+        virtual ~SessionLoader();
+
+        /**
+         * @brief Makes run open given file first, otherwise the opened file is reloaded
+         *
+         * @param tailoringPath Tailoring file to load with the file, may be empty
+         */
+        void setFileToOpen(const QString& path, const QString& tailoringPath);
+        /// Tailoring file loaded with the opened file, the file itself if openscap found it is a tailoring file
+        const QString& getTailoringPath() const;
+
+        bool wasCanceled() const;
+        bool hasFailed() const;
+        const QString& getErrorMessage() const;
+
+        /**
+         * @brief Metadata of the loaded session, valid after a successful run
+         *
+         * Rules are only gathered when opening a file. If metadataLoaded has
+         * been emitted the metadata can be read right away, they don't change.
+         */
+        const SessionMetadata& getMetadata() const;
+        /// Returns true if the metadata have been read from SessionMetadataCache
+        bool isMetadataCached() const;
+
+        /**
+         * @brief Builds the items of the profile combobox, sorted by profile ID
+         *
+         * The default profile comes last. Selected rules are counted for every
+         * profile, this is the slow part for content with many profiles.
+         */
+        static QList<SessionProfileItem> buildProfileList(ScanningSession* session);
+
+        /// Builds datastream ID and component ID of each checklist of a source datastream
+        static QList<QStringList> buildChecklistList(ScanningSession* session);
+
+        /// Builds rules selected in the session with their readable titles and descriptions
+        static QList<SessionRuleItem> buildRuleList(ScanningSession* session);
+
+    public slots:
+        /// Thread safe, takes effect when the current stage finishes
+        void cancel();
+
+        /**
+         * @brief Loads the session, emits finished when done
+         *
+         * Meant to be invoked once the loader has been moved to its thread,
+         * the loader moves itself back to the thread it was created in.
+         */
+        void run();
+
+    signals:
+        void stageStarted(int stage, const QString& description);
+        /// Emitted from the loader thread on a metadata cache hit, before the session is loaded
+        void metadataLoaded();
+        void finished();
+
+    private:
+        bool startStage(Stage stage, const QString& description);
+        void buildMetadata();
+
+        ScanningSession* mSession;
+        QThread* mMainThread;
+
+        QString mPath;
+        QString mTailoringPath;
+
+        QAtomicInt mCancelRequested;
+        bool mCanceled;
+        QString mErrorMessage;
+
+        /// Key of the opened content in SessionMetadataCache, empty if it isn't cached
+        QString mCacheKey;
+        bool mMetadataCached;
+        SessionMetadata mMetadata;
+};
+
+#endif
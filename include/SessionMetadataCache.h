@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_SESSION_METADATA_CACHE_H_
+#define SCAP_WORKBENCH_SESSION_METADATA_CACHE_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+/// Item of the profile combobox, the default profile has a null ID
+struct SessionProfileItem
+{
+    QString id;
+    QString title;
+};
+
+/// Rule as shown in RuleResultsTree
+struct SessionRuleItem
+{
+    QString id;
+    QString title;
+    QString descriptionHTML;
+};
+
+/**
+ * @brief Everything the main window shows about opened content before any scan
+ */
+struct SessionMetadata
+{
+    QString benchmarkTitle;
+
+    /// Datastream ID and component ID of each checklist, empty if the content isn't a source datastream
+    QList<QStringList> checklists;
+    /// The loaded checklist, see ScanningSession::getDatastreamID
+    QString datastreamID;
+    QString componentID;
+
+    /// Items of the profile combobox, see SessionLoader::buildProfileList
+    QList<SessionProfileItem> profiles;
+
+    /// ID of the profile the rules are selected by, the first profile in profiles
+    QString rulesProfileID;
+    QList<SessionRuleItem> rules;
+};
+
+/**
+ * @brief On-disk cache of SessionMetadata, for fast reopening of the same content
+ *
+ * Deriving the metadata requires a full libopenscap load. With a cache hit the
+ * main window shows the content right away while the load runs in background.
+ *
+ * Entries are keyed by SHA-1 of the content and the checklist, each is a small
+ * binary file in the user's cache directory. Entries written by other versions
+ * of SCAP Workbench or OpenSCAP are ignored. Content opened with a tailoring
+ * file is never cached, profiles and rule selection depend on the tailoring.
+ *
+ * Caching can be turned off with the "metadata-cache" setting.
+ */
+class SessionMetadataCache
+{
+    public:
+        static bool isEnabled();
+
+        /**
+         * @brief Returns the key of given content and checklist, empty if the content can't be read
+         *
+         * Hashes the content, this takes a while for large content opened for the first time.
+         */
+        static QString getKey(const QString& contentPath, const QString& datastreamID, const QString& componentID);
+
+        /// Returns true and fills metadata if a valid entry of given key exists
+        static bool load(const QString& key, SessionMetadata& metadata);
+
+        /**
+         * @brief Stores metadata under given key, least recently stored entries are pruned
+         *
+         * Failures are not reported, the cache is only an optimization.
+         */
+        static void store(const QString& key, const SessionMetadata& metadata);
+
+    private:
+        SessionMetadataCache();
+
+        static QString getDirectory();
+};
+
+#endif
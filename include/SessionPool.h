@@ -0,0 +1,112 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_SESSION_POOL_H_
+#define SCAP_WORKBENCH_SESSION_POOL_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+#include <QList>
+
+extern "C"
+{
+#include <xccdf_session.h>
+}
+
+/**
+ * @brief Everything a loaded xccdf_session depends on
+ *
+ * Datastream and component IDs are the requested ones, empty if openscap
+ * picks them when loading.
+ */
+struct SessionPoolKey
+{
+    SessionPoolKey();
+
+    /// Keys of content that can't be read are not valid, such sessions are not pooled
+    bool isValid() const;
+    bool operator==(const SessionPoolKey& other) const;
+
+    QString contentPath;
+    QString contentHash;
+    QString datastreamID;
+    QString componentID;
+    QString tailoringFile;
+    QString tailoringFileHash;
+    QString tailoringComponentID;
+    bool skipValid;
+};
+
+/**
+ * @brief Loaded sessions kept for switching back to them without loading again
+ *
+ * ScanningSession puts its loaded xccdf_session here instead of freeing it
+ * when it loads another checklist or another file. Switching back is then
+ * instant.
+ *
+ * The pool is bounded by the number of sessions and by their estimated memory,
+ * least recently used sessions are freed first. Memory of a session is estimated
+ * from the size of its input file. The limits can be changed with
+ * the "session-pool-size" and "session-pool-memory" (MiB) settings,
+ * session-pool-size of 0 disables the pool.
+ */
+class SessionPool
+{
+    public:
+        SessionPool();
+        ~SessionPool();
+
+        /**
+         * @brief Removes the session of given key from the pool
+         *
+         * @return the session, the caller takes ownership. NULL if there is none
+         */
+        struct xccdf_session* take(const SessionPoolKey& key);
+
+        /**
+         * @brief Adds a loaded session to the pool, the pool takes ownership
+         *
+         * Sessions over the limits are freed right away.
+         */
+        void put(const SessionPoolKey& key, struct xccdf_session* session);
+
+        /// Frees all pooled sessions
+        void clear();
+
+    private:
+        struct Entry
+        {
+            SessionPoolKey key;
+            struct xccdf_session* session;
+            qint64 estimatedMemory;
+        };
+
+        /// Most recently used first
+        QList<Entry> mEntries;
+        qint64 mEstimatedMemory;
+
+        int mMaxSessions;
+        qint64 mMaxMemory;
+};
+
+#endif
@@ -37,7 +37,11 @@
 class TemporaryDir
 {
     public:
-        TemporaryDir();
+        /**
+         * @param parentDirectory Directory to create the temporary directory in,
+         *                        the default temporary directory if empty
+         */
+        explicit TemporaryDir(const QString& parentDirectory = QString());
         ~TemporaryDir();
 
         /**
@@ -65,6 +69,8 @@ class TemporaryDir
          */
         void ensurePath() const;
 
+        /// Created temporary directory is a subdirectory of this, see TemporaryDir::TemporaryDir
+        QString mParentDirectory;
         /// Holds absolute path of the created temporary directory
         mutable QString mPath;
         /// @see TemporaryDir::setAutoRemove
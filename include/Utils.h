@@ -115,4 +115,23 @@ void openUrlGuarded(const QUrl& url);
  */
 const QString& getSetSidPath();
 
+/**
+ * @brief Returns given string quoted and escaped as a JSON string literal
+ *
+ * @exception nothrow This function is guaranteed to not throw any exceptions.
+ */
+QString jsonQuote(const QString& value);
+
+/**
+ * @brief Returns hex encoded SHA-1 of given file, empty string if it can't be read
+ *
+ * Hashes are remembered for the lifetime of the process, the file is
+ * hashed again only if its size, modification or change time or its inode
+ * changes. Pass remembered = false where a stale hash must never be used,
+ * the file is then always read.
+ *
+ * @note This function is thread safe.
+ */
+QString computeFileHash(const QString& path, bool remembered = true);
+
 #endif
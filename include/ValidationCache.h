@@ -0,0 +1,72 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#ifndef SCAP_WORKBENCH_VALIDATION_CACHE_H_
+#define SCAP_WORKBENCH_VALIDATION_CACHE_H_
+
+#include "ForwardDecls.h"
+
+#include <QString>
+
+/**
+ * @brief Remembers content that passed schema and schematron validation
+ *
+ * Validation is a big part of every xccdf_session_load and the session is
+ * reloaded whenever the checklist or the tailoring changes. Content that has
+ * already been validated is loaded without validation.
+ *
+ * Keys are derived from SHA-1 of the content and the tailoring file, the selected
+ * checklist and the OpenSCAP version. Modified content therefore always gets
+ * validated again. Each known valid key is an empty file in the user's cache
+ * directory.
+ *
+ * Caching can be turned off with the "validation-cache" setting.
+ */
+class ValidationCache
+{
+    public:
+        static bool isEnabled();
+
+        /**
+         * @brief Returns the key of given content, empty if any of the files can't be read
+         *
+         * @param tailoringPath tailoring file loaded with the content, may be empty
+         */
+        static QString getKey(const QString& contentPath, const QString& tailoringPath,
+            const QString& datastreamID, const QString& componentID, const QString& tailoringComponentID);
+
+        static bool isKnownValid(const QString& key);
+
+        /**
+         * @brief Remembers that content of given key has passed validation
+         *
+         * Failures are not reported, the cache is only an optimization.
+         */
+        static void markValid(const QString& key);
+
+    private:
+        ValidationCache();
+
+        static QString getDirectory();
+};
+
+#endif
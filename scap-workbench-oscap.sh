@@ -30,17 +30,39 @@ shift
 wrapper_gid=$1
 shift
 
+report_elevation=0
+if [ "${1:-}" == "--report-elevation" ]; then
+    report_elevation=1
+    shift
+fi
+
 real_uid=`id -u`
 real_gid=`id -g`
 
-TEMP_DIR=`mktemp -d`
+# pkexec may have been dismissed, in that case we run as the user
+elevated=0
+if [ $wrapper_uid -ne $real_uid ] || [ $wrapper_gid -ne $real_gid ]; then
+    elevated=1
+fi
+
+# scap-workbench runs the rest of a sharded scan with the same privileges
+if [ $report_elevation -eq 1 ]; then
+    echo "scap-workbench-elevated: $elevated" 1>&2
+fi
+
+# Prefer tmpfs for the results, they are moved to their targets afterwards.
+# That is a rename when the targets are on the same filesystem.
+TEMP_DIR=""
+[ ! -d /dev/shm ] || TEMP_DIR=`mktemp -d -p /dev/shm 2> /dev/null`
+[ -n "$TEMP_DIR" ] || TEMP_DIR=`mktemp -d`
 
 args=("$@")
 
-# We have to rewrite result targets to a priv temp dir. We will later
-# chown that dir to the target uid:gid and copy things where they belong
-# using permissions of that user ONLY!
+# When elevated, we have to rewrite result targets to a priv temp dir. We will
+# later chown the results to the target uid:gid and move them where they belong.
+# Without elevation oscap writes the targets directly, there is nothing to move.
 for i in $(seq 0 `expr $# - 1`); do
+    [ $elevated -eq 1 ] || break
     let j=i+1
 
     case "${args[i]}" in
@@ -84,22 +106,24 @@ RET=$?
 
 popd > /dev/null
 
-function chown_copy
+function chown_move
 {
     local what="$1"
     local where="$2"
 
-    [ ! -f "$what" ] || cp "$what" "$where"
+    [ -f "$what" ] || return 0
 
-    # chown only required if wrapper_{uid,gid} differs from real_{uid,gid}
-    if [ $wrapper_uid -ne $real_uid ] || [ $wrapper_gid -ne $real_gid ]; then
-        chown $wrapper_uid:$wrapper_gid $where
-    fi
+    # chown while the file is still in our private dir, the target
+    # directory belongs to the user
+    chown $wrapper_uid:$wrapper_gid "$what"
+    mv -f "$what" "$where"
 }
 
-chown_copy "$TEMP_DIR/results-xccdf.xml" "$TARGET_RESULTS_XCCDF"
-chown_copy "$TEMP_DIR/results-arf.xml" "$TARGET_RESULTS_ARF"
-chown_copy "$TEMP_DIR/report.html" "$TARGET_REPORT"
+if [ $elevated -eq 1 ]; then
+    chown_move "$TEMP_DIR/results-xccdf.xml" "${TARGET_RESULTS_XCCDF:-}"
+    chown_move "$TEMP_DIR/results-arf.xml" "${TARGET_RESULTS_ARF:-}"
+    chown_move "$TEMP_DIR/report.html" "${TARGET_REPORT:-}"
+fi
 
 rm -r "$TEMP_DIR"
 
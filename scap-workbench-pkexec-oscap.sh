@@ -26,10 +26,31 @@ PARENT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
 PKEXEC_PATH="pkexec"
 SCAP_WORKBENCH_OSCAP="$PARENT_DIR/scap-workbench-oscap.sh"
 
+# Options of scap-workbench precede the oscap arguments:
+# --report-elevation   makes scap-workbench-oscap.sh report whether it runs elevated
+# --require-elevation  fail with 126 instead of running unprivileged
+report_elevation=""
+require_elevation=0
+while [ $# -gt 0 ]; do
+    case "$1" in
+    ("--report-elevation")
+        report_elevation="$1"
+        shift
+      ;;
+    ("--require-elevation")
+        require_elevation=1
+        shift
+      ;;
+    *)
+        break
+      ;;
+    esac
+done
+
 # We run unprivileged if pkexec was not found.
 #which $PKEXEC_PATH > /dev/null || exit 1 # fail if pkexec was not found
 
-$PKEXEC_PATH --disable-internal-agent "$SCAP_WORKBENCH_OSCAP" $uid $gid "$@" 2> >(tail -n +2 1>&2)
+$PKEXEC_PATH --disable-internal-agent "$SCAP_WORKBENCH_OSCAP" $uid $gid $report_elevation "$@" 2> >(tail -n +2 1>&2)
 EC=$?
 
 # 126 is a special exit code of pkexec when user dismisses the auth dialog
@@ -37,8 +58,14 @@ EC=$?
 # We will retry with 127 because pkexec returns 127 when no polkit auth agent is present.
 # This is common in niche desktop environments.
 if [ $EC -eq 126 ] || [ $EC -eq 127 ]; then
+    # other oscap processes of the same scan run elevated, this one must not run without it
+    if [ $require_elevation -eq 1 ]; then
+        echo "Failed to elevate privileges, oscap has not been run." 1>&2
+        exit 126
+    fi
+
     # in case of dismissed dialog we run without super user rights
-    "$SCAP_WORKBENCH_OSCAP" $uid $gid "$@" 2> >(tail -n +2 1>&2);
+    "$SCAP_WORKBENCH_OSCAP" $uid $gid $report_elevation "$@" 2> >(tail -n +2 1>&2);
     exit $?
 fi
 
@@ -76,3 +76,27 @@ QString oscapErrGetFullError()
     free(fullErrorCstr);
     return fullError;
 }
+
+void gatherAllSelectedRules(struct xccdf_policy* policy, struct xccdf_item* current,
+    std::vector<struct xccdf_rule*>& result)
+{
+    if (xccdf_item_get_type(current) == XCCDF_RULE)
+    {
+        struct xccdf_rule* rule = xccdf_item_to_rule(current);
+        const bool selected = xccdf_policy_is_item_selected(policy, xccdf_rule_get_id(rule));
+
+        if (selected)
+            result.push_back(rule);
+    }
+    else if (xccdf_item_get_type(current) == XCCDF_BENCHMARK ||
+        xccdf_item_get_type(current) == XCCDF_GROUP)
+    {
+        struct xccdf_item_iterator* it = xccdf_item_get_content(current);
+        while (xccdf_item_iterator_has_more(it))
+        {
+            struct xccdf_item* item = xccdf_item_iterator_next(it);
+            gatherAllSelectedRules(policy, item, result);
+        }
+        xccdf_item_iterator_free(it);
+    }
+}
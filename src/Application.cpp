@@ -21,19 +21,26 @@
 
 #include "Application.h"
 #include "MainWindow.h"
+#include "HeadlessScan.h"
+#include "RemoteSsh.h"
 #include "Utils.h"
 
 #include <QFileInfo>
 #include <QTranslator>
+#include <QTimer>
 
 #include <iostream>
+#include <cstring>
 
 Application::Application(int& argc, char** argv):
-    QApplication(argc, argv),
+    QApplication(argc, argv, !headlessRequested(argc, argv)),
 
     mShouldQuit(false),
+    mExitCode(0),
+    mHeadless(headlessRequested(argc, argv)),
     mTranslator(),
-    mMainWindow(0)
+    mMainWindow(0),
+    mHeadlessScan(0)
 {
     setOrganizationName("SCAP Workbench upstream");
     setOrganizationDomain("https://www.open-scap.org/tools/scap-workbench");
@@ -41,6 +48,23 @@ Application::Application(int& argc, char** argv):
     setApplicationName("SCAP Workbench");
     setApplicationVersion(SCAP_WORKBENCH_VERSION);
 
+    if (mHeadless)
+    {
+        // No widgets, icons or translations of the GUI are needed, the scan
+        // starts as soon as the event loop is entered.
+        mHeadlessScan = new HeadlessScan(this);
+
+        QStringList args = arguments();
+        processCLI(args);
+
+        if (mShouldQuit)
+            QTimer::singleShot(0, this, SLOT(quitWithExitCode()));
+        else
+            QTimer::singleShot(0, mHeadlessScan, SLOT(start()));
+
+        return;
+    }
+
     mMainWindow = new MainWindow();
 
 #if (QT_VERSION >= QT_VERSION_CHECK(4, 8, 0))
@@ -76,6 +100,21 @@ Application::Application(int& argc, char** argv):
 Application::~Application()
 {
     delete mMainWindow;
+    delete mHeadlessScan;
+
+    // all scanners are gone by now, their connections were handed over to the pool
+    SshConnectionPool::getInstance().closeAll();
+}
+
+bool Application::headlessRequested(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+            return true;
+    }
+
+    return false;
 }
 
 void Application::processCLI(QStringList& args)
@@ -94,9 +133,16 @@ void Application::processCLI(QStringList& args)
         return;
     }
 
+    // already taken into account when constructing the application
+    args.removeAll("--headless");
+
     if (args.contains("--skip-valid"))
     {
-        mMainWindow->setSkipValid(true);
+        if (mHeadless)
+            mHeadlessScan->setSkipValid(true);
+        else
+            mMainWindow->setSkipValid(true);
+
         args.removeAll("--skip-valid");
     }
 
@@ -110,6 +156,7 @@ void Application::processCLI(QStringList& args)
             std::cout << "--tailoring should be followed by the tailoring file path" << std::endl;
             printHelp();
             mShouldQuit = true;
+            mExitCode = 1;
         }
         else
         {
@@ -119,6 +166,12 @@ void Application::processCLI(QStringList& args)
         }
     }
 
+    if (mHeadless)
+    {
+        processHeadlessCLI(args, tailoringFile);
+        return;
+    }
+
     if (args.length() > 1)
     {
         QStringList unknownOptions = args.filter(QRegExp("^-{1,2}.*"));
@@ -144,6 +197,99 @@ void Application::processCLI(QStringList& args)
     }
 }
 
+void Application::processHeadlessCLI(QStringList& args, const QString& tailoringFile)
+{
+    if (mShouldQuit)
+        return;
+
+    QString profile;
+    QString target("localhost");
+    QString outputDirectory(".");
+
+    if (!takeOptionValue(args, "--profile", profile) ||
+        !takeOptionValue(args, "--target", target) ||
+        !takeOptionValue(args, "--output-dir", outputDirectory))
+    {
+        return;
+    }
+
+    // --profile may be repeated, the other profiles are evaluated in the same pass
+    QStringList additionalProfiles;
+    while (args.contains("--profile"))
+    {
+        QString additionalProfile;
+        if (!takeOptionValue(args, "--profile", additionalProfile))
+            return;
+
+        additionalProfiles.append(additionalProfile);
+    }
+
+    if (args.contains("--fetch-remote-resources"))
+    {
+        mHeadlessScan->setFetchRemoteResources(true);
+        args.removeAll("--fetch-remote-resources");
+    }
+
+    if (args.contains("--remediate"))
+    {
+        mHeadlessScan->setOnlineRemediation(true);
+        args.removeAll("--remediate");
+    }
+
+    const QStringList unknownOptions = args.filter(QRegExp("^-{1,2}.*"));
+    if (!unknownOptions.isEmpty())
+    {
+        QString unknownOption = QString("Unknown option '%1'\n").arg(unknownOptions.first());
+        std::cout << unknownOption.toUtf8().constData();
+        printHelp();
+        mShouldQuit = true;
+        mExitCode = 1;
+        return;
+    }
+
+    if (args.length() <= 1)
+    {
+        std::cout << "--headless requires an XCCDF or SDS file to evaluate" << std::endl;
+        printHelp();
+        mShouldQuit = true;
+        mExitCode = 1;
+        return;
+    }
+
+    mHeadlessScan->setInputFile(args.last());
+    mHeadlessScan->setTailoringFile(tailoringFile);
+    mHeadlessScan->setProfile(profile);
+    mHeadlessScan->setAdditionalProfiles(additionalProfiles);
+    mHeadlessScan->setTarget(target);
+    mHeadlessScan->setOutputDirectory(outputDirectory);
+}
+
+bool Application::takeOptionValue(QStringList& args, const QString& option, QString& value)
+{
+    const int index = args.indexOf(option);
+    if (index == -1)
+        return true;
+
+    if (index + 1 >= args.length())
+    {
+        std::cout << QString("%1 should be followed by a value").arg(option).toUtf8().constData() << std::endl;
+        printHelp();
+        mShouldQuit = true;
+        mExitCode = 1;
+        return false;
+    }
+
+    value = args.at(index + 1);
+    args.removeAt(index + 1);
+    args.removeAt(index);
+    return true;
+}
+
+void Application::quitWithExitCode()
+{
+    exit(mExitCode);
+}
+
 void Application::openSSG()
 {
     mMainWindow->openSSGDialog(QObject::tr("Close SCAP Workbench"));
@@ -169,6 +315,14 @@ void Application::printHelp()
             "   -V, --version\r\t\t\t\t Displays version information.\n"
             "   --skip-valid\r\t\t\t\t Skips OpenSCAP validation.\n"
             "   --tailoring TAILORING_FILE\r\t\t\t\t Opens given tailoring file after the given XCCDF or SDS file is loaded.\n"
+            "\nHeadless mode:\n"
+            "   --headless\r\t\t\t\t Evaluates given file without any GUI and exits.\n"
+            "   --profile PROFILE_ID\r\t\t\t\t Profile to evaluate, (default) profile is used if omitted.\n"
+            "   \r\t\t\t\t Can be repeated to evaluate several profiles of localhost in one pass.\n"
+            "   --target TARGET\r\t\t\t\t localhost (default) or username@hostname[:port] to scan over SSH.\n"
+            "   --output-dir DIRECTORY\r\t\t\t\t Where XCCDF results, HTML report and ARF are written, current directory by default.\n"
+            "   --fetch-remote-resources\r\t\t\t\t Allows oscap to download remote OVAL content.\n"
+            "   --remediate\r\t\t\t\t Runs online remediation during the scan.\n"
             "\nArguments:\n"
             "   file\r\t\t\t\t A file to load, can be an XCCDF or SDS file.\n");
 
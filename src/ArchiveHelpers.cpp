@@ -0,0 +1,341 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+#include "ArchiveHelpers.h"
+#include "Exceptions.h"
+
+#include <QIODevice>
+#include <QFile>
+#include <QDateTime>
+
+#include <cstring>
+
+#ifdef SCAP_WORKBENCH_ZLIB_FOUND
+#include <zlib.h>
+#endif
+
+// Layout of the tar header block, offsets are the same for ustar and GNU tar
+static const int TAR_BLOCK_SIZE = 512;
+static const int TAR_NAME_OFFSET = 0;
+static const int TAR_NAME_LENGTH = 100;
+static const int TAR_MODE_OFFSET = 100;
+static const int TAR_UID_OFFSET = 108;
+static const int TAR_GID_OFFSET = 116;
+static const int TAR_SIZE_OFFSET = 124;
+static const int TAR_SIZE_LENGTH = 12;
+static const int TAR_MTIME_OFFSET = 136;
+static const int TAR_CHECKSUM_OFFSET = 148;
+static const int TAR_CHECKSUM_LENGTH = 8;
+static const int TAR_TYPEFLAG_OFFSET = 156;
+static const int TAR_MAGIC_OFFSET = 257;
+
+bool isGzipSupported()
+{
+#ifdef SCAP_WORKBENCH_ZLIB_FOUND
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool isGzipCompressed(const QByteArray& data)
+{
+    return data.size() >= 2 &&
+        static_cast<unsigned char>(data.at(0)) == 0x1f &&
+        static_cast<unsigned char>(data.at(1)) == 0x8b;
+}
+
+void gzipDecompress(QIODevice& input, QIODevice& output)
+{
+#ifdef SCAP_WORKBENCH_ZLIB_FOUND
+    static const int CHUNK_SIZE = 256 * 1024;
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // 16 + MAX_WBITS makes zlib expect the gzip header and trailer
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+        throw ArchiveHelpersException("Failed to initialize zlib!");
+
+    QByteArray inputChunk(CHUNK_SIZE, '\0');
+    QByteArray outputChunk(CHUNK_SIZE, '\0');
+    int status = Z_OK;
+
+    while (status != Z_STREAM_END)
+    {
+        const qint64 read = input.read(inputChunk.data(), inputChunk.size());
+        if (read < 0)
+        {
+            inflateEnd(&stream);
+            throw ArchiveHelpersException(QString("Failed to read data to decompress: %1").arg(input.errorString()));
+        }
+
+        if (read == 0)
+        {
+            inflateEnd(&stream);
+            throw ArchiveHelpersException("Failed to decompress gzip data: unexpected end of data");
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(inputChunk.data());
+        stream.avail_in = static_cast<uInt>(read);
+
+        // inflate until all input of this chunk is consumed
+        do
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(outputChunk.data());
+            stream.avail_out = outputChunk.size();
+
+            status = inflate(&stream, Z_NO_FLUSH);
+
+            // Z_BUF_ERROR only means that no progress was possible, more input is needed
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+            {
+                const QString reason = stream.msg ? QString::fromLatin1(stream.msg) : QString("corrupted data");
+                inflateEnd(&stream);
+                throw ArchiveHelpersException(QString("Failed to decompress gzip data: %1").arg(reason));
+            }
+
+            const qint64 produced = outputChunk.size() - stream.avail_out;
+            if (output.write(outputChunk.constData(), produced) != produced)
+            {
+                inflateEnd(&stream);
+                throw ArchiveHelpersException(QString("Failed to write decompressed data: %1").arg(output.errorString()));
+            }
+        }
+        while (stream.avail_out == 0 && status != Z_STREAM_END);
+    }
+
+    inflateEnd(&stream);
+#else
+    (void)input;
+    (void)output;
+    throw ArchiveHelpersException("Can't decompress gzip data, scap-workbench was built without zlib!");
+#endif
+}
+
+void gzipCompress(QIODevice& input, QIODevice& output)
+{
+#ifdef SCAP_WORKBENCH_ZLIB_FOUND
+    static const int CHUNK_SIZE = 256 * 1024;
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    // 16 + MAX_WBITS makes zlib write the gzip header and trailer
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw ArchiveHelpersException("Failed to initialize zlib!");
+
+    QByteArray inputChunk(CHUNK_SIZE, '\0');
+    QByteArray outputChunk(CHUNK_SIZE, '\0');
+    int flush = Z_NO_FLUSH;
+
+    do
+    {
+        const qint64 read = input.read(inputChunk.data(), inputChunk.size());
+        if (read < 0)
+        {
+            deflateEnd(&stream);
+            throw ArchiveHelpersException(QString("Failed to read data to compress: %1").arg(input.errorString()));
+        }
+
+        // a short read doesn't have to mean the end for sequential devices
+        flush = read == 0 || input.atEnd() ? Z_FINISH : Z_NO_FLUSH;
+        stream.next_in = reinterpret_cast<Bytef*>(inputChunk.data());
+        stream.avail_in = static_cast<uInt>(read);
+
+        // deflate until all input of this chunk is consumed
+        do
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(outputChunk.data());
+            stream.avail_out = outputChunk.size();
+
+            deflate(&stream, flush);
+
+            const qint64 produced = outputChunk.size() - stream.avail_out;
+            if (output.write(outputChunk.constData(), produced) != produced)
+            {
+                deflateEnd(&stream);
+                throw ArchiveHelpersException(QString("Failed to write compressed data: %1").arg(output.errorString()));
+            }
+        }
+        while (stream.avail_out == 0);
+    }
+    while (flush != Z_FINISH);
+
+    deflateEnd(&stream);
+#else
+    (void)input;
+    (void)output;
+    throw ArchiveHelpersException("Can't compress gzip data, scap-workbench was built without zlib!");
+#endif
+}
+
+/// Reads exactly size bytes into data, returns false at the end of input
+static bool readTarData(QIODevice& input, char* data, qint64 size)
+{
+    qint64 done = 0;
+    while (done < size)
+    {
+        const qint64 read = input.read(data + done, size - done);
+        if (read <= 0)
+            return false;
+
+        done += read;
+    }
+
+    return true;
+}
+
+void extractTarArchive(QIODevice& archive, const QMap<QString, QString>& destinations, QStringList& extracted)
+{
+    // a multiple of the block size, padding of the data is read with them
+    static const int CHUNK_SIZE = 256 * 1024;
+
+    QByteArray header(TAR_BLOCK_SIZE, '\0');
+    QByteArray chunk(CHUNK_SIZE, '\0');
+
+    while (readTarData(archive, header.data(), TAR_BLOCK_SIZE))
+    {
+        const char* data = header.constData();
+
+        // The archive ends with (at least) two zero blocks, an empty name is enough to detect that
+        if (data[TAR_NAME_OFFSET] == '\0')
+            return;
+
+        QString name = QString::fromUtf8(data + TAR_NAME_OFFSET, qstrnlen(data + TAR_NAME_OFFSET, TAR_NAME_LENGTH));
+        if (name.startsWith("./"))
+            name = name.mid(2);
+
+        bool ok = false;
+        const QByteArray sizeField(data + TAR_SIZE_OFFSET, qstrnlen(data + TAR_SIZE_OFFSET, TAR_SIZE_LENGTH));
+        const qint64 size = static_cast<qint64>(sizeField.trimmed().toULongLong(&ok, 8));
+
+        if (!ok || size < 0)
+            throw ArchiveHelpersException(QString("Corrupted tar archive, entry '%1' can't be read!").arg(name));
+
+        // '0' and '\0' (pre-POSIX tar) denote regular files
+        const char typeFlag = data[TAR_TYPEFLAG_OFFSET];
+        const bool wanted = (typeFlag == '0' || typeFlag == '\0') && destinations.contains(name);
+
+        QFile file;
+        if (wanted)
+        {
+            file.setFileName(destinations.value(name));
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+                throw ArchiveHelpersException(QString("Failed to open '%1' for writing!").arg(file.fileName()));
+        }
+
+        // data are padded to whole blocks
+        qint64 remaining = (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+        qint64 dataRemaining = size;
+        while (remaining > 0)
+        {
+            const qint64 toRead = qMin<qint64>(CHUNK_SIZE, remaining);
+            if (!readTarData(archive, chunk.data(), toRead))
+                throw ArchiveHelpersException(QString("Truncated tar archive, entry '%1' can't be read!").arg(name));
+
+            const qint64 toWrite = qMin(toRead, dataRemaining);
+            if (wanted && file.write(chunk.constData(), toWrite) != toWrite)
+                throw ArchiveHelpersException(QString("Failed to write '%1': %2").arg(file.fileName()).arg(file.errorString()));
+
+            remaining -= toRead;
+            dataRemaining -= toWrite;
+        }
+
+        if (wanted)
+        {
+            file.close();
+            extracted.append(name);
+        }
+    }
+
+    throw ArchiveHelpersException("Truncated tar archive, end of archive marker is missing!");
+}
+
+/// Writes value as a zero padded octal number of length - 1 digits followed by NUL
+static void writeTarNumber(char* field, int length, qulonglong value)
+{
+    const QByteArray digits = QByteArray::number(value, 8).rightJustified(length - 1, '0');
+    memcpy(field, digits.constData(), length - 1);
+    field[length - 1] = '\0';
+}
+
+void writeTarArchive(const QMap<QString, QString>& files, QIODevice& output)
+{
+    static const int CHUNK_SIZE = 256 * 1024;
+    const QByteArray zeroBlock(TAR_BLOCK_SIZE, '\0');
+
+    for (QMap<QString, QString>::const_iterator it = files.constBegin(); it != files.constEnd(); ++it)
+    {
+        const QByteArray name = it.key().toUtf8();
+        if (name.isEmpty() || name.size() >= TAR_NAME_LENGTH)
+            throw ArchiveHelpersException(QString("Name '%1' can't be stored in a tar archive!").arg(it.key()));
+
+        QFile file(it.value());
+        if (!file.open(QIODevice::ReadOnly))
+            throw ArchiveHelpersException(QString("Failed to open '%1' for reading!").arg(it.value()));
+
+        const qint64 size = file.size();
+
+        QByteArray header(TAR_BLOCK_SIZE, '\0');
+        char* data = header.data();
+        memcpy(data + TAR_NAME_OFFSET, name.constData(), name.size());
+        writeTarNumber(data + TAR_MODE_OFFSET, 8, 0644);
+        writeTarNumber(data + TAR_UID_OFFSET, 8, 0);
+        writeTarNumber(data + TAR_GID_OFFSET, 8, 0);
+        writeTarNumber(data + TAR_SIZE_OFFSET, TAR_SIZE_LENGTH, size);
+        writeTarNumber(data + TAR_MTIME_OFFSET, 12, QDateTime::currentDateTime().toTime_t());
+        data[TAR_TYPEFLAG_OFFSET] = '0';
+        memcpy(data + TAR_MAGIC_OFFSET, "ustar\0" "00", 8);
+
+        // the checksum is computed with the checksum field filled with spaces
+        memset(data + TAR_CHECKSUM_OFFSET, ' ', TAR_CHECKSUM_LENGTH);
+        unsigned int checksum = 0;
+        for (int i = 0; i < TAR_BLOCK_SIZE; ++i)
+            checksum += static_cast<unsigned char>(data[i]);
+        writeTarNumber(data + TAR_CHECKSUM_OFFSET, TAR_CHECKSUM_LENGTH - 1, checksum);
+
+        if (output.write(header) != TAR_BLOCK_SIZE)
+            throw ArchiveHelpersException(QString("Failed to write tar archive: %1").arg(output.errorString()));
+
+        qint64 copied = 0;
+        while (copied < size)
+        {
+            const QByteArray chunk = file.read(qMin<qint64>(CHUNK_SIZE, size - copied));
+            if (chunk.isEmpty())
+                throw ArchiveHelpersException(QString("Failed to read '%1', it has changed while being archived!").arg(it.value()));
+
+            if (output.write(chunk) != chunk.size())
+                throw ArchiveHelpersException(QString("Failed to write tar archive: %1").arg(output.errorString()));
+
+            copied += chunk.size();
+        }
+
+        // data are padded to whole blocks
+        const int padding = static_cast<int>((TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE);
+        if (output.write(zeroBlock.constData(), padding) != padding)
+            throw ArchiveHelpersException(QString("Failed to write tar archive: %1").arg(output.errorString()));
+    }
+
+    // end of archive marker
+    if (output.write(zeroBlock) != TAR_BLOCK_SIZE || output.write(zeroBlock) != TAR_BLOCK_SIZE)
+        throw ArchiveHelpersException(QString("Failed to write tar archive: %1").arg(output.errorString()));
+}
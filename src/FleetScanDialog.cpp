@@ -0,0 +1,314 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "FleetScanDialog.h"
+#include "DiagnosticsDialog.h"
+
+#include <QCloseEvent>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSettings>
+#include <algorithm>
+
+FleetScanDialog::FleetScanDialog(ScanningSession* session, QWidget* parent):
+    QDialog(parent),
+
+    mQSettings(new QSettings(this)),
+    mScheduler(new FleetScanScheduler(this))
+{
+    mUI.setupUi(this);
+
+    mScheduler->setSession(session);
+
+    QObject::connect(
+        mUI.startButton, SIGNAL(clicked()),
+        this, SLOT(startScan())
+    );
+    QObject::connect(
+        mUI.cancelButton, SIGNAL(clicked()),
+        this, SLOT(cancelScan())
+    );
+    QObject::connect(
+        mUI.closeButton, SIGNAL(clicked()),
+        this, SLOT(close())
+    );
+    QObject::connect(
+        mUI.browseButton, SIGNAL(clicked()),
+        this, SLOT(browseOutputDirectory())
+    );
+
+    QObject::connect(
+        mScheduler, SIGNAL(targetStarted(QString)),
+        this, SLOT(targetStarted(QString))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(targetProgressReportBatch(QString,QStringList,QStringList)),
+        this, SLOT(targetProgressReportBatch(QString,QStringList,QStringList))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(targetInfoMessage(QString,QString)),
+        this, SLOT(targetInfoMessage(QString,QString))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(targetWarningMessage(QString,QString)),
+        this, SLOT(targetWarningMessage(QString,QString))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(targetErrorMessage(QString,QString)),
+        this, SLOT(targetErrorMessage(QString,QString))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(targetEnded(QString,FleetScanScheduler::TargetState)),
+        this, SLOT(targetEnded(QString,FleetScanScheduler::TargetState))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(fleetProgress(unsigned int,unsigned int)),
+        this, SLOT(fleetProgress(unsigned int,unsigned int))
+    );
+    QObject::connect(
+        mScheduler, SIGNAL(fleetFinished()),
+        this, SLOT(fleetFinished())
+    );
+
+    syncFromQSettings();
+}
+
+FleetScanDialog::~FleetScanDialog()
+{
+    delete mScheduler;
+    delete mQSettings;
+}
+
+void FleetScanDialog::setSkipValid(bool skip)
+{
+    mScheduler->setSkipValid(skip);
+}
+
+void FleetScanDialog::setFetchRemoteResources(bool fetch)
+{
+    mScheduler->setFetchRemoteResources(fetch);
+}
+
+void FleetScanDialog::closeEvent(QCloseEvent* event)
+{
+    if (mScheduler->isRunning())
+    {
+        if (QMessageBox::question(this, QObject::tr("Cancel fleet scan in progress?"),
+            QObject::tr("Some targets are still being scanned. Are you sure you want to cancel the scans?"),
+            QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::No)
+        {
+            event->ignore();
+            return;
+        }
+
+        mScheduler->cancel();
+    }
+
+    QDialog::closeEvent(event);
+}
+
+void FleetScanDialog::reject()
+{
+    // Escape key goes through reject, route it through closeEvent
+    close();
+}
+
+QStringList FleetScanDialog::parseTargets() const
+{
+    QStringList ret;
+
+    const QStringList lines = mUI.targetsEdit->toPlainText().split('\n', QString::SkipEmptyParts);
+    for (QStringList::const_iterator it = lines.constBegin(); it != lines.constEnd(); ++it)
+    {
+        const QString line = it->trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        // OscapScannerRemoteSsh::splitTarget expects the port to always be there
+        if (line.contains(':'))
+            ret.append(line);
+        else
+            ret.append(QString("%1:22").arg(line));
+    }
+
+    return ret;
+}
+
+void FleetScanDialog::setScanningUIState(bool scanning)
+{
+    mUI.settings->setEnabled(!scanning);
+    mUI.startButton->setEnabled(!scanning);
+    mUI.cancelButton->setEnabled(scanning);
+}
+
+void FleetScanDialog::startScan()
+{
+    const QStringList targets = parseTargets();
+    if (targets.isEmpty())
+    {
+        QMessageBox::warning(this, QObject::tr("No targets"),
+            QObject::tr("Please enter at least one target to scan."));
+        return;
+    }
+
+    if (mUI.outputDirectoryEdit->text().isEmpty())
+    {
+        QMessageBox::warning(this, QObject::tr("No output directory"),
+            QObject::tr("Please select a directory where results of the scans will be saved."));
+        return;
+    }
+
+    syncToQSettings();
+
+    mUI.targetsTree->clear();
+    mTargetItems.clear();
+    mEvaluatedRules.clear();
+    mLastRuleIDs.clear();
+
+    for (QStringList::const_iterator it = targets.constBegin(); it != targets.constEnd(); ++it)
+    {
+        QTreeWidgetItem* item = new QTreeWidgetItem(mUI.targetsTree);
+        item->setText(0, *it);
+        item->setText(1, FleetScanScheduler::targetStateToString(FleetScanScheduler::TS_QUEUED));
+        item->setText(2, "0");
+        mTargetItems[*it] = item;
+    }
+
+    mUI.fleetProgressBar->setRange(0, targets.size());
+    mUI.fleetProgressBar->setValue(0);
+
+    mScheduler->setTargets(targets);
+    mScheduler->setMaxConcurrency(mUI.concurrencySpinBox->value());
+    mScheduler->setTargetTimeout(mUI.timeoutSpinBox->value());
+    mScheduler->setOutputDirectory(mUI.outputDirectoryEdit->text());
+
+    setScanningUIState(true);
+    mScheduler->start();
+}
+
+void FleetScanDialog::cancelScan()
+{
+    mUI.cancelButton->setEnabled(false);
+    mScheduler->cancel();
+}
+
+void FleetScanDialog::browseOutputDirectory()
+{
+    const QString dir = QFileDialog::getExistingDirectory(this,
+        QObject::tr("Select directory for results of the scans"),
+        mUI.outputDirectoryEdit->text());
+
+    if (!dir.isEmpty())
+        mUI.outputDirectoryEdit->setText(dir);
+}
+
+void FleetScanDialog::targetStarted(const QString& target)
+{
+    QTreeWidgetItem* item = mTargetItems.value(target);
+    if (item)
+        item->setText(1, FleetScanScheduler::targetStateToString(FleetScanScheduler::TS_RUNNING));
+}
+
+void FleetScanDialog::targetProgressReportBatch(const QString& target, const QStringList& ruleIDs, const QStringList& results)
+{
+    QString lastRuleID = mLastRuleIDs.value(target);
+    unsigned int evaluated = mEvaluatedRules.value(target);
+
+    for (int i = 0; i < ruleIDs.size(); ++i)
+    {
+        // multi check produces several results for one rule, they come in a row
+        if (results.at(i) == "processing" || lastRuleID == ruleIDs.at(i))
+            continue;
+
+        lastRuleID = ruleIDs.at(i);
+        ++evaluated;
+    }
+
+    mLastRuleIDs[target] = lastRuleID;
+    mEvaluatedRules[target] = evaluated;
+
+    QTreeWidgetItem* item = mTargetItems.value(target);
+    if (item)
+        item->setText(2, QString::number(evaluated));
+}
+
+void FleetScanDialog::targetInfoMessage(const QString& target, const QString& message)
+{
+    QTreeWidgetItem* item = mTargetItems.value(target);
+    if (item)
+        item->setText(3, message);
+}
+
+void FleetScanDialog::targetWarningMessage(const QString& target, const QString& message)
+{
+    QTreeWidgetItem* item = mTargetItems.value(target);
+    if (item)
+        item->setText(3, message);
+
+    // not using warningMessage, it would pop the dialog up for every target
+    if (globalDiagnosticsDialog)
+        globalDiagnosticsDialog->infoMessage(QString("%1: %2").arg(target).arg(message));
+}
+
+void FleetScanDialog::targetErrorMessage(const QString& target, const QString& message)
+{
+    QTreeWidgetItem* item = mTargetItems.value(target);
+    if (item)
+        item->setText(3, message);
+
+    if (globalDiagnosticsDialog)
+        globalDiagnosticsDialog->infoMessage(QString("%1: %2").arg(target).arg(message));
+}
+
+void FleetScanDialog::targetEnded(const QString& target, FleetScanScheduler::TargetState state)
+{
+    QTreeWidgetItem* item = mTargetItems.value(target);
+    if (item)
+        item->setText(1, FleetScanScheduler::targetStateToString(state));
+}
+
+void FleetScanDialog::fleetProgress(unsigned int done, unsigned int total)
+{
+    mUI.fleetProgressBar->setRange(0, std::max(1u, total));
+    mUI.fleetProgressBar->setValue(done);
+}
+
+void FleetScanDialog::fleetFinished()
+{
+    setScanningUIState(false);
+}
+
+void FleetScanDialog::syncFromQSettings()
+{
+    mUI.targetsEdit->setPlainText(mQSettings->value("fleet-scan-targets").toStringList().join("\n"));
+    mUI.concurrencySpinBox->setValue(mQSettings->value("fleet-scan-concurrency", 4).toInt());
+    mUI.timeoutSpinBox->setValue(mQSettings->value("fleet-scan-timeout", 0).toInt());
+    mUI.outputDirectoryEdit->setText(mQSettings->value("fleet-scan-output-directory").toString());
+}
+
+void FleetScanDialog::syncToQSettings()
+{
+    mQSettings->setValue("fleet-scan-targets", QVariant(parseTargets()));
+    mQSettings->setValue("fleet-scan-concurrency", mUI.concurrencySpinBox->value());
+    mQSettings->setValue("fleet-scan-timeout", mUI.timeoutSpinBox->value());
+    mQSettings->setValue("fleet-scan-output-directory", mUI.outputDirectoryEdit->text());
+}
@@ -0,0 +1,512 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "FleetScanScheduler.h"
+#include "OscapScannerRemoteSsh.h"
+#include "RuleTimingReport.h"
+#include "ScanArtifacts.h"
+#include "ScanningSession.h"
+#include "ScratchSpace.h"
+#include "Exceptions.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <cassert>
+#include <algorithm>
+
+FleetScanScheduler::FleetScanScheduler(QObject* parent):
+    QObject(parent),
+
+    mSession(0),
+    mMaxConcurrency(4),
+    mTargetTimeout(0),
+    mScannerMode(SM_SCAN),
+    mSkipValid(false),
+    mFetchRemoteResources(false),
+
+    mDoneCount(0)
+{}
+
+FleetScanScheduler::~FleetScanScheduler()
+{
+    cancel();
+
+    // we have to wait for the scanners to wind down, they reference the session
+    while (!mActive.isEmpty())
+    {
+        Scanner* scanner = mActive.begin().key();
+        ActiveScan scan = mActive.take(scanner);
+
+        scan.thread->wait();
+        delete scanner;
+        delete scan.thread;
+    }
+}
+
+void FleetScanScheduler::setSession(ScanningSession* session)
+{
+    assert(!isRunning());
+    mSession = session;
+}
+
+void FleetScanScheduler::setTargets(const QStringList& targets)
+{
+    assert(!isRunning());
+    mTargets = targets;
+    mTargets.removeDuplicates();
+}
+
+const QStringList& FleetScanScheduler::getTargets() const
+{
+    return mTargets;
+}
+
+void FleetScanScheduler::setMaxConcurrency(unsigned int maxConcurrency)
+{
+    mMaxConcurrency = std::max(1u, maxConcurrency);
+}
+
+unsigned int FleetScanScheduler::getMaxConcurrency() const
+{
+    return mMaxConcurrency;
+}
+
+void FleetScanScheduler::setTargetTimeout(unsigned int seconds)
+{
+    mTargetTimeout = seconds;
+}
+
+unsigned int FleetScanScheduler::getTargetTimeout() const
+{
+    return mTargetTimeout;
+}
+
+void FleetScanScheduler::setOutputDirectory(const QString& dir)
+{
+    mOutputDirectory = dir;
+}
+
+const QString& FleetScanScheduler::getOutputDirectory() const
+{
+    return mOutputDirectory;
+}
+
+void FleetScanScheduler::setScannerMode(ScannerMode mode)
+{
+    mScannerMode = mode;
+}
+
+void FleetScanScheduler::setSkipValid(bool skip)
+{
+    mSkipValid = skip;
+}
+
+void FleetScanScheduler::setFetchRemoteResources(bool fetch)
+{
+    mFetchRemoteResources = fetch;
+}
+
+bool FleetScanScheduler::isRunning() const
+{
+    return !mQueue.isEmpty() || !mActive.isEmpty();
+}
+
+FleetScanScheduler::TargetState FleetScanScheduler::getTargetState(const QString& target) const
+{
+    return mStates.value(target, TS_QUEUED);
+}
+
+QString FleetScanScheduler::targetStateToString(TargetState state)
+{
+    switch (state)
+    {
+        case TS_QUEUED:
+            return QObject::tr("Queued");
+        case TS_RUNNING:
+            return QObject::tr("Scanning");
+        case TS_FINISHED:
+            return QObject::tr("Finished");
+        case TS_FINISHED_WITH_ERRORS:
+            return QObject::tr("Finished with errors");
+        case TS_FAILED:
+            return QObject::tr("Failed");
+        case TS_CANCELED:
+            return QObject::tr("Canceled");
+        case TS_TIMED_OUT:
+            return QObject::tr("Timed out");
+        default:
+            return QObject::tr("Unknown");
+    }
+}
+
+QString FleetScanScheduler::targetToFileName(const QString& target)
+{
+    QString ret = target;
+    for (int i = 0; i < ret.size(); ++i)
+    {
+        const QChar c = ret.at(i);
+        if (!c.isLetterOrNumber() && c != '.' && c != '-' && c != '_' && c != '@')
+            ret[i] = '_';
+    }
+
+    return ret;
+}
+
+void FleetScanScheduler::start()
+{
+    assert(!isRunning());
+    assert(mSession);
+
+    mStates.clear();
+    mDoneCount = 0;
+    mQueue = mTargets;
+
+    for (QStringList::const_iterator it = mTargets.constBegin(); it != mTargets.constEnd(); ++it)
+        mStates[*it] = TS_QUEUED;
+
+    if (!mOutputDirectory.isEmpty())
+        QDir().mkpath(mOutputDirectory);
+
+    emit fleetProgress(0, mTargets.size());
+
+    try
+    {
+        exportTailoring();
+    }
+    catch (const std::exception& e)
+    {
+        // without the tailoring no target can be scanned the way the user wants
+        while (!mQueue.isEmpty())
+        {
+            const QString target = mQueue.takeFirst();
+            mStates[target] = TS_FAILED;
+            ++mDoneCount;
+
+            emit targetErrorMessage(target,
+                QObject::tr("Failed to export the tailoring. Details follow:\n%1").arg(QString::fromUtf8(e.what())));
+            emit targetEnded(target, TS_FAILED);
+        }
+    }
+
+    if (mTargets.isEmpty())
+    {
+        emit fleetFinished();
+        return;
+    }
+
+    startQueuedTargets();
+}
+
+void FleetScanScheduler::cancel()
+{
+    while (!mQueue.isEmpty())
+    {
+        const QString target = mQueue.takeFirst();
+        mStates[target] = TS_CANCELED;
+        ++mDoneCount;
+
+        emit targetEnded(target, TS_CANCELED);
+    }
+
+    for (QMap<Scanner*, ActiveScan>::iterator it = mActive.begin(); it != mActive.end(); ++it)
+    {
+        // queued so that the cancel gets delivered in the scanner's thread,
+        // the scanner pumps its event queue while evaluating
+        QMetaObject::invokeMethod(it.key(), "cancel", Qt::QueuedConnection);
+    }
+}
+
+void FleetScanScheduler::exportTailoring()
+{
+    mTailoringFile.close();
+    mTailoringFilePath = QString();
+
+    if (!mSession->hasTailoring())
+        return;
+
+    // all the scanners upload the same file, it must not be written to
+    // while any of them are running so we export it exactly once here
+    mTailoringFile.setFileTemplate(ScratchSpace::getFileTemplate());
+    if (!mTailoringFile.open())
+        throw FleetScanSchedulerException(
+            QString("Failed to create a temporary file for the tailoring. %1").arg(mTailoringFile.errorString()));
+    mTailoringFile.close();
+
+    mSession->saveTailoring(mTailoringFile.fileName(), false);
+    mTailoringFilePath = mTailoringFile.fileName();
+}
+
+void FleetScanScheduler::startQueuedTargets()
+{
+    while (!mQueue.isEmpty() && static_cast<unsigned int>(mActive.size()) < mMaxConcurrency)
+        startTarget(mQueue.takeFirst());
+
+    if (mActive.isEmpty() && mQueue.isEmpty())
+    {
+        emit fleetProgress(mDoneCount, mTargets.size());
+        emit fleetFinished();
+    }
+}
+
+void FleetScanScheduler::startTarget(const QString& target)
+{
+    QThread* thread = new QThread(this);
+    Scanner* scanner = new OscapScannerRemoteSsh();
+
+    try
+    {
+        scanner->setTarget(target);
+        scanner->setScanThread(thread);
+        scanner->setMainThread(this->thread());
+        scanner->setSkipValid(mSkipValid);
+        scanner->setFetchRemoteResources(mFetchRemoteResources);
+        if (!mTailoringFilePath.isEmpty())
+            scanner->setTailoringFile(mTailoringFilePath);
+        scanner->setSession(mSession);
+        scanner->setScannerMode(mScannerMode);
+    }
+    catch (const std::exception& e)
+    {
+        delete scanner;
+        delete thread;
+
+        emit targetErrorMessage(target,
+            QObject::tr("There was a problem setting up the scanner. Details follow:\n%1").arg(QString::fromUtf8(e.what())));
+
+        mStates[target] = TS_FAILED;
+        ++mDoneCount;
+        emit targetEnded(target, TS_FAILED);
+        emit fleetProgress(mDoneCount, mTargets.size());
+        return;
+    }
+
+    QObject::connect(
+        scanner, SIGNAL(progressReportBatch(QStringList,QStringList)),
+        this, SLOT(scannerProgressReportBatch(QStringList,QStringList))
+    );
+    QObject::connect(
+        scanner, SIGNAL(infoMessage(QString)),
+        this, SLOT(scannerInfoMessage(QString))
+    );
+    QObject::connect(
+        scanner, SIGNAL(warningMessage(QString)),
+        this, SLOT(scannerWarningMessage(QString))
+    );
+    QObject::connect(
+        scanner, SIGNAL(errorMessage(QString)),
+        this, SLOT(scannerErrorMessage(QString))
+    );
+    QObject::connect(
+        scanner, SIGNAL(canceled()),
+        this, SLOT(scannerCanceled())
+    );
+    QObject::connect(
+        scanner, SIGNAL(finished()),
+        this, SLOT(scannerFinished())
+    );
+
+    ActiveScan scan;
+    scan.target = target;
+    scan.thread = thread;
+    scan.timeoutTimer = 0;
+    scan.timedOut = false;
+    scan.hadErrors = false;
+
+    if (mTargetTimeout > 0)
+    {
+        scan.timeoutTimer = new QTimer(this);
+        scan.timeoutTimer->setSingleShot(true);
+        scan.timeoutTimer->setInterval(mTargetTimeout * 1000);
+        scan.timeoutTimer->setProperty("target", target);
+
+        QObject::connect(
+            scan.timeoutTimer, SIGNAL(timeout()),
+            this, SLOT(targetTimedOut())
+        );
+    }
+
+    mActive.insert(scanner, scan);
+    mStates[target] = TS_RUNNING;
+
+    scanner->moveToThread(thread);
+    QObject::connect(
+        thread, SIGNAL(started()),
+        scanner, SLOT(evaluateExceptionGuard())
+    );
+
+    emit targetStarted(target);
+
+    thread->start();
+    if (scan.timeoutTimer)
+        scan.timeoutTimer->start();
+}
+
+void FleetScanScheduler::endTarget(Scanner* scanner, bool canceled)
+{
+    if (!mActive.contains(scanner))
+        return;
+
+    ActiveScan scan = mActive.take(scanner);
+
+    // The scanner moves itself back to our thread before quitting the scan
+    // thread, after the wait it is safe to touch it from here.
+    scan.thread->wait();
+    delete scan.thread;
+    delete scan.timeoutTimer;
+
+    // the state follows how the scan ended, results of a finished scan are saved
+    // even if errors were reported on the way
+    TargetState state;
+    if (scan.timedOut)
+        state = TS_TIMED_OUT;
+    else if (canceled)
+        state = scan.hadErrors ? TS_FAILED : TS_CANCELED;
+    else
+        state = scan.hadErrors ? TS_FINISHED_WITH_ERRORS : TS_FINISHED;
+
+    if (!canceled)
+        saveTargetResults(scanner, scan.target);
+
+    delete scanner;
+
+    mStates[scan.target] = state;
+    ++mDoneCount;
+
+    emit targetEnded(scan.target, state);
+    emit fleetProgress(mDoneCount, mTargets.size());
+
+    startQueuedTargets();
+}
+
+void FleetScanScheduler::saveTargetResults(Scanner* scanner, const QString& target)
+{
+    if (mOutputDirectory.isEmpty())
+        return;
+
+    const QDir dir(mOutputDirectory);
+    const QString prefix = targetToFileName(target);
+
+    ScanArtifacts* artifacts = scanner->takeArtifacts();
+    struct
+    {
+        ScanArtifacts::Artifact artifact;
+        const char* warning;
+    } outputs[] = {
+        {ScanArtifacts::ARTIFACT_RESULTS, QT_TR_NOOP("Failed to write XCCDF results to '%1'.")},
+        {ScanArtifacts::ARTIFACT_REPORT, QT_TR_NOOP("Failed to write HTML report to '%1'.")},
+        {ScanArtifacts::ARTIFACT_ARF, QT_TR_NOOP("Failed to write Result DataStream (ARF) to '%1'.")}
+    };
+
+    // named like the outputs of headless scans
+    for (unsigned int i = 0; i < sizeof(outputs) / sizeof(outputs[0]); ++i)
+    {
+        const QString fileName = dir.absoluteFilePath(ScanArtifacts::getOutputFileName(outputs[i].artifact, prefix));
+        try
+        {
+            artifacts->copyTo(outputs[i].artifact, fileName);
+        }
+        catch (const ScanArtifactsException&)
+        {
+            emit targetWarningMessage(target, QObject::tr(outputs[i].warning).arg(fileName));
+        }
+    }
+    delete artifacts;
+
+    QByteArray data;
+    QHash<QString, qint64> ruleTimings;
+    scanner->getRuleTimings(ruleTimings);
+    RuleTimingReport ruleTimingReport;
+    ruleTimingReport.build(ruleTimings, scanner->getSession());
+
+    data = ruleTimingReport.toCSV();
+    QFile timingsFile(dir.absoluteFilePath(prefix + "-rule-timings.csv"));
+    if (!timingsFile.open(QIODevice::WriteOnly) || timingsFile.write(data) != data.size())
+        emit targetWarningMessage(target, QObject::tr("Failed to write rule timings to '%1'.").arg(timingsFile.fileName()));
+    timingsFile.close();
+
+    data = ruleTimingReport.toJSON();
+    QFile timingsJSONFile(dir.absoluteFilePath(prefix + "-rule-timings.json"));
+    if (!timingsJSONFile.open(QIODevice::WriteOnly) || timingsJSONFile.write(data) != data.size())
+        emit targetWarningMessage(target, QObject::tr("Failed to write rule timings to '%1'.").arg(timingsJSONFile.fileName()));
+    timingsJSONFile.close();
+}
+
+QString FleetScanScheduler::senderTarget() const
+{
+    Scanner* scanner = qobject_cast<Scanner*>(sender());
+    return mActive.value(scanner).target;
+}
+
+void FleetScanScheduler::scannerProgressReportBatch(const QStringList& ruleIDs, const QStringList& results)
+{
+    // one queued call per batch, fleets of many targets would flood the GUI thread otherwise
+    emit targetProgressReportBatch(senderTarget(), ruleIDs, results);
+}
+
+void FleetScanScheduler::scannerInfoMessage(const QString& message)
+{
+    emit targetInfoMessage(senderTarget(), message);
+}
+
+void FleetScanScheduler::scannerWarningMessage(const QString& message)
+{
+    emit targetWarningMessage(senderTarget(), message);
+}
+
+void FleetScanScheduler::scannerErrorMessage(const QString& message)
+{
+    Scanner* scanner = qobject_cast<Scanner*>(sender());
+    QMap<Scanner*, ActiveScan>::iterator it = mActive.find(scanner);
+    if (it != mActive.end())
+        it->hadErrors = true;
+
+    emit targetErrorMessage(senderTarget(), message);
+}
+
+void FleetScanScheduler::scannerCanceled()
+{
+    endTarget(qobject_cast<Scanner*>(sender()), true);
+}
+
+void FleetScanScheduler::scannerFinished()
+{
+    endTarget(qobject_cast<Scanner*>(sender()), false);
+}
+
+void FleetScanScheduler::targetTimedOut()
+{
+    const QString target = sender()->property("target").toString();
+
+    for (QMap<Scanner*, ActiveScan>::iterator it = mActive.begin(); it != mActive.end(); ++it)
+    {
+        if (it->target != target)
+            continue;
+
+        it->timedOut = true;
+        emit targetWarningMessage(target,
+            QObject::tr("Scanning took longer than %1 seconds, canceling.").arg(mTargetTimeout));
+        QMetaObject::invokeMethod(it.key(), "cancel", Qt::QueuedConnection);
+        break;
+    }
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "HeadlessScan.h"
+#include "OscapScannerLocal.h"
+#include "OscapScannerInProcess.h"
+#include "OscapScannerRemoteSsh.h"
+#include "ScanningSession.h"
+#include "RuleTimingReport.h"
+#include "ScanArtifacts.h"
+#include "Exceptions.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+
+#include <iostream>
+#include <stdexcept>
+
+HeadlessScan::HeadlessScan(QObject* parent):
+    QObject(parent),
+
+    mSkipValid(false),
+    mFetchRemoteResources(false),
+    mOnlineRemediation(false),
+
+    mTarget("localhost"),
+    mOutputDirectory("."),
+
+    mScanningSession(0),
+    mScanThread(0),
+    mScanner(0)
+{}
+
+HeadlessScan::~HeadlessScan()
+{
+    if (mScanThread)
+    {
+        mScanThread->wait();
+        delete mScanThread;
+    }
+
+    delete mScanner;
+    delete mScanningSession;
+}
+
+void HeadlessScan::setSkipValid(bool skipValid)
+{
+    mSkipValid = skipValid;
+}
+
+void HeadlessScan::setFetchRemoteResources(bool fetch)
+{
+    mFetchRemoteResources = fetch;
+}
+
+void HeadlessScan::setOnlineRemediation(bool remediate)
+{
+    mOnlineRemediation = remediate;
+}
+
+void HeadlessScan::setInputFile(const QString& path)
+{
+    mInputFile = path;
+}
+
+void HeadlessScan::setTailoringFile(const QString& path)
+{
+    mTailoringFile = path;
+}
+
+void HeadlessScan::setProfile(const QString& profileID)
+{
+    mProfile = profileID;
+}
+
+void HeadlessScan::setAdditionalProfiles(const QStringList& profileIDs)
+{
+    mAdditionalProfiles = profileIDs;
+}
+
+void HeadlessScan::setTarget(const QString& target)
+{
+    mTarget = target;
+}
+
+void HeadlessScan::setOutputDirectory(const QString& dir)
+{
+    mOutputDirectory = dir;
+}
+
+void HeadlessScan::start()
+{
+    mScanningSession = new ScanningSession();
+    mScanningSession->setSkipValid(mSkipValid);
+
+    try
+    {
+        mScanningSession->openFile(mInputFile);
+        if (!mTailoringFile.isEmpty())
+            mScanningSession->setTailoringFile(mTailoringFile);
+
+        // empty profile ID selects the (default) profile
+        mScanningSession->setProfile(mProfile);
+    }
+    catch (const std::exception& e)
+    {
+        scanErrorMessage(QObject::tr("Failed to load content '%1'. Details follow:\n%2")
+            .arg(mInputFile).arg(QString::fromUtf8(e.what())));
+        exitWith(1);
+        return;
+    }
+
+    if (!QDir().mkpath(mOutputDirectory))
+    {
+        scanErrorMessage(QObject::tr("Failed to create output directory '%1'.").arg(mOutputDirectory));
+        exitWith(1);
+        return;
+    }
+
+    QString target = mTarget;
+    mScanThread = new QThread(this);
+
+    try
+    {
+        const ScannerMode scannerMode = mOnlineRemediation ? SM_SCAN_ONLINE_REMEDIATION : SM_SCAN;
+
+        if (!mAdditionalProfiles.isEmpty())
+        {
+            // only the in-process scanner shares one policy model between profiles
+            if (target != "localhost" || !OscapScannerInProcess::supports(scannerMode, mFetchRemoteResources))
+                throw std::runtime_error("Several profiles can only be evaluated on localhost, "
+                    "without remediation and without fetching remote resources");
+
+            OscapScannerInProcess* scanner = new OscapScannerInProcess();
+            scanner->setAdditionalProfiles(mAdditionalProfiles);
+            mScanner = scanner;
+        }
+        else if (target == "localhost" && OscapScannerInProcess::isEnabled() &&
+            OscapScannerInProcess::supports(scannerMode, mFetchRemoteResources))
+        {
+            mScanner = new OscapScannerInProcess();
+        }
+        else if (target == "localhost")
+        {
+#ifdef SCAP_WORKBENCH_LOCAL_SCAN_ENABLED
+            mScanner = new OscapScannerLocal();
+#else
+            throw std::runtime_error("SCAP Workbench was compiled without local scanning support");
+#endif
+        }
+        else
+        {
+#ifdef SCAP_WORKBENCH_LOCAL_SSH_FOUND
+            // OscapScannerRemoteSsh::splitTarget expects the port to always be there
+            if (!target.contains(':'))
+                target += ":22";
+
+            mScanner = new OscapScannerRemoteSsh();
+#else
+            throw std::runtime_error("SCAP Workbench was compiled without remote scanning support");
+#endif
+        }
+
+        mScanner->setTarget(target);
+        mScanner->setScanThread(mScanThread);
+        mScanner->setMainThread(thread());
+        mScanner->setSkipValid(mSkipValid);
+        mScanner->setFetchRemoteResources(mFetchRemoteResources);
+        mScanner->setSession(mScanningSession);
+        mScanner->setScannerMode(scannerMode);
+    }
+    catch (const std::exception& e)
+    {
+        scanErrorMessage(QObject::tr("There was a problem setting up the scanner. Details follow:\n%1")
+            .arg(QString::fromUtf8(e.what())));
+        exitWith(1);
+        return;
+    }
+
+    QObject::connect(
+        mScanner, SIGNAL(infoMessage(QString)),
+        this, SLOT(scanInfoMessage(QString))
+    );
+    QObject::connect(
+        mScanner, SIGNAL(warningMessage(QString)),
+        this, SLOT(scanWarningMessage(QString))
+    );
+    QObject::connect(
+        mScanner, SIGNAL(errorMessage(QString)),
+        this, SLOT(scanErrorMessage(QString))
+    );
+    QObject::connect(
+        mScanner, SIGNAL(canceled()),
+        this, SLOT(scanCanceled())
+    );
+    QObject::connect(
+        mScanner, SIGNAL(finished()),
+        this, SLOT(scanFinished())
+    );
+
+    mScanner->moveToThread(mScanThread);
+    QObject::connect(
+        mScanThread, SIGNAL(started()),
+        mScanner, SLOT(evaluateExceptionGuard())
+    );
+
+    mScanThread->start();
+}
+
+void HeadlessScan::scanInfoMessage(const QString& message)
+{
+    std::cout << message.toUtf8().constData() << std::endl;
+}
+
+void HeadlessScan::scanWarningMessage(const QString& message)
+{
+    std::cerr << QObject::tr("Warning: %1").arg(message).toUtf8().constData() << std::endl;
+}
+
+void HeadlessScan::scanErrorMessage(const QString& message)
+{
+    std::cerr << QObject::tr("Error: %1").arg(message).toUtf8().constData() << std::endl;
+}
+
+void HeadlessScan::scanCanceled()
+{
+    exitWith(1);
+}
+
+void HeadlessScan::scanFinished()
+{
+    // The scanner moves itself back to our thread before quitting the scan
+    // thread, after the wait it is safe to read the results.
+    mScanThread->wait();
+
+    exitWith(saveResults() ? 0 : 1);
+}
+
+bool HeadlessScan::saveResults()
+{
+    const QString baseName = QFileInfo(mInputFile).baseName();
+    bool ret = true;
+
+    // with several profiles their results are told apart by the profile ID
+    ScanArtifacts* artifacts = mScanner->takeArtifacts();
+    ret = saveArtifacts(*artifacts, mAdditionalProfiles.isEmpty() ? baseName : getOutputBaseName(baseName, mProfile)) && ret;
+    delete artifacts;
+
+    for (QStringList::const_iterator it = mAdditionalProfiles.constBegin(); it != mAdditionalProfiles.constEnd(); ++it)
+    {
+        // only the in-process scanner is used with additional profiles
+        artifacts = static_cast<OscapScannerInProcess*>(mScanner)->takeAdditionalArtifacts(*it);
+        if (!artifacts)
+        {
+            scanErrorMessage(QObject::tr("Profile '%1' has not been evaluated.").arg(*it));
+            ret = false;
+            continue;
+        }
+
+        ret = saveArtifacts(*artifacts, getOutputBaseName(baseName, *it)) && ret;
+        delete artifacts;
+    }
+
+    QHash<QString, qint64> ruleTimings;
+    mScanner->getRuleTimings(ruleTimings);
+    RuleTimingReport ruleTimingReport;
+    ruleTimingReport.build(ruleTimings, mScanner->getSession());
+
+    ret = saveFile(QString("%1-rule-timings.csv").arg(baseName), ruleTimingReport.toCSV()) && ret;
+    ret = saveFile(QString("%1-rule-timings.json").arg(baseName), ruleTimingReport.toJSON()) && ret;
+
+    return ret;
+}
+
+bool HeadlessScan::saveArtifacts(const ScanArtifacts& artifacts, const QString& baseName)
+{
+    const QDir dir(mOutputDirectory);
+
+    const ScanArtifacts::Artifact outputs[] = {
+        ScanArtifacts::ARTIFACT_RESULTS, ScanArtifacts::ARTIFACT_REPORT, ScanArtifacts::ARTIFACT_ARF
+    };
+
+    bool ret = true;
+    for (unsigned int i = 0; i < sizeof(outputs) / sizeof(outputs[0]); ++i)
+    {
+        const QString fileName = dir.absoluteFilePath(ScanArtifacts::getOutputFileName(outputs[i], baseName));
+
+        try
+        {
+            artifacts.copyTo(outputs[i].artifact, fileName);
+        }
+        catch (const ScanArtifactsException& e)
+        {
+            scanErrorMessage(QObject::tr("Failed to write '%1'. Details follow:\n%2")
+                .arg(fileName).arg(QString::fromUtf8(e.what())));
+            ret = false;
+            continue;
+        }
+
+        scanInfoMessage(QObject::tr("Saved '%1'.").arg(fileName));
+    }
+
+    return ret;
+}
+
+bool HeadlessScan::saveFile(const QString& fileName, const QByteArray& data)
+{
+    const QString path = QDir(mOutputDirectory).absoluteFilePath(fileName);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+    {
+        scanErrorMessage(QObject::tr("Failed to write '%1'.").arg(path));
+        return false;
+    }
+
+    scanInfoMessage(QObject::tr("Saved '%1'.").arg(path));
+    return true;
+}
+
+QString HeadlessScan::getOutputBaseName(const QString& baseName, const QString& profileID)
+{
+    QString profileName = profileID.isEmpty() ? QString("default") : profileID;
+    profileName.replace(QRegExp("[^A-Za-z0-9._-]"), "_");
+
+    return QString("%1-%2").arg(baseName, profileName);
+}
+
+void HeadlessScan::exitWith(int exitCode)
+{
+    QCoreApplication::exit(exitCode);
+}
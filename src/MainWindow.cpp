@@ -21,10 +21,12 @@
 
 #include "MainWindow.h"
 #include "OscapScannerLocal.h"
+#include "OscapScannerInProcess.h"
 #include "OscapScannerRemoteSsh.h"
 #include "ResultViewer.h"
 #include "DiagnosticsDialog.h"
 #include "CommandLineArgsDialog.h"
+#include "FleetScanDialog.h"
 #include "TailorProfileDialog.h"
 #include "TailoringWindow.h"
 #include "ScanningSession.h"
@@ -35,20 +37,25 @@
 #include "Utils.h"
 #include "SSGIntegrationDialog.h"
 #include "RemediationRoleSaver.h"
+#include "ResultMerger.h"
+#include "SessionLoader.h"
+#include "ScanArtifacts.h"
 
 #include <QFileDialog>
+#include <QFile>
 #include <QAbstractEventDispatcher>
+#include <QEventLoop>
 #include <QCloseEvent>
 #include <QDesktopWidget>
 #include <QMenu>
 
 #include <cassert>
 #include <set>
+#include <stdexcept>
 
 extern "C" {
 #include <xccdf_policy.h>
 #include <xccdf_session.h>
-#include <scap_ds.h>
 }
 
 // A dialog to open a tailoring file is displayed after user selects this option
@@ -79,11 +86,14 @@ MainWindow::MainWindow(QWidget* parent):
 
     mScanThread(0),
     mScanner(0),
+    mProgressEstimated(false),
 
     mOldTailoringComboBoxIdx(0),
     mLoadedTailoringFileUserData(TAILORING_NO_LOADED_FILE_DATA),
 
     mIgnoreProfileComboBox(false),
+    mSessionLoadProgress(0),
+    mHasPreparedRules(false),
 
     mRuleResultsExpanded(false)
 {
@@ -148,11 +158,20 @@ MainWindow::MainWindow(QWidget* parent):
 # endif
 #endif
 
-#ifndef SCAP_WORKBENCH_LOCAL_SSH_FOUND
+#ifdef SCAP_WORKBENCH_LOCAL_SSH_FOUND
+    QObject::connect(
+        mUI.actionScanFleet, SIGNAL(triggered()),
+        this, SLOT(openFleetScanDialog())
+    );
+#else
     mUI.remoteMachineRadioButton->setEnabled(false);
     mUI.remoteMachineRadioButton->setToolTip(
         QObject::tr("SCAP Workbench was compiled without remote scanning support")
     );
+    mUI.actionScanFleet->setEnabled(false);
+    mUI.actionScanFleet->setToolTip(
+        QObject::tr("SCAP Workbench was compiled without remote scanning support")
+    );
 #endif
 
 #ifndef SCAP_WORKBENCH_LOCAL_SCAN_ENABLED
@@ -173,6 +192,10 @@ MainWindow::MainWindow(QWidget* parent):
         mUI.offlineRemediateButton, SIGNAL(clicked()),
         this, SLOT(offlineRemediateAsync())
     );
+    QObject::connect(
+        mUI.rescanFailedButton, SIGNAL(clicked()),
+        this, SLOT(rescanFailedAsync())
+    );
     QObject::connect(
         mUI.cancelButton, SIGNAL(clicked()),
         this, SLOT(cancelScanAsync())
@@ -328,6 +351,8 @@ void MainWindow::clearResults()
     mUI.progressBar->reset();
     mUI.progressBar->setValue(0);
     mUI.progressBar->setEnabled(true);
+    mUI.progressBar->setFormat("%p%");
+    mProgressEstimated = false;
 
     mUI.menuSave->setEnabled(true);
     mUI.actionOpen->setEnabled(true);
@@ -348,30 +373,56 @@ void MainWindow::openFile(const QString& path)
         }
 
         mScanningSession->setSkipValid(mSkipValid);
-        mScanningSession->openFile(inputPath);
+
+        SessionLoader loader(mScanningSession);
+        loader.setFileToOpen(inputPath, tailoringPath);
+        QObject::connect(
+            &loader, SIGNAL(metadataLoaded()),
+            this, SLOT(sessionMetadataLoaded())
+        );
+        runSessionLoader(loader, true);
+
+        if (loader.wasCanceled())
+        {
+            // cached metadata may have been shown already
+            closeFile();
+
+            mDiagnosticsDialog->infoMessage(QObject::tr("Opening file '%1' has been canceled.").arg(path));
+            return;
+        }
+
+        if (loader.hasFailed())
+            throw std::runtime_error(loader.getErrorMessage().toUtf8().constData());
 
         // In case openscap autonegotiated opening a tailoring file directly
-        if (tailoringPath.isEmpty() && mScanningSession->hasTailoring())
-            tailoringPath = inputPath;
+        tailoringPath = loader.getTailoringPath();
 
         const QFileInfo pathInfo(path);
         setWindowTitle(QObject::tr("%1 - SCAP Workbench").arg(pathInfo.fileName()));
 
+        // the session is already loaded with the right tailoring, changes
+        // of the combobox must not reset it
+        mUI.tailoringFileComboBox->blockSignals(true);
         mUI.tailoringFileComboBox->addItem(QString(TAILORING_NONE), QVariant(QString::Null()));
         mUI.tailoringFileComboBox->addItem(QString(TAILORING_CUSTOM_FILE), QVariant(QString::Null()));
         // we have just loaded the input file fresh, there are no tailoring changes to save
         markNoUnsavedTailoringChanges();
 
-        refreshChecklists();
-
         if (!tailoringPath.isEmpty())
-        {
-            mScanningSession->setTailoringFile(tailoringPath);
             markLoadedTailoringFile(tailoringPath);
-        }
 
-        // force load up of the session
-        checklistComboboxChanged(0);
+        mUI.tailoringFileComboBox->blockSignals(false);
+        mOldTailoringComboBoxIdx = mUI.tailoringFileComboBox->currentIndex();
+
+        const SessionMetadata& metadata = loader.getMetadata();
+        refreshChecklists(metadata);
+
+        // the loader has already gathered rules of the profile that gets selected
+        mHasPreparedRules = true;
+        mPreparedRulesProfileID = metadata.rulesProfileID;
+        mPreparedRules = metadata.rules;
+
+        showLoadedSession(metadata.profiles);
 
         centralWidget()->setEnabled(true);
 
@@ -379,10 +430,9 @@ void MainWindow::openFile(const QString& path)
     }
     catch (const std::exception& e)
     {
-        mScanningSession->closeFile();
-
-        setWindowTitle(QObject::tr("SCAP Workbench"));
-        mUI.tailoringFileComboBox->clear();
+        // cached metadata may have been shown already
+        closeFile();
+        mUI.tailoringFileComboBox->blockSignals(false);
 
         mDiagnosticsDialog->exceptionMessage(e, QObject::tr("Error while opening file."), MF_PREFORMATTED_XML);
     }
@@ -545,6 +595,12 @@ void MainWindow::scanAsync(ScannerMode scannerMode)
     assert(fileOpened());
     assert(!mScanThread);
 
+    // clearResults forgets them, only remediation and re-checking need them
+    // and the scanner uses their files as they are
+    ScanArtifacts* previousArtifacts = 0;
+    if (scannerMode == SM_OFFLINE_REMEDIATION || scannerMode == SM_RESCAN_FAILED)
+        previousArtifacts = mUI.resultViewer->takeArtifacts();
+
     clearResults();
 
     if (mUI.ruleResultsTree->getSelectedRulesCount() == 0)
@@ -554,6 +610,7 @@ void MainWindow::scanAsync(ScannerMode scannerMode)
                 QMessageBox::Yes | QMessageBox::No,
                 QMessageBox::No) == QMessageBox::No)
         {
+            delete previousArtifacts;
             return;
         }
     }
@@ -585,10 +642,54 @@ void MainWindow::scanAsync(ScannerMode scannerMode)
         mUI.menuSave->setEnabled(true);
         mUI.actionOpen->setEnabled(true);
 
+        delete previousArtifacts;
         return;
     }
 
-    const int selected_rules = xccdf_policy_get_selected_rules_count(policy);
+    int selected_rules = xccdf_policy_get_selected_rules_count(policy);
+
+    if (scannerMode == SM_RESCAN_FAILED)
+    {
+        // results of rules that are not re-checked stay as they were
+        QStringList ruleIDs;
+        QStringList results;
+        QFile previousResults(previousArtifacts && previousArtifacts->has(ScanArtifacts::ARTIFACT_RESULTS) ?
+            previousArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS) : QString());
+        try
+        {
+            if (previousResults.fileName().isEmpty() || !previousResults.open(QIODevice::ReadOnly))
+                throw ResultMergerException("Failed to open results of the previous scan!");
+
+            ResultMerger::getRuleResults(previousResults, ruleIDs, results);
+        }
+        catch (const ResultMergerException& e)
+        {
+            scanWarningMessage(e.what());
+        }
+
+        selected_rules = 0;
+        for (int i = 0; i < ruleIDs.size(); ++i)
+        {
+            if (ResultMerger::isFailed(results[i]))
+            {
+                ++selected_rules;
+                continue;
+            }
+
+            if (results[i] == "notselected")
+                continue;
+
+            try
+            {
+                mUI.ruleResultsTree->injectRuleResult(ruleIDs[i], results[i]);
+            }
+            catch (const RuleResultsTreeException&)
+            {
+                // the rule is not in the tree, nothing to show
+            }
+        }
+    }
+
     mUI.progressBar->setRange(0, std::max(1, selected_rules));
     mUI.progressBar->reset();
     mUI.progressBar->setValue(0);
@@ -611,7 +712,10 @@ void MainWindow::scanAsync(ScannerMode scannerMode)
         {
             delete mScanner;
 
-            if (target == "localhost")
+            if (target == "localhost" && OscapScannerInProcess::isEnabled() &&
+                OscapScannerInProcess::supports(scannerMode, fetchRemoteResources))
+                mScanner = new OscapScannerInProcess();
+            else if (target == "localhost")
                 mScanner = new OscapScannerLocal();
             else
                 mScanner = new OscapScannerRemoteSsh();
@@ -623,8 +727,12 @@ void MainWindow::scanAsync(ScannerMode scannerMode)
                 mScanner, SLOT(cancel())
             );
             QObject::connect(
-                mScanner, SIGNAL(progressReport(QString,QString)),
-                this, SLOT(scanProgressReport(QString,QString))
+                mScanner, SIGNAL(progressReportBatch(QStringList,QStringList)),
+                this, SLOT(scanProgressReportBatch(QStringList,QStringList))
+            );
+            QObject::connect(
+                mScanner, SIGNAL(progressEstimate(double,int)),
+                this, SLOT(scanProgressEstimate(double,int))
             );
             QObject::connect(
                 mScanner, SIGNAL(infoMessage(QString)),
@@ -655,14 +763,13 @@ void MainWindow::scanAsync(ScannerMode scannerMode)
         mScanner->setSession(mScanningSession);
         mScanner->setScannerMode(scannerMode);
 
-        if (scannerMode == SM_OFFLINE_REMEDIATION)
-        {
-            // TODO: Allow user to tweak the results to deselect/select rules to remediate, etc...
-            mScanner->setARFForRemediation(mUI.resultViewer->getARF());
-        }
+        // TODO: Allow user to tweak the results to deselect/select rules to remediate, etc...
+        mScanner->setPreviousArtifacts(previousArtifacts);
+        previousArtifacts = 0;
     }
     catch (const std::exception& e)
     {
+        delete previousArtifacts;
         scanCanceled();
         mDiagnosticsDialog->exceptionMessage(e, QObject::tr("There was a problem setting up the scanner."));
         return;
@@ -694,6 +801,33 @@ void MainWindow::offlineRemediateAsync()
     scanAsync(SM_OFFLINE_REMEDIATION);
 }
 
+void MainWindow::rescanFailedAsync()
+{
+    QStringList failedRules;
+    QFile results(mUI.resultViewer->getResultsPath());
+    try
+    {
+        if (results.fileName().isEmpty() || !results.open(QIODevice::ReadOnly))
+            throw ResultMergerException("Failed to open results of the previous scan!");
+
+        failedRules = ResultMerger::getFailedRules(results);
+    }
+    catch (const ResultMergerException& e)
+    {
+        mDiagnosticsDialog->exceptionMessage(e, QObject::tr("Failed to read results of the previous scan."));
+        return;
+    }
+
+    if (failedRules.isEmpty())
+    {
+        QMessageBox::information(this, QObject::tr("Nothing to re-check"),
+            QObject::tr("No rule failed in the previous scan, there is nothing to re-check."));
+        return;
+    }
+
+    scanAsync(SM_RESCAN_FAILED);
+}
+
 void MainWindow::cancelScanAsync()
 {
     assert(fileOpened());
@@ -702,6 +836,26 @@ void MainWindow::cancelScanAsync()
     emit cancelScan();
 }
 
+void MainWindow::openFleetScanDialog()
+{
+    if (!fileOpened() || mScanThread)
+        return;
+
+    if (!mScanningSession->isSDS())
+    {
+        QMessageBox::warning(this, QObject::tr("Source datastream required"),
+            QObject::tr("You can only use source datastreams for scanning remotely! "
+            "Remote scanning using plain XCCDF and OVAL files has not been implemented in SCAP Workbench yet."));
+        return;
+    }
+
+    // Modal, the session has to stay unchanged while the fleet is being scanned
+    FleetScanDialog dialog(mScanningSession, this);
+    dialog.setSkipValid(mSkipValid);
+    dialog.setFetchRemoteResources(mUI.fetchRemoteResourcesCheckbox->isChecked());
+    dialog.exec();
+}
+
 void MainWindow::enable()
 {
     setEnabled(true);
@@ -709,6 +863,15 @@ void MainWindow::enable()
 
 void MainWindow::closeEvent(QCloseEvent* event)
 {
+    // the window is usable while loading, the loader still uses the session
+    if (mSessionLoadProgress)
+    {
+        QMessageBox::information(this, QObject::tr("Content is being loaded"),
+            QObject::tr("SCAP Workbench can be closed once the content is loaded."));
+        event->ignore();
+        return;
+    }
+
     if (mScanThread)
     {
         if (QMessageBox::question(this, QObject::tr("Cancel scan in progress?"),
@@ -766,6 +929,7 @@ void MainWindow::closeFile()
     centralWidget()->setEnabled(false);
 
     setWindowTitle(QObject::tr("SCAP Workbench"));
+    mUI.titleLabel->clear();
 
     mUI.checklistComboBox->clear();
     mUI.checklistComboBox->hide();
@@ -774,25 +938,172 @@ void MainWindow::closeFile()
     mUI.tailoringFileComboBox->clear();
 
     mUI.profileComboBox->clear();
+    mUI.ruleResultsTree->refreshSelectedRules(QList<SessionRuleItem>());
+
+    mHasPreparedRules = false;
+    mPreparedRules.clear();
 
     clearResults();
 }
 
 void MainWindow::reloadSession()
 {
-    try
-    {
-        mScanningSession->reloadSession();
-    }
-    catch (const std::exception& e)
+    SessionLoader loader(mScanningSession);
+    runSessionLoader(loader, false);
+
+    if (loader.hasFailed())
     {
-        mDiagnosticsDialog->exceptionMessage(e);
+        mDiagnosticsDialog->errorMessage(loader.getErrorMessage());
+
+        mUI.resultViewer->clear();
+        mUI.titleLabel->setText(mScanningSession->getBenchmarkTitle());
+        toggleRuleResultsExpanded(false);
+        // reports the error again if the profiles can't be listed
+        refreshProfiles();
+        return;
     }
 
+    showLoadedSession(loader.getMetadata().profiles);
+}
+
+void MainWindow::showLoadedSession(const QList<SessionProfileItem>& profiles)
+{
     mUI.resultViewer->clear();
     mUI.titleLabel->setText(mScanningSession->getBenchmarkTitle());
     toggleRuleResultsExpanded(false);
-    refreshProfiles();
+    refreshProfiles(profiles);
+}
+
+void MainWindow::runSessionLoader(SessionLoader& loader, bool cancelable)
+{
+    QProgressDialog progress(this);
+    progress.setWindowTitle(QObject::tr("Loading content"));
+    // cached metadata are shown while loading, the window has to stay usable
+    progress.setWindowModality(Qt::NonModal);
+    progress.setRange(0, SessionLoader::STAGE_COUNT);
+    progress.setValue(0);
+    if (!cancelable)
+        progress.setCancelButton(0);
+
+    mSessionLoadProgress = &progress;
+    disableSessionActions();
+
+    QThread thread;
+    QEventLoop loop;
+
+    loader.moveToThread(&thread);
+
+    QObject::connect(
+        &thread, SIGNAL(started()),
+        &loader, SLOT(run())
+    );
+    QObject::connect(
+        &loader, SIGNAL(stageStarted(int, const QString&)),
+        this, SLOT(sessionLoadStageStarted(int, const QString&))
+    );
+    QObject::connect(
+        &loader, SIGNAL(finished()),
+        &loop, SLOT(quit())
+    );
+    // the loader thread is busy in libopenscap, the flag has to be set directly
+    if (cancelable)
+    {
+        QObject::connect(
+            &progress, SIGNAL(canceled()),
+            &loader, SLOT(cancel()),
+            Qt::DirectConnection
+        );
+    }
+
+    progress.show();
+    thread.start();
+    loop.exec();
+
+    thread.quit();
+    thread.wait();
+
+    restoreSessionActions();
+    mSessionLoadProgress = 0;
+}
+
+void MainWindow::disableSessionActions()
+{
+    QWidget* widgets[] = {
+        mUI.checklistComboBox, mUI.profileComboBox, mUI.tailoringFileComboBox,
+        mUI.customizeProfileButton, mUI.preScanTools, mUI.postScanTools
+    };
+    QAction* actions[] = {
+        mUI.actionOpen, mUI.actionOpenSSG, mUI.actionOpenCustomizationFile,
+        mUI.actionScanFleet, mUI.actionSaveTailoring, mUI.menuSave->menuAction(),
+        mUI.actionSaveIntoDirectory, mUI.actionSaveAsRPM
+    };
+
+    for (unsigned int i = 0; i < sizeof(widgets) / sizeof(widgets[0]); ++i)
+    {
+        // not isEnabled, the central widget itself is disabled while opening
+        if (widgets[i]->testAttribute(Qt::WA_ForceDisabled))
+            continue;
+
+        widgets[i]->setEnabled(false);
+        mSessionLoadDisabledWidgets.append(widgets[i]);
+    }
+
+    for (unsigned int i = 0; i < sizeof(actions) / sizeof(actions[0]); ++i)
+    {
+        if (!actions[i]->isEnabled())
+            continue;
+
+        actions[i]->setEnabled(false);
+        mSessionLoadDisabledActions.append(actions[i]);
+    }
+}
+
+void MainWindow::restoreSessionActions()
+{
+    for (QList<QWidget*>::const_iterator it = mSessionLoadDisabledWidgets.constBegin();
+         it != mSessionLoadDisabledWidgets.constEnd(); ++it)
+        (*it)->setEnabled(true);
+
+    for (QList<QAction*>::const_iterator it = mSessionLoadDisabledActions.constBegin();
+         it != mSessionLoadDisabledActions.constEnd(); ++it)
+        (*it)->setEnabled(true);
+
+    mSessionLoadDisabledWidgets.clear();
+    mSessionLoadDisabledActions.clear();
+}
+
+void MainWindow::sessionMetadataLoaded()
+{
+    SessionLoader* loader = qobject_cast<SessionLoader*>(sender());
+    if (!loader)
+        return;
+
+    showSessionMetadata(loader->getMetadata());
+    // the rules can be browsed while loading, disableSessionActions keeps the rest disabled
+    centralWidget()->setEnabled(true);
+}
+
+void MainWindow::showSessionMetadata(const SessionMetadata& metadata)
+{
+    mUI.titleLabel->setText(metadata.benchmarkTitle);
+    refreshChecklists(metadata);
+
+    // profiles are selected in the session once it is loaded
+    mIgnoreProfileComboBox = true;
+    mUI.profileComboBox->clear();
+    addProfileItems(metadata.profiles);
+    mIgnoreProfileComboBox = false;
+
+    mUI.ruleResultsTree->refreshSelectedRules(metadata.rules);
+}
+
+void MainWindow::sessionLoadStageStarted(int stage, const QString& description)
+{
+    if (!mSessionLoadProgress)
+        return;
+
+    mSessionLoadProgress->setLabelText(description);
+    mSessionLoadProgress->setValue(stage);
 }
 
 void MainWindow::notifyTailoringFinished(bool newProfile, bool changesConfirmed)
@@ -817,6 +1128,25 @@ void MainWindow::notifyTailoringFinished(bool newProfile, bool changesConfirmed)
 }
 
 void MainWindow::refreshProfiles()
+{
+    QList<SessionProfileItem> profiles;
+
+    if (fileOpened())
+    {
+        try
+        {
+            profiles = SessionLoader::buildProfileList(mScanningSession);
+        }
+        catch (const std::exception& e)
+        {
+            mDiagnosticsDialog->exceptionMessage(e, QObject::tr("Error while refreshing available XCCDF profiles."));
+        }
+    }
+
+    refreshProfiles(profiles);
+}
+
+void MainWindow::refreshProfiles(const QList<SessionProfileItem>& profiles)
 {
     const int previousIndex = mUI.profileComboBox->currentIndex();
     const QString previouslySelected = previousIndex == -1 ?
@@ -829,108 +1159,58 @@ void MainWindow::refreshProfiles()
     if (!fileOpened())
         return;
 
-    try
-    {
-        const std::map<QString, struct xccdf_profile*> profiles = mScanningSession->getAvailableProfiles();
-        struct xccdf_policy_model* policyModel = xccdf_session_get_policy_model(mScanningSession->getXCCDFSession());
-
-        // A nice side effect here is that profiles will be sorted by their IDs
-        // because of the RB-tree implementation of std::map.
-        for (std::map<QString, struct xccdf_profile*>::const_iterator it = profiles.begin();
-             it != profiles.end(); ++it)
-        {
-            QString profileTitle = oscapTextIteratorGetPreferred(xccdf_profile_get_title(it->second));
-
-            struct xccdf_policy* policy = xccdf_policy_new(policyModel, it->second);
-            const int selectedRulesCount = xccdf_policy_get_selected_rules_count(policy);
-            xccdf_policy_free(policy);
+    addProfileItems(profiles);
 
-            profileTitle = profileTitle +" ("+ QString::number(selectedRulesCount) + ")";
-            mUI.profileComboBox->addItem(profileTitle, QVariant(it->first));
-        }
-
-        if (previouslySelected != QString::Null())
-        {
-            const int indexCandidate = mUI.profileComboBox->findData(QVariant(previouslySelected));
-            if (indexCandidate != -1)
-                mUI.profileComboBox->setCurrentIndex(indexCandidate);
-        }
-
-        // default profile
-        {
-            QString profileTitle = QObject::tr("(default)");
-
-            // We use QT_VERSION_CHECK to transform major, minor, patch numbers into
-            // one easy comparable number.
-            // We can only count selected rules for default profile if we are compiling against
-            // OpenSCAP versions newer than 1.2.12.
-            // See https://github.com/OpenSCAP/openscap/pull/607
-#if (QT_VERSION_CHECK(OPENSCAP_VERSION_MAJOR, OPENSCAP_VERSION_MINOR, OPENSCAP_VERSION_PATCH) > QT_VERSION_CHECK(1, 2, 12))
-            struct xccdf_policy* policy = xccdf_policy_new(policyModel, NULL);
-            const int selectedRulesCount = xccdf_policy_get_selected_rules_count(policy);
-            xccdf_policy_free(policy);
-
-            profileTitle = profileTitle + " ("+ QString::number(selectedRulesCount) + ")";
-#endif
-
-            // Intentionally comes last. Users are more likely to use profiles other than (default)
-#if (QT_VERSION >= QT_VERSION_CHECK(4, 4, 0))
-            mUI.profileComboBox->insertSeparator(mUI.profileComboBox->count());
-#endif
-            mUI.profileComboBox->addItem(profileTitle, QVariant(QString::Null()));
-        }
-    }
-    catch (const std::exception& e)
+    if (previouslySelected != QString::Null())
     {
-        mUI.profileComboBox->clear();
-        mDiagnosticsDialog->exceptionMessage(e, QObject::tr("Error while refreshing available XCCDF profiles."));
+        const int indexCandidate = mUI.profileComboBox->findData(QVariant(previouslySelected));
+        if (indexCandidate != -1)
+            mUI.profileComboBox->setCurrentIndex(indexCandidate);
     }
 
     mIgnoreProfileComboBox = false;
     profileComboboxChanged(mUI.profileComboBox->currentIndex());
 }
 
-void MainWindow::refreshChecklists()
+void MainWindow::addProfileItems(const QList<SessionProfileItem>& profiles)
 {
-    try
+    for (QList<SessionProfileItem>::const_iterator it = profiles.begin();
+         it != profiles.end(); ++it)
     {
-        mUI.checklistComboBox->clear();
+        // the default profile has a null ID and intentionally comes last,
+        // users are more likely to use profiles other than (default)
+#if (QT_VERSION >= QT_VERSION_CHECK(4, 4, 0))
+        if (it->id.isNull())
+            mUI.profileComboBox->insertSeparator(mUI.profileComboBox->count());
+#endif
+        mUI.profileComboBox->addItem(it->title, QVariant(it->id));
+    }
+}
 
-        if (mScanningSession->isSDS())
-        {
-            struct ds_sds_index* sds_idx = xccdf_session_get_sds_idx(mScanningSession->getXCCDFSession());
+void MainWindow::refreshChecklists(const SessionMetadata& metadata)
+{
+    // filling the combobox must not select other checklist than the loaded one
+    mUI.checklistComboBox->blockSignals(true);
+    mUI.checklistComboBox->clear();
 
-            struct ds_stream_index_iterator* streams_it = ds_sds_index_get_streams(sds_idx);
-            while (ds_stream_index_iterator_has_more(streams_it))
-            {
-                struct ds_stream_index* stream_idx = ds_stream_index_iterator_next(streams_it);
-                const QString stream_id = QString::fromUtf8(ds_stream_index_get_id(stream_idx));
+    for (QList<QStringList>::const_iterator it = metadata.checklists.begin();
+         it != metadata.checklists.end(); ++it)
+    {
+        mUI.checklistComboBox->addItem(QString("%1 / %2").arg(it->at(0)).arg(it->at(1)), *it);
+    }
 
-                struct oscap_string_iterator* checklists_it = ds_stream_index_get_checklists(stream_idx);
-                while (oscap_string_iterator_has_more(checklists_it))
-                {
-                    const QString checklist_id = QString::fromUtf8(oscap_string_iterator_next(checklists_it));
+    QStringList loaded;
+    loaded.append(metadata.datastreamID);
+    loaded.append(metadata.componentID);
 
-                    QStringList data;
-                    data.append(stream_id);
-                    data.append(checklist_id);
+    const int loadedIndex = mUI.checklistComboBox->findData(loaded);
+    if (loadedIndex != -1)
+        mUI.checklistComboBox->setCurrentIndex(loadedIndex);
 
-                    mUI.checklistComboBox->addItem(QString("%1 / %2").arg(stream_id).arg(checklist_id), data);
-                }
-                oscap_string_iterator_free(checklists_it);
-            }
-            ds_stream_index_iterator_free(streams_it);
+    mUI.checklistComboBox->blockSignals(false);
 
-            mUI.checklistComboBox->setVisible(mUI.checklistComboBox->count() > 1);
-            mUI.checklistLabel->setVisible(mUI.checklistComboBox->count() > 1);
-        }
-    }
-    catch (...)
-    {
-        // do not leave the combobox partially filled
-        mUI.checklistComboBox->clear();
-        throw;
-    }
+    mUI.checklistComboBox->setVisible(mUI.checklistComboBox->count() > 1);
+    mUI.checklistLabel->setVisible(mUI.checklistComboBox->count() > 1);
 }
 
 void MainWindow::cleanupScanThread()
@@ -1110,7 +1390,15 @@ void MainWindow::profileComboboxChanged(int index)
         mDiagnosticsDialog->exceptionMessage(e, QObject::tr("Failed to select XCCDF profile."));
     }
 
-    mUI.ruleResultsTree->refreshSelectedRules(mScanningSession);
+    // opening a file gathers rules of the first selected profile in background
+    if (mHasPreparedRules && profileId == mPreparedRulesProfileID)
+        mUI.ruleResultsTree->refreshSelectedRules(mPreparedRules);
+    else
+        mUI.ruleResultsTree->refreshSelectedRules(mScanningSession);
+
+    mHasPreparedRules = false;
+    mPreparedRules.clear();
+
     clearResults();
 }
 
@@ -1179,13 +1467,16 @@ void MainWindow::scanProgressReport(const QString& rule_id, const QString& resul
        We must only count unique result because multi check causes one rule
        to produce multiple result. This would skew our estimation to be too
        optimistic!
+
+       This is only a fallback, scanners that know durations of rules from
+       previous scans send much better estimates, see scanProgressEstimate.
     */
 
     if (result != "processing")
     {
         // Guard ourselves against multi checks, only count each rule result once
         // for progress estimation.
-        if (!mUI.ruleResultsTree->hasRuleResult(rule_id))
+        if (!mProgressEstimated && !mUI.ruleResultsTree->hasRuleResult(rule_id))
             mUI.progressBar->setValue(mUI.progressBar->value() + 1);
     }
 
@@ -1199,6 +1490,50 @@ void MainWindow::scanProgressReport(const QString& rule_id, const QString& resul
     }
 }
 
+void MainWindow::scanProgressReportBatch(const QStringList& ruleIDs, const QStringList& results)
+{
+    assert(ruleIDs.size() == results.size());
+
+    // avoid repainting the tree and the progress bar after every single result
+    mUI.ruleResultsTree->setUpdatesEnabled(false);
+    mUI.progressBar->setUpdatesEnabled(false);
+
+    for (int i = 0; i < ruleIDs.size(); ++i)
+        scanProgressReport(ruleIDs.at(i), results.at(i));
+
+    mUI.progressBar->setUpdatesEnabled(true);
+    mUI.ruleResultsTree->setUpdatesEnabled(true);
+}
+
+void MainWindow::scanProgressEstimate(double progress, int remainingSeconds)
+{
+    // the estimate is finer than the count of rules
+    static const int PROGRESS_STEPS = 1000;
+
+    if (!mProgressEstimated)
+    {
+        mProgressEstimated = true;
+        mUI.progressBar->setRange(0, PROGRESS_STEPS);
+        mUI.progressBar->setValue(0);
+        mUI.progressBar->setTextVisible(true);
+    }
+
+    // the estimate can go back a little when a rule finishes sooner than expected
+    const int value = static_cast<int>(progress * PROGRESS_STEPS);
+    if (value > mUI.progressBar->value())
+        mUI.progressBar->setValue(value);
+
+    if (remainingSeconds < 0)
+        mUI.progressBar->setFormat("%p%");
+    else if (remainingSeconds < 60)
+        mUI.progressBar->setFormat(QObject::tr("%p% (less than a minute left)"));
+    else if (remainingSeconds < 60 * 60)
+        mUI.progressBar->setFormat(QObject::tr("%p% (about %1 min left)").arg(remainingSeconds / 60));
+    else
+        mUI.progressBar->setFormat(QObject::tr("%p% (about %1 h %2 min left)")
+            .arg(remainingSeconds / 3600).arg((remainingSeconds % 3600) / 60));
+}
+
 void MainWindow::scanInfoMessage(const QString& message)
 {
     statusBar()->showMessage(message);
@@ -1241,12 +1576,17 @@ void MainWindow::scanEnded(bool canceled)
         // are only partial. Yet it could be useful to review them so we don't
         // clear them completely.
         mUI.ruleResultsTree->setEnabled(false);
+        // there are no results to re-check
+        mUI.rescanFailedButton->setEnabled(false);
     }
     else
     {
         mUI.progressBar->setValue(mUI.progressBar->maximum());
+        mUI.progressBar->setFormat("%p%");
         mUI.resultViewer->loadContent(mScanner);
         mUI.offlineRemediateButton->setEnabled(mScanner->getScannerMode() == SM_SCAN);
+        mUI.rescanFailedButton->setEnabled(!mUI.dryRunCheckBox->isChecked() &&
+            mScanner->getScannerMode() != SM_OFFLINE_REMEDIATION);
     }
 
     mUI.preScanTools->hide();
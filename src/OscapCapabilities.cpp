@@ -23,6 +23,8 @@
 
 #include <QRegExp>
 #include <QStringList>
+#include <QSettings>
+#include <QDateTime>
 #include <cassert>
 
 OscapCapabilities::OscapCapabilities()
@@ -40,6 +42,7 @@ void OscapCapabilities::clear()
     mSourceDataStreams = false;
     mARFInput = false;
     mTailoringSupport = false;
+    mMultipleRuleFilters = false;
     mSCE = false;
 
     mXCCDFVersion = "Unknown";
@@ -110,6 +113,10 @@ void OscapCapabilities::parse(const QString& mmv)
     if (versionGreaterOrEqual(mVersion, "0.9.12"))
         mTailoringSupport = true;
 
+    // older versions only take the last --rule into account
+    if (versionGreaterOrEqual(mVersion, "1.3.0"))
+        mMultipleRuleFilters = true;
+
     /*if (versionGreaterThan(mVersion, "0.999.999"))
         mARFInput = true;*/
 
@@ -179,6 +186,11 @@ bool OscapCapabilities::tailoringSupport() const
     return mTailoringSupport;
 }
 
+bool OscapCapabilities::multipleRuleFilters() const
+{
+    return mMultipleRuleFilters;
+}
+
 const QString& OscapCapabilities::XCCDFVersion() const
 {
     return mXCCDFVersion;
@@ -193,3 +205,47 @@ const QString& OscapCapabilities::CPEVersion() const
 {
     return mCPEVersion;
 }
+
+// Targets may contain characters with special meaning in QSettings keys ('/')
+static QString capabilitiesCacheGroup(const QString& target)
+{
+    return QString("oscap-capabilities-cache/%1").arg(QString::fromLatin1(target.toUtf8().toHex()));
+}
+
+bool OscapCapabilitiesCache::lookup(const QString& target, QString& binaryIdentity, QString& versionOutput)
+{
+    QSettings settings;
+    settings.beginGroup(capabilitiesCacheGroup(target));
+
+    const QDateTime queried = settings.value("queried").toDateTime();
+    if (!queried.isValid() || queried.secsTo(QDateTime::currentDateTime()) > TTL)
+        return false;
+
+    const QString identity = settings.value("binary-identity").toString();
+    const QString output = settings.value("version-output").toString();
+    if (identity.isEmpty() || output.isEmpty())
+        return false;
+
+    binaryIdentity = identity;
+    versionOutput = output;
+    return true;
+}
+
+void OscapCapabilitiesCache::store(const QString& target, const QString& binaryIdentity, const QString& versionOutput)
+{
+    // without identity we could never tell that oscap has changed
+    if (binaryIdentity.isEmpty())
+        return;
+
+    QSettings settings;
+    settings.beginGroup(capabilitiesCacheGroup(target));
+    settings.setValue("queried", QDateTime::currentDateTime());
+    settings.setValue("binary-identity", binaryIdentity);
+    settings.setValue("version-output", versionOutput);
+}
+
+void OscapCapabilitiesCache::invalidate(const QString& target)
+{
+    QSettings settings;
+    settings.remove(capabilitiesCacheGroup(target));
+}
@@ -21,15 +21,26 @@
 
 #include "OscapScannerBase.h"
 #include "ScanningSession.h"
+#include "ResultMerger.h"
+#include "ProcessHelpers.h"
+#include "TemporaryDir.h"
+#include "ScratchSpace.h"
+#include "ScanArtifacts.h"
+#include "Exceptions.h"
+#include "APIHelpers.h"
 
 #include <QThread>
-#include <QAbstractEventDispatcher>
+#include <QEventLoop>
 #include <QTemporaryFile>
+#include <QFile>
+#include <QTimer>
 #include <cassert>
+#include <cstring>
 
 extern "C"
 {
 #include <xccdf_session.h>
+#include <xccdf_policy.h>
 }
 
 OscapScannerBase::OscapScannerBase():
@@ -37,52 +48,123 @@ OscapScannerBase::OscapScannerBase():
 
     mLastRuleID(""),
     mLastDownloadingFile(""),
-    mReadingState(RS_READING_PREFIX),
-    mReadBuffer(""),
-    mCancelRequested(false)
+    mCancelRequested(false),
+    mInputIsSDS(false),
+    mScanProcess(0),
+    mProgressEstimateTimer(0),
+    mArtifacts(new ScanArtifacts())
 {
-    mReadBuffer.reserve(256);
+    mReadBuffer.reserve(4096);
 }
 
 OscapScannerBase::~OscapScannerBase()
-{}
+{
+    delete mProgressEstimateTimer;
+    delete mArtifacts;
+}
 
 void OscapScannerBase::cancel()
 {
     // NB: No need for mutexes here, this will be run in the same thread because
     //     the event queue we pump in evaluate will run it.
     mCancelRequested = true;
+    emit cancelRequested();
 }
 
-void OscapScannerBase::getResults(QByteArray& destination)
+void OscapScannerBase::setSession(ScanningSession* session)
 {
-    assert(!mCancelRequested);
+    Scanner::setSession(session);
+
+    mInputFile = mSession->getOpenedFilePath();
+    mInputIsSDS = mSession->isSDS();
+    mDatastreamID = mInputIsSDS ? mSession->getDatastreamID() : QString();
+    mComponentID = mInputIsSDS ? mSession->getComponentID() : QString();
+    mProfileID = mSession->getProfile();
+
+    if (!mSession->hasTailoring())
+    {
+        mTailoringFile = QString();
+    }
+    else if (mTailoringFile.isEmpty() || mTailoringFile == mOwnTailoringFile.fileName())
+    {
+        // the file of the session itself would be overwritten by the next export
+        mOwnTailoringFile.setFileTemplate(ScratchSpace::getFileTemplate());
+        if (!mOwnTailoringFile.open())
+            throw OscapScannerBaseException("Failed to create a temporary file for the tailoring!");
+        mOwnTailoringFile.close();
+
+        mSession->saveTailoring(mOwnTailoringFile.fileName(), false);
+        mTailoringFile = mOwnTailoringFile.fileName();
+    }
+
+    mBenchmarkID = QString();
+    mSelectedRuleIDs.clear();
+
+    struct xccdf_session* xccdfSession = mSession->getXCCDFSession();
+    struct xccdf_policy* policy = xccdf_session_get_xccdf_policy(xccdfSession);
+    struct xccdf_benchmark* benchmark = xccdf_policy_model_get_benchmark(xccdf_session_get_policy_model(xccdfSession));
 
-    destination.append(mResults);
+    // the default score can only be recomputed exactly with weights of groups
+    mScoringMerger.setScoringHierarchy(benchmark);
+
+    if (policy && benchmark)
+    {
+        mBenchmarkID = QString::fromUtf8(xccdf_benchmark_get_id(benchmark));
+
+        std::vector<struct xccdf_rule*> selectedRules;
+        gatherAllSelectedRules(policy, xccdf_benchmark_to_item(benchmark), selectedRules);
+
+        for (std::vector<struct xccdf_rule*>::const_iterator it = selectedRules.begin(); it != selectedRules.end(); ++it)
+            mSelectedRuleIDs.append(QString::fromUtf8(xccdf_rule_get_id(*it)));
+    }
 }
 
-void OscapScannerBase::getReport(QByteArray& destination)
+ScanArtifacts* OscapScannerBase::takeArtifacts()
 {
     assert(!mCancelRequested);
 
-    destination.append(mReport);
+    ScanArtifacts* ret = mArtifacts;
+    mArtifacts = new ScanArtifacts();
+    return ret;
 }
 
-void OscapScannerBase::getARF(QByteArray& destination)
+void OscapScannerBase::getRuleTimings(QHash<QString, qint64>& destination)
 {
-    assert(!mCancelRequested);
+    destination = mRuleDurations;
+}
+
+void OscapScannerBase::setPreviousArtifacts(ScanArtifacts* artifacts)
+{
+    Scanner::setPreviousArtifacts(artifacts);
+
+    mRescanRules.clear();
+    if (mScannerMode != SM_RESCAN_FAILED)
+        return;
 
-    destination.append(mARF);
+    QFile results(getPreviousResultsPath());
+    if (results.fileName().isEmpty() || !results.open(QIODevice::ReadOnly))
+        return; // checkPrerequisites will complain that there is nothing to re-check
+
+    try
+    {
+        mRescanRules = ResultMerger::getFailedRules(results);
+    }
+    catch (const ResultMergerException&)
+    {
+        // checkPrerequisites will complain that there is nothing to re-check
+    }
 }
 
 void OscapScannerBase::signalCompletion(bool canceled)
 {
+    // the timer has to be gone before we move back to the main thread
+    finishRuleTiming();
+
     Scanner::signalCompletion(canceled);
 
     mLastRuleID = "";
     mLastDownloadingFile = "";
-    mReadingState = RS_READING_PREFIX;
-    mReadBuffer = "";
+    mReadBuffer.clear();
 
     // reset the cancel flag now that we have finished XOR canceled
     mCancelRequested = false;
@@ -125,7 +207,37 @@ bool OscapScannerBase::checkPrerequisites()
         return false;
     }
 
-    if (mSession->isSDS() && !mCapabilities.sourceDatastreams())
+    if (mScannerMode == SM_OFFLINE_REMEDIATION && getPreviousARFPath().isEmpty())
+    {
+        emit errorMessage(
+            QObject::tr("There is no ARF of a previous scan, there is nothing to remediate.")
+        );
+
+        return false;
+    }
+
+    if (mScannerMode == SM_RESCAN_FAILED && !mCapabilities.multipleRuleFilters())
+    {
+        emit errorMessage(
+            QObject::tr("oscap tool doesn't support evaluating only chosen rules. "
+                "Please make sure you have openscap 1.3.0 or newer if you want "
+                "to re-check failed rules. "
+                "oscap version was detected as '%1'.").arg(mCapabilities.getOpenSCAPVersion())
+        );
+
+        return false;
+    }
+
+    if (mScannerMode == SM_RESCAN_FAILED && mRescanRules.isEmpty())
+    {
+        emit errorMessage(
+            QObject::tr("There are no failed rules in the previous results, there is nothing to re-check.")
+        );
+
+        return false;
+    }
+
+    if (mInputIsSDS && !mCapabilities.sourceDatastreams())
     {
         emit errorMessage(
             QObject::tr("oscap tool doesn't support source datastreams as input. "
@@ -137,7 +249,7 @@ bool OscapScannerBase::checkPrerequisites()
         return false;
     }
 
-    if (mSession->hasTailoring() && !mCapabilities.tailoringSupport())
+    if (!mTailoringFile.isEmpty() && !mCapabilities.tailoringSupport())
     {
         emit errorMessage(
             QObject::tr("oscap tool doesn't support XCCDF tailoring but the session uses tailoring. "
@@ -152,6 +264,54 @@ bool OscapScannerBase::checkPrerequisites()
     return true;
 }
 
+void OscapScannerBase::startRuleTiming()
+{
+    mRuleDurations.clear();
+
+    // remediation of ARF results doesn't evaluate rules the usual way
+    if (mScannerMode == SM_OFFLINE_REMEDIATION || mDryRun)
+        return;
+
+    // progress is estimated from the count of results then
+    if (mBenchmarkID.isEmpty())
+        return;
+
+    mRuleTiming.start(mBenchmarkID, mTarget,
+        mScannerMode == SM_RESCAN_FAILED ? mRescanRules : mSelectedRuleIDs);
+
+    // created here to live in the scanning thread
+    delete mProgressEstimateTimer;
+    mProgressEstimateTimer = new QTimer();
+    mProgressEstimateTimer->setInterval(1000);
+    QObject::connect(
+        mProgressEstimateTimer, SIGNAL(timeout()),
+        this, SLOT(reportProgressEstimate())
+    );
+    mProgressEstimateTimer->start();
+
+    reportProgressEstimate();
+}
+
+void OscapScannerBase::finishRuleTiming()
+{
+    delete mProgressEstimateTimer;
+    mProgressEstimateTimer = 0;
+
+    // durations measured in a canceled scan are just as good
+    mRuleTiming.save();
+    if (mRuleTiming.isStarted())
+        mRuleDurations = mRuleTiming.getMeasuredDurations();
+    mRuleTiming = RuleTimingModel();
+}
+
+void OscapScannerBase::reportProgressEstimate()
+{
+    if (!mRuleTiming.isStarted())
+        return;
+
+    emit progressEstimate(mRuleTiming.getProgress(), mRuleTiming.getRemainingSeconds());
+}
+
 QString OscapScannerBase::surroundQuote(const QString& input) const
 {
     if (input.contains(" "))
@@ -166,7 +326,8 @@ QStringList OscapScannerBase::buildEvaluationArgs(const QString& inputFile,
         const QString& reportFile,
         const QString& arfFile,
         bool onlineRemediation,
-        bool ignoreCapabilities) const
+        bool ignoreCapabilities,
+        const QStringList& rules) const
 {
     QStringList ret;
     ret.append("xccdf");
@@ -182,21 +343,18 @@ QStringList OscapScannerBase::buildEvaluationArgs(const QString& inputFile,
         ret.append("--fetch-remote-resources");
     }
 
-    if (mSession->isSDS())
+    if (mInputIsSDS)
     {
-        const QString datastreamId = mSession->getDatastreamID();
-        const QString componentId = mSession->getComponentID();
-
-        if (!datastreamId.isEmpty())
+        if (!mDatastreamID.isEmpty())
         {
             ret.append("--datastream-id");
-            ret.append(datastreamId);
+            ret.append(mDatastreamID);
         }
 
-        if (!componentId.isEmpty())
+        if (!mComponentID.isEmpty())
         {
             ret.append("--xccdf-id");
-            ret.append(componentId);
+            ret.append(mComponentID);
         }
     }
 
@@ -209,12 +367,17 @@ QStringList OscapScannerBase::buildEvaluationArgs(const QString& inputFile,
             ret.append(tailoringFile);
     }
 
-    const QString profileId = mSession->getProfile();
-
-    if (!profileId.isEmpty())
+    if (!mProfileID.isEmpty())
     {
         ret.append("--profile");
-        ret.append(profileId);
+        ret.append(mProfileID);
+    }
+
+    const QStringList& evaluatedRules = mScannerMode == SM_RESCAN_FAILED ? mRescanRules : rules;
+    for (QStringList::const_iterator it = evaluatedRules.constBegin(); it != evaluatedRules.constEnd(); ++it)
+    {
+        ret.append("--rule");
+        ret.append(*it);
     }
 
     // We don't use these results directly but openscap uses them when generating
@@ -234,11 +397,15 @@ QStringList OscapScannerBase::buildEvaluationArgs(const QString& inputFile,
     else
         ret.append(arfFile);
 
-    ret.append("--report");
-    if (mDryRun)
-        ret.append(surroundQuote(reportFile));
-    else
-        ret.append(reportFile);
+    // the report can be generated later from the ARF
+    if (!reportFile.isEmpty())
+    {
+        ret.append("--report");
+        if (mDryRun)
+            ret.append(surroundQuote(reportFile));
+        else
+            ret.append(reportFile);
+    }
 
     if (ignoreCapabilities || mCapabilities.progressReporting())
         ret.append("--progress");
@@ -254,6 +421,91 @@ QStringList OscapScannerBase::buildEvaluationArgs(const QString& inputFile,
     return ret;
 }
 
+void OscapScannerBase::mergeResults(const QStringList& resultFiles, const QStringList& arfFiles)
+{
+    ResultMerger resultsMerger(mScoringMerger);
+    ResultMerger arfMerger(mScoringMerger);
+    for (QStringList::const_iterator it = resultFiles.constBegin(); it != resultFiles.constEnd(); ++it)
+        resultsMerger.addInput(*it);
+    for (QStringList::const_iterator it = arfFiles.constBegin(); it != arfFiles.constEnd(); ++it)
+        arfMerger.addInput(*it);
+
+    // inputs may be artifacts of this scanner, they must not be overwritten while merging
+    mArtifacts->clear();
+    const QString resultsPath = mArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS);
+    const QString arfPath = mArtifacts->getPath(ScanArtifacts::ARTIFACT_ARF);
+    const QString reportPath = mArtifacts->getPath(ScanArtifacts::ARTIFACT_REPORT);
+
+    try
+    {
+        QFile resultsFile(resultsPath);
+        if (!resultsFile.open(QIODevice::WriteOnly))
+            throw ResultMergerException(QString("Failed to open '%1' for writing!").arg(resultsPath));
+        resultsMerger.merge(resultsFile);
+        resultsFile.close();
+
+        QFile arfFile(arfPath);
+        if (!arfFile.open(QIODevice::WriteOnly))
+            throw ResultMergerException(QString("Failed to open '%1' for writing!").arg(arfPath));
+        arfMerger.merge(arfFile);
+        arfFile.close();
+    }
+    catch (const ResultMergerException& e)
+    {
+        emit errorMessage(QObject::tr("Failed to merge results! Exception was: %1").arg(QString::fromUtf8(e.what())));
+        mCancelRequested = true;
+        return;
+    }
+
+    emit infoMessage(QObject::tr("Generating the HTML report..."));
+
+    SyncProcess proc(this);
+    proc.setCommand(SCAP_WORKBENCH_LOCAL_OSCAP_PATH);
+    proc.setArguments(QStringList() << "xccdf" << "generate" << "report" << "--output" << reportPath << arfPath);
+    proc.setCancelRequestSource(&mCancelRequested);
+    proc.run();
+
+    if (proc.getExitCode() != 0 || !mArtifacts->has(ScanArtifacts::ARTIFACT_REPORT))
+    {
+        emit warningMessage(QObject::tr("Failed to generate the HTML report from merged results, "
+            "results can be saved without it. Diagnostic info: %1").arg(proc.getDiagnosticInfo()));
+    }
+}
+
+void OscapScannerBase::spliceRescanResults()
+{
+    emit infoMessage(QObject::tr("Splicing results of %1 re-checked rules into the previous results...").arg(mRescanRules.size()));
+
+    // on the same filesystem as the artifacts so that they can be moved
+    TemporaryDir inputDir(ScratchSpace::getDirectory());
+    const QString resultsPath = inputDir.getPath() + "/xccdf-results.xml";
+    const QString arfPath = inputDir.getPath() + "/arf.xml";
+
+    // the previous results are merged straight from their files
+    const QString previousResultsPath = getPreviousResultsPath();
+    const QString previousARFPath = getPreviousARFPath();
+    if (previousResultsPath.isEmpty() || previousARFPath.isEmpty())
+    {
+        emit errorMessage(QObject::tr("Results of the previous scan are gone, results can't be spliced!"));
+        mCancelRequested = true;
+        return;
+    }
+
+    // the merged results replace the artifacts, move the re-checked ones out of the way
+    if (!QFile::rename(mArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS), resultsPath) ||
+        !QFile::rename(mArtifacts->getPath(ScanArtifacts::ARTIFACT_ARF), arfPath))
+    {
+        emit errorMessage(QObject::tr("Failed to move results of the re-checked rules to '%1', results can't be spliced!")
+            .arg(inputDir.getPath()));
+        mCancelRequested = true;
+        return;
+    }
+
+    // results of the re-checked rules are the latest, they take precedence
+    mergeResults(QStringList() << previousResultsPath << resultsPath,
+        QStringList() << previousARFPath << arfPath);
+}
+
 QStringList OscapScannerBase::buildOfflineRemediationArgs(const QString& resultInputFile,
         const QString& resultFile,
         const QString& reportFile,
@@ -291,129 +543,254 @@ QStringList OscapScannerBase::buildOfflineRemediationArgs(const QString& resultI
     return ret;
 }
 
-bool OscapScannerBase::tryToReadStdOutChar(QProcess& process)
+// Openscap <= 1.2.10 (60fb9f0c98eee) sends download progress through stdout
+static const char DOWNLOADING_PREFIX[] = "Downloading:";
+static const int DOWNLOADING_PREFIX_LENGTH = sizeof(DOWNLOADING_PREFIX) - 1;
+
+static bool isDownloadingLine(const char* line, int length)
 {
-    char readChar = '\0';
-    if (!process.getChar(&readChar))
-        return false;
+    return length >= DOWNLOADING_PREFIX_LENGTH &&
+        memcmp(line, DOWNLOADING_PREFIX, DOWNLOADING_PREFIX_LENGTH) == 0;
+}
 
-    if (!mCapabilities.progressReporting())
-        return true; // We did read something but it's not in a format we can parse.
+void OscapScannerBase::parseDownloadingLine(const QString& line, bool complete)
+{
+    // "Downloading: URL ... STATUS", the URL itself contains ':'
+    const int dotsIndex = line.indexOf(" ...", DOWNLOADING_PREFIX_LENGTH);
+    if (dotsIndex == -1)
+        return; // URL hasn't been fully read yet
 
-    if (readChar == ':')
+    const QString url = line.mid(DOWNLOADING_PREFIX_LENGTH, dotsIndex - DOWNLOADING_PREFIX_LENGTH).trimmed();
+    if (url != mLastDownloadingFile)
     {
-        switch (mReadingState)
-        {
-            case RS_READING_PREFIX:
-                {
-                    // Openscap <= 1.2.10 (60fb9f0c98eee) sends this message through stdout
-                    if (mReadBuffer=="Downloading")
-                    {
-                         mReadingState = RS_READING_DOWNLOAD_FILE;
-                    }
-                    else
-                    {
-                        mLastRuleID = mReadBuffer;
-                        emit progressReport(mLastRuleID, "processing");
-                        mReadingState = RS_READING_RULE_RESULT;
-                    }
-                    mReadBuffer = "";
-                }
-                break;
-
-            case RS_READING_RULE_RESULT:
-                {
-                    emit warningMessage(QString(
-                                QObject::tr("Error when parsing scan progress output from stdout of the 'oscap' process. "
-                                    "':' encountered while not reading rule ID, newline and/or rule result are missing! "
-                                    "Read buffer is '%1'.")).arg(mReadBuffer));
-                    mReadBuffer = "";
-                }
-                break;
-            case RS_READING_DOWNLOAD_FILE:
-                {
-                    // When fetching remote content, openscap will inform scap-workbench about
-                    // resources being downloaded. Keep any colon found in URL of file being downloaded.
-                    mReadBuffer.append(QChar::fromAscii(readChar));
-                }
-                break;
-
-            default:
-                // noop
-                break;
-        }
+        mLastDownloadingFile = url;
+        emit infoMessage(QString("Downloading of \"%1\"...").arg(mLastDownloadingFile));
+    }
+
+    if (!complete)
+        return;
+
+    const QString downloadStatus = line.mid(dotsIndex + 4).trimmed();
+    if (downloadStatus == "ok")
+        emit infoMessage(QString("Downloading of \"%1\" finished: %2").arg(mLastDownloadingFile).arg(downloadStatus));
+    else
+        emit warningMessage(QString("Failed to download \"%1\"!").arg(mLastDownloadingFile));
+}
+
+void OscapScannerBase::parseStdOutLine(const char* line, int length, QString& lastRuleID,
+    QStringList& ruleIDs, QStringList& results)
+{
+    if (isDownloadingLine(line, length))
+    {
+        parseDownloadingLine(QString::fromLocal8Bit(line, length), true);
+        return;
     }
-    else if (readChar == '\n')
+
+    const char* colon = static_cast<const char*>(memchr(line, ':', length));
+    if (!colon)
     {
-        switch(mReadingState)
+        const QString message = QString::fromLocal8Bit(line, length);
+
+        // If we found a line without ':', we might have received an error or
+        // warning message through stdout.
+        if (message.contains("--fetch-remote-resources"))
+        {
+            // If message is about --fetch-remote-resources, emit a nice warning.
+            // This is needed for workbench to be able to handle messages from machines
+            // running older versions of openscap.
+            // From openscap version 1.2.11, this message is sent through stderr
+            // and therefore is handled accordingly by workbench.
+            emit warningMessage(guiFriendlyMessage(message));
+        }
+        else
         {
-            case RS_READING_PREFIX:
-                // If we found a '\n' while reading prefix, we might have received an error or
-                // warning message through stdout.
-                if (mReadBuffer.contains("--fetch-remote-resources"))
-                {
-                    // If message is about --fetch-remote-resources, emit a nice warning.
-                    // This is needed for workbench to be able to handle messages from machines
-                    // running older versions of openscap.
-                    // From openscap version 1.2.11, this message is sent through stderr
-                    // and therefore is handled accordingly by workbench.
-                    emit warningMessage(guiFriendlyMessage(mReadBuffer));
-                }
-                else
-                {
-                    // No other error or warning messages are expected through stdout,
-                    // so it is likely that a parsing error occured.
-                    emit warningMessage(QString(
-                                QObject::tr("Error when parsing scan progress output from stdout of the 'oscap' process. "
-                                    "Newline encountered while reading rule ID, rule result and/or ':' are missing! "
-                                    "Read buffer is '%1'.")).arg(mReadBuffer));
-                }
-                break;
-
-            case RS_READING_RULE_RESULT:
-                emit progressReport(mLastRuleID, mReadBuffer);
-                break;
-
-            case RS_READING_DOWNLOAD_FILE_STATUS:
-                {
-                    QString downloadStatus = mReadBuffer.mid(1);
-                    if (downloadStatus == "ok")
-                        emit infoMessage(QString("Downloading of \"%1\" finished: %2").arg(mLastDownloadingFile).arg(downloadStatus));
-                    else
-                        emit warningMessage(QString("Failed to download \"%1\"!").arg(mLastDownloadingFile));
-                }
-                break;
+            // No other error or warning messages are expected through stdout,
+            // so it is likely that a parsing error occured.
+            emit warningMessage(QString(
+                        QObject::tr("Error when parsing scan progress output from stdout of the 'oscap' process. "
+                            "Newline encountered while reading rule ID, rule result and/or ':' are missing! "
+                            "Read buffer is '%1'.")).arg(message));
         }
-        mReadingState = RS_READING_PREFIX;
-        mReadBuffer = "";
+        return;
     }
-    else if ( (readChar == '.') && (mReadingState == RS_READING_DOWNLOAD_FILE) && (mReadBuffer.endsWith(" ..")))
-    {
-        int urlLen = mReadBuffer.length();
-        urlLen -= 1; // without first space
-        urlLen -= 3; // without "progress dots"
-        mLastDownloadingFile = mReadBuffer.mid(1, urlLen);
 
-        emit infoMessage(QString("Downloading of \"%1\"...").arg(mLastDownloadingFile));
+    const int ruleIDLength = colon - line;
+    const int resultLength = length - ruleIDLength - 1;
 
-        mReadBuffer = "";
-        mReadingState = RS_READING_DOWNLOAD_FILE_STATUS;
+    if (memchr(colon + 1, ':', resultLength))
+    {
+        emit warningMessage(QString(
+                    QObject::tr("Error when parsing scan progress output from stdout of the 'oscap' process. "
+                        "':' encountered while not reading rule ID, newline and/or rule result are missing! "
+                        "Read buffer is '%1'.")).arg(QString::fromLocal8Bit(line, length)));
+        return;
     }
-    else
+
+    // we know for sure that the line can only contain ASCII characters
+    // (IDs and special keywords regarding rule status)
+    const QString ruleID = QString::fromLatin1(line, ruleIDLength);
+    const QString result = QString::fromLatin1(colon + 1, resultLength);
+
+    // "processing" has already been reported if the line was split across chunks
+    lastRuleID = ruleID;
+
+    ruleIDs.append(ruleID);
+    results.append(result);
+
+    if (mRuleTiming.isStarted())
+        mRuleTiming.ruleFinished(ruleID);
+}
+
+void OscapScannerBase::parseStdOutPartialLine(const QByteArray& readBuffer, QString& lastRuleID,
+    QStringList& ruleIDs, QStringList& results)
+{
+    if (readBuffer.isEmpty())
+        return;
+
+    const char* line = readBuffer.constData();
+    const int length = readBuffer.size();
+
+    if (isDownloadingLine(line, length))
     {
-        // we know for sure that buffer[0] can only contain ASCII characters
-        // (IDs and special keywords regarding rule status)
-        mReadBuffer.append(QChar::fromAscii(readChar));
+        parseDownloadingLine(QString::fromLocal8Bit(line, length), false);
+        return;
     }
 
-    return true;
+    // "ruleID:" without the result means oscap is evaluating that rule right now
+    const char* colon = static_cast<const char*>(memchr(line, ':', length));
+    if (!colon)
+        return;
+
+    const QString ruleID = QString::fromLatin1(line, colon - line);
+    if (ruleID == lastRuleID)
+        return;
+
+    lastRuleID = ruleID;
+
+    ruleIDs.append(ruleID);
+    results.append("processing");
+
+    if (mRuleTiming.isStarted())
+        mRuleTiming.ruleStarted(ruleID);
 }
 
 void OscapScannerBase::readStdOut(QProcess& process)
+{
+    readStdOut(process, mReadBuffer, mLastRuleID);
+}
+
+void OscapScannerBase::readStdOut(QProcess& process, QByteArray& readBuffer, QString& lastRuleID)
 {
     process.setReadChannel(QProcess::StandardOutput);
 
-    while (tryToReadStdOutChar(process));
+    const QByteArray chunk = process.readAll();
+    if (chunk.isEmpty())
+        return;
+
+    if (!mCapabilities.progressReporting())
+        return; // We did read something but it's not in a format we can parse.
+
+    parseStdOutChunk(chunk, readBuffer, lastRuleID);
+}
+
+void OscapScannerBase::parseStdOutChunk(const QByteArray& chunk, QByteArray& readBuffer, QString& lastRuleID)
+{
+    readBuffer.append(chunk);
+
+    QStringList ruleIDs;
+    QStringList results;
+
+    const char* data = readBuffer.constData();
+    const int size = readBuffer.size();
+    int lineStart = 0;
+
+    while (lineStart < size)
+    {
+        const char* newline = static_cast<const char*>(memchr(data + lineStart, '\n', size - lineStart));
+        if (!newline)
+            break;
+
+        const int lineEnd = newline - data;
+        parseStdOutLine(data + lineStart, lineEnd - lineStart, lastRuleID, ruleIDs, results);
+        lineStart = lineEnd + 1;
+    }
+
+    // keep just the incomplete last line for the next chunk
+    readBuffer.remove(0, lineStart);
+    parseStdOutPartialLine(readBuffer, lastRuleID, ruleIDs, results);
+
+    if (!ruleIDs.isEmpty())
+    {
+        emit progressReportBatch(ruleIDs, results);
+        reportProgressEstimate();
+    }
+}
+
+void OscapScannerBase::waitForScanProcess(QProcess& process, bool killOnCancel)
+{
+    QEventLoop loop;
+    QObject::connect(
+        &process, SIGNAL(finished(int, QProcess::ExitStatus)),
+        &loop, SLOT(quit())
+    );
+    QObject::connect(
+        this, SIGNAL(cancelRequested()),
+        &loop, SLOT(quit())
+    );
+    QObject::connect(
+        &process, SIGNAL(readyReadStandardOutput()),
+        this, SLOT(readScanProcessStdOut())
+    );
+    QObject::connect(
+        &process, SIGNAL(readyReadStandardError()),
+        this, SLOT(readScanProcessStdErr())
+    );
+
+    mScanProcess = &process;
+
+    // the user might want to cancel, the event loop delivers that to us
+    if (process.state() != QProcess::NotRunning && !mCancelRequested)
+        loop.exec();
+
+    mScanProcess = 0;
+    QObject::disconnect(&process, 0, this, 0);
+
+    if (process.state() == QProcess::NotRunning || !mCancelRequested)
+        return;
+
+    emit infoMessage(QObject::tr("Cancellation was requested! Terminating scanning..."));
+
+    if (killOnCancel)
+    {
+        process.kill();
+        process.waitForFinished();
+        return;
+    }
+
+    // TODO: On Windows we have to kill immediately, terminate() posts WM_CLOSE
+    //       but oscap doesn't have any event loop running.
+    process.terminate();
+
+    // 10 seconds should be enough for the process to terminate
+    if (!process.waitForFinished(10000))
+    {
+        emit warningMessage(QObject::tr("The oscap process didn't terminate in time, it will be killed instead."));
+        // if it didn't terminate, we have to kill it at this point
+        process.kill();
+        process.waitForFinished();
+    }
+}
+
+void OscapScannerBase::readScanProcessStdOut()
+{
+    if (mScanProcess)
+        readStdOut(*mScanProcess);
+}
+
+void OscapScannerBase::readScanProcessStdErr()
+{
+    if (mScanProcess)
+        watchStdErr(*mScanProcess);
 }
 
 void OscapScannerBase::watchStdErr(QProcess& process)
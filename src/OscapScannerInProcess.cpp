@@ -0,0 +1,360 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "OscapScannerInProcess.h"
+#include "ScanningSession.h"
+#include "ScanArtifacts.h"
+#include "APIHelpers.h"
+#include "ScanTrace.h"
+
+#include <QCoreApplication>
+#include <QSettings>
+#include <QSet>
+
+extern "C"
+{
+#include <oscap.h>
+#include <xccdf_session.h>
+}
+
+/// How often at most the callbacks emit progressReportBatch, in milliseconds
+static const qint64 PROGRESS_FLUSH_INTERVAL = 100;
+
+OscapScannerInProcess::OscapScannerInProcess():
+    OscapScannerBase(),
+
+    mPolicy(0)
+{}
+
+OscapScannerInProcess::~OscapScannerInProcess()
+{
+    qDeleteAll(mAdditionalArtifacts);
+}
+
+bool OscapScannerInProcess::isEnabled()
+{
+    const QByteArray env = qgetenv("SCAP_WORKBENCH_IN_PROCESS_SCAN");
+    if (!env.isEmpty())
+        return env != "0";
+
+    QSettings settings;
+    return settings.value("in-process-local-scan", false).toBool();
+}
+
+bool OscapScannerInProcess::supports(ScannerMode mode, bool fetchRemoteResources)
+{
+    return mode == SM_SCAN && !fetchRemoteResources;
+}
+
+QStringList OscapScannerInProcess::getCommandLineArgs() const
+{
+    // No process is started, this is the equivalent oscap invocation (used only during dry runs)
+    QStringList args("oscap");
+
+    args += buildEvaluationArgs(mSession->getOpenedFilePath(),
+        mSession->getUserTailoringFilePath(),
+        "/tmp/xccdf-results.xml",
+        "/tmp/report.html",
+        "/tmp/arf.xml",
+        false,
+        // ignore capabilities because of dry-run
+        true
+    );
+
+    args.removeOne("--progress");
+
+    return args;
+}
+
+void OscapScannerInProcess::evaluate()
+{
+    if (mDryRun)
+    {
+        signalCompletion(mCancelRequested);
+        return;
+    }
+
+    // the library we are linked to is the one evaluating
+    mCapabilities.parse(QString("OpenSCAP library %1").arg(QString::fromUtf8(oscap_get_version())));
+
+    if (!supports(mScannerMode, mFetchRemoteResources))
+    {
+        emit errorMessage(QObject::tr("In-process evaluation supports only scanning without remediation "
+            "and without fetching remote resources."));
+
+        mCancelRequested = true;
+        signalCompletion(mCancelRequested);
+        return;
+    }
+
+    if (!checkPrerequisites())
+    {
+        mCancelRequested = true;
+        signalCompletion(mCancelRequested);
+        return;
+    }
+
+    struct xccdf_session* session = mSession->getXCCDFSession();
+    struct xccdf_policy_model* policyModel = xccdf_session_get_policy_model(session);
+
+    if (!policyModel || !xccdf_session_get_xccdf_policy(session))
+    {
+        emit errorMessage(QObject::tr("Can't evaluate in-process, the session has no policy loaded."));
+
+        mCancelRequested = true;
+        signalCompletion(mCancelRequested);
+        return;
+    }
+
+    const char* selectedProfileID = xccdf_session_get_profile_id(session);
+    const QString selectedProfile = selectedProfileID ? QString::fromUtf8(selectedProfileID) : QString();
+    qDeleteAll(mAdditionalArtifacts);
+    mAdditionalArtifacts.clear();
+
+    startRuleTiming();
+
+    xccdf_policy_model_register_start_callback(policyModel, &OscapScannerInProcess::ruleStartedCallback, this);
+    xccdf_policy_model_register_output_callback(policyModel, &OscapScannerInProcess::ruleFinishedCallback, this);
+
+    emit infoMessage(QObject::tr("Evaluating in-process..."));
+    bool evaluated = evaluateSelectedProfile(session, *mArtifacts);
+
+    // Rules of the additional profiles are evaluated mostly from the system
+    // characteristics collected above, their durations would skew the history.
+    finishRuleTiming();
+
+    for (QStringList::const_iterator it = mAdditionalProfiles.constBegin();
+         evaluated && it != mAdditionalProfiles.constEnd(); ++it)
+    {
+        emit infoMessage(QObject::tr("Evaluating profile '%1'...").arg(*it));
+
+        if (!xccdf_session_set_profile_id(session, it->isEmpty() ? NULL : it->toUtf8().constData()))
+        {
+            emit errorMessage(QObject::tr("Failed to select profile '%1' for evaluation.").arg(*it));
+            mCancelRequested = true;
+            break;
+        }
+
+        ScanArtifacts* artifacts = new ScanArtifacts();
+        evaluated = evaluateSelectedProfile(session, *artifacts);
+        if (evaluated)
+            mAdditionalArtifacts.insert(*it, artifacts);
+        else
+            delete artifacts;
+    }
+
+    // the session is shared, give it back with the profile the user selected
+    if (!mAdditionalProfiles.isEmpty())
+        xccdf_session_set_profile_id(session, selectedProfile.isEmpty() ? NULL : selectedProfile.toUtf8().constData());
+
+    // the policy model outlives this scanner, the callbacks must not
+    xccdf_policy_model_unregister_callbacks(policyModel, XCCDF_POLICY_OUTCB_START);
+    xccdf_policy_model_unregister_callbacks(policyModel, XCCDF_POLICY_OUTCB_END);
+
+    if (evaluated)
+        emit infoMessage(QObject::tr("Processing has been finished!"));
+
+    signalCompletion(mCancelRequested);
+}
+
+void OscapScannerInProcess::setAdditionalProfiles(const QStringList& profileIDs)
+{
+    mAdditionalProfiles = profileIDs;
+}
+
+const QStringList& OscapScannerInProcess::getAdditionalProfiles() const
+{
+    return mAdditionalProfiles;
+}
+
+ScanArtifacts* OscapScannerInProcess::takeAdditionalArtifacts(const QString& profileID)
+{
+    return mAdditionalArtifacts.take(profileID);
+}
+
+bool OscapScannerInProcess::evaluateSelectedProfile(struct xccdf_session* session, ScanArtifacts& artifacts)
+{
+    mPolicy = xccdf_session_get_xccdf_policy(session);
+    mSinceFlush.start();
+
+    ScanTrace::Span evaluationSpan("evaluation");
+    evaluationSpan.setArgument("profile", QString::fromUtf8(xccdf_session_get_profile_id(session)));
+    const int evaluationResult = xccdf_session_evaluate(session);
+    evaluationSpan.end();
+
+    mPolicy = 0;
+    flushProgress();
+
+    if (mCancelRequested)
+    {
+        emit infoMessage(QObject::tr("Scanning cancelled!"));
+        return false;
+    }
+
+    if (evaluationResult != 0)
+    {
+        emit errorMessage(QObject::tr("There was an error during evaluation! OpenSCAP error message:\n%1")
+            .arg(oscapErrGetFullError()));
+        // mark this run as canceled
+        mCancelRequested = true;
+        return false;
+    }
+
+    emit infoMessage(QObject::tr("Evaluation has finished. Exporting results..."));
+
+    ScanTrace::Span exportSpan("export results");
+    if (!exportResults(session, artifacts))
+    {
+        mCancelRequested = true;
+        return false;
+    }
+
+    return true;
+}
+
+int OscapScannerInProcess::ruleStartedCallback(struct xccdf_rule* rule, void* userData)
+{
+    OscapScannerInProcess* self = static_cast<OscapScannerInProcess*>(userData);
+
+    // the callback is called for every rule, oscap --progress reports just the selected ones
+    const char* id = xccdf_rule_get_id(rule);
+    if (self->mPolicy && xccdf_policy_is_item_selected(self->mPolicy, id))
+    {
+        const QString ruleID = QString::fromUtf8(id);
+
+        self->mPendingRuleIDs.append(ruleID);
+        self->mPendingResults.append("processing");
+
+        if (self->mRuleTiming.isStarted())
+            self->mRuleTiming.ruleStarted(ruleID);
+    }
+
+    // Evaluation blocks the scanning thread, this is where cancel requests
+    // and the progress estimate timer get delivered.
+    QCoreApplication::processEvents();
+
+    if (self->mSinceFlush.elapsed() >= PROGRESS_FLUSH_INTERVAL)
+        self->flushProgress();
+
+    // non-zero stops the evaluation
+    return self->mCancelRequested ? 1 : 0;
+}
+
+int OscapScannerInProcess::ruleFinishedCallback(struct xccdf_rule_result* ruleResult, void* userData)
+{
+    OscapScannerInProcess* self = static_cast<OscapScannerInProcess*>(userData);
+
+    const xccdf_test_result_type_t result = xccdf_rule_result_get_result(ruleResult);
+    if (result != XCCDF_RESULT_NOT_SELECTED)
+    {
+        const QString ruleID = QString::fromUtf8(xccdf_rule_result_get_idref(ruleResult));
+        const QString resultText = QString::fromUtf8(xccdf_test_result_type_get_text(result));
+
+        self->mPendingRuleIDs.append(ruleID);
+        self->mPendingResults.append(resultText);
+
+        if (self->mRuleTiming.isStarted())
+            self->mRuleTiming.ruleFinished(ruleID);
+    }
+
+    return self->mCancelRequested ? 1 : 0;
+}
+
+void OscapScannerInProcess::flushProgress()
+{
+    mSinceFlush.restart();
+
+    if (mPendingRuleIDs.isEmpty())
+        return;
+
+    emit progressReportBatch(mPendingRuleIDs, mPendingResults);
+    mPendingRuleIDs.clear();
+    mPendingResults.clear();
+
+    reportProgressEstimate();
+}
+
+bool OscapScannerInProcess::exportResults(struct xccdf_session* session, ScanArtifacts& artifacts)
+{
+    struct xccdf_benchmark* benchmark = xccdf_policy_model_get_benchmark(xccdf_session_get_policy_model(session));
+
+    // Exporting XCCDF results adds the TestResult to the benchmark of the
+    // session. The session is shared with the rest of the application, these
+    // TestResults have to be removed once exported.
+    QSet<struct xccdf_result*> previousTestResults;
+    {
+        struct xccdf_result_iterator* it = xccdf_benchmark_get_results(benchmark);
+        while (xccdf_result_iterator_has_more(it))
+            previousTestResults.insert(xccdf_result_iterator_next(it));
+        xccdf_result_iterator_free(it);
+    }
+
+    // exported straight into the artifacts, nothing is read back
+    artifacts.clear();
+    const QString resultPath = artifacts.getPath(ScanArtifacts::ARTIFACT_RESULTS);
+    const QString reportPath = artifacts.getPath(ScanArtifacts::ARTIFACT_REPORT);
+    const QString arfPath = artifacts.getPath(ScanArtifacts::ARTIFACT_ARF);
+
+    xccdf_session_set_xccdf_export(session, resultPath.toUtf8().constData());
+    xccdf_session_set_report_export(session, reportPath.toUtf8().constData());
+    xccdf_session_set_arf_export(session, arfPath.toUtf8().constData());
+
+    // same order as oscap xccdf eval, the ARF needs the OVAL results
+    const bool exported =
+        xccdf_session_export_oval(session) == 0 &&
+        xccdf_session_export_check_engine_plugins(session) == 0 &&
+        xccdf_session_export_xccdf(session) == 0 &&
+        xccdf_session_export_arf(session) == 0;
+
+    xccdf_session_set_xccdf_export(session, NULL);
+    xccdf_session_set_report_export(session, NULL);
+    xccdf_session_set_arf_export(session, NULL);
+
+    {
+        struct xccdf_result_iterator* it = xccdf_benchmark_get_results(benchmark);
+        while (xccdf_result_iterator_has_more(it))
+        {
+            if (!previousTestResults.contains(xccdf_result_iterator_next(it)))
+                xccdf_result_iterator_remove(it);
+        }
+        xccdf_result_iterator_free(it);
+    }
+
+    if (!exported)
+    {
+        emit errorMessage(QObject::tr("Failed to export results of the evaluation. OpenSCAP error message:\n%1")
+            .arg(oscapErrGetFullError()));
+        return false;
+    }
+
+    if (!artifacts.has(ScanArtifacts::ARTIFACT_RESULTS) || !artifacts.has(ScanArtifacts::ARTIFACT_ARF))
+    {
+        emit errorMessage(QObject::tr("OpenSCAP did not export the results to '%1'.").arg(resultPath));
+        return false;
+    }
+
+    // the report is not essential, results can be saved without it
+    if (!artifacts.has(ScanArtifacts::ARTIFACT_REPORT))
+        emit warningMessage(QObject::tr("OpenSCAP did not generate the HTML report."));
+
+    return true;
+}
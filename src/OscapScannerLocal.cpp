@@ -23,25 +23,71 @@
 #include "ProcessHelpers.h"
 #include "ScanningSession.h"
 #include "TemporaryDir.h"
+#include "ScanTrace.h"
+#include "ScanArtifacts.h"
+#include "ScratchSpace.h"
 
 #include <stdexcept>
 #include <QThread>
-#include <QAbstractEventDispatcher>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QProcessEnvironment>
+#include <QEventLoop>
 
 extern "C"
 {
 #include <xccdf_session.h>
 }
 
-void OscapScannerLocal::setFilenameToTempFile(QTemporaryFile& file)
+// Automatically chosen shard count never exceeds this, every oscap process
+// loads the whole content and that takes a lot of memory
+static const int MAX_AUTO_SHARD_COUNT = 16;
+// Shards with fewer rules are not worth the overhead of another oscap process
+static const int MIN_RULES_PER_SHARD = 16;
+
+/**
+ * @brief Returns path, size and modification time of the oscap binary found in $PATH
+ *
+ * Empty string is returned if oscap can't be found.
+ */
+static QString getLocalOscapIdentity()
 {
-    file.open();
-    file.close();
-}
+#ifdef WIN32
+    const QStringList dirs = QProcessEnvironment::systemEnvironment().value("PATH").split(';', QString::SkipEmptyParts);
+    const QString fileName = SCAP_WORKBENCH_LOCAL_OSCAP_PATH ".exe";
+#else
+    const QStringList dirs = QProcessEnvironment::systemEnvironment().value("PATH").split(':', QString::SkipEmptyParts);
+    const QString fileName = SCAP_WORKBENCH_LOCAL_OSCAP_PATH;
+#endif
+
+    for (QStringList::const_iterator it = dirs.constBegin(); it != dirs.constEnd(); ++it)
+    {
+        const QFileInfo info(QDir(*it).absoluteFilePath(fileName));
+        if (info.isFile() && info.isExecutable())
+        {
+            return QString("%1 %2 %3").arg(info.canonicalFilePath())
+                .arg(info.size()).arg(info.lastModified().toTime_t());
+        }
+    }
 
+    return QString();
+}
 
 void OscapScannerLocal::fillInCapabilities()
 {
+    const QString identity = getLocalOscapIdentity();
+
+    QString cachedIdentity;
+    QString cachedOutput;
+    if (!identity.isEmpty() &&
+        OscapCapabilitiesCache::lookup(mTarget, cachedIdentity, cachedOutput) &&
+        cachedIdentity == identity)
+    {
+        mCapabilities.parse(cachedOutput);
+        return;
+    }
+
     SyncProcess proc(this);
     proc.setCommand(SCAP_WORKBENCH_LOCAL_OSCAP_PATH);
     proc.setArguments(QStringList("-V"));
@@ -58,6 +104,7 @@ void OscapScannerLocal::fillInCapabilities()
     }
 
     mCapabilities.parse(proc.getStdOutContents());
+    OscapCapabilitiesCache::store(mTarget, identity, proc.getStdOutContents());
 }
 
 void OscapScannerLocal::evaluate()
@@ -71,6 +118,7 @@ void OscapScannerLocal::evaluate()
     emit infoMessage(QObject::tr("Querying capabilities..."));
     try
     {
+        ScanTrace::Span capabilitiesSpan("capabilities");
         fillInCapabilities();
     }
     catch (std::exception& e)
@@ -81,11 +129,23 @@ void OscapScannerLocal::evaluate()
 
     if (!checkPrerequisites())
     {
+        // the cached capabilities could be stale, query them again next time
+        OscapCapabilitiesCache::invalidate(mTarget);
+
         mCancelRequested = true;
         signalCompletion(mCancelRequested);
         return;
     }
 
+    startRuleTiming();
+
+    const QList<QStringList> shards = planShards();
+    if (!shards.isEmpty())
+    {
+        evaluateSharded(shards);
+        return;
+    }
+
     // TODO: Error handling!
     // This is mainly for check-engine-results and oval-results, to ensure
     // we get a full report, including info from these files. openscap's XSLT
@@ -94,51 +154,42 @@ void OscapScannerLocal::evaluate()
     QProcess process(this);
 
     emit infoMessage(QObject::tr("Creating temporary files..."));
+    ScanTrace::Span temporaryFilesSpan("create temporary files");
     // This is mainly for check-engine-results and oval-results, to ensure
     // we get a full report, including info from these files. openscap's XSLT
     // uses info in the check engine results if it can find them.
-    TemporaryDir workingDir;
+    TemporaryDir workingDir(ScratchSpace::getDirectory());
     process.setWorkingDirectory(workingDir.getPath());
 
     QStringList args;
-    QTemporaryFile inputARFFile;
-
-    QTemporaryFile arfFile;
-    arfFile.setAutoRemove(true);
-    setFilenameToTempFile(arfFile);
-
-    QTemporaryFile reportFile;
-    reportFile.setAutoRemove(true);
-    setFilenameToTempFile(reportFile);
-
-    QTemporaryFile resultFile;
-    resultFile.setAutoRemove(true);
-    setFilenameToTempFile(resultFile);
 
+    // oscap writes the results straight into the artifacts, nothing is read back
+    mArtifacts->clear();
+    const QString resultFile = mArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS);
+    const QString reportFile = mArtifacts->getPath(ScanArtifacts::ARTIFACT_REPORT);
+    const QString arfFile = mArtifacts->getPath(ScanArtifacts::ARTIFACT_ARF);
 
     if (mScannerMode == SM_OFFLINE_REMEDIATION)
     {
-        inputARFFile.open();
-        inputARFFile.write(getARFForRemediation());
-        inputARFFile.close();
-
-        args = buildOfflineRemediationArgs(inputARFFile.fileName(),
-                resultFile.fileName(),
-                reportFile.fileName(),
-                arfFile.fileName());
+        args = buildOfflineRemediationArgs(getPreviousARFPath(),
+                resultFile,
+                reportFile,
+                arfFile);
     }
     else
     {
-        args = buildEvaluationArgs(mSession->getOpenedFilePath(),
-                mSession->hasTailoring() ? mSession->getTailoringFilePath() : QString(),
-                resultFile.fileName(),
-                reportFile.fileName(),
-                arfFile.fileName(),
+        args = buildEvaluationArgs(mInputFile,
+                mTailoringFile,
+                resultFile,
+                reportFile,
+                arfFile,
                 mScannerMode == SM_SCAN_ONLINE_REMEDIATION);
     }
     QString program = getOscapProgramAndAdaptArgs(args);
+    temporaryFilesSpan.end();
 
     emit infoMessage(QObject::tr("Starting the oscap process..."));
+    ScanTrace::Span evaluationSpan("evaluation");
     process.start(program, args);
     process.waitForStarted();
 
@@ -148,25 +199,8 @@ void OscapScannerLocal::evaluate()
         mCancelRequested = true;
     }
 
-    unsigned int pollInterval = 100;
-
     emit infoMessage(QObject::tr("Processing..."));
-    while (!process.waitForFinished(pollInterval))
-    {
-        // read everything new
-        readStdOut(process);
-        watchStdErr(process);
-
-        // pump the event queue, mainly because the user might want to cancel
-        QAbstractEventDispatcher::instance(mScanThread)->processEvents(QEventLoop::AllEvents);
-
-        if (mCancelRequested)
-        {
-            pollInterval = 1000;
-            emit infoMessage(QObject::tr("Cancellation was requested! Terminating scanning..."));
-            process.kill();
-        }
-    }
+    waitForScanProcess(process, true);
 
     if (!mCancelRequested)
     {
@@ -183,34 +217,350 @@ void OscapScannerLocal::evaluate()
             // read everything left over
             readStdOut(process);
             watchStdErr(process);
+            evaluationSpan.end();
 
-            emit infoMessage(QObject::tr("The oscap tool has finished. Reading results..."));
+            emit infoMessage(QObject::tr("The oscap tool has finished."));
 
-            resultFile.open();
-            mResults = resultFile.readAll();
-            resultFile.close();
+            if (mScannerMode == SM_RESCAN_FAILED)
+            {
+                ScanTrace::Span spliceSpan("splice results");
+                spliceRescanResults();
+            }
 
-            reportFile.open();
-            mReport = reportFile.readAll();
-            reportFile.close();
+            if (!mCancelRequested)
+                emit infoMessage(QObject::tr("Processing has been finished!"));
+        }
+    }
+    else
+    {
+        emit infoMessage(QObject::tr("Scanning cancelled!"));
+    }
 
-            arfFile.open();
-            mARF = arfFile.readAll();
-            arfFile.close();
+    signalCompletion(mCancelRequested);
+}
 
-            emit infoMessage(QObject::tr("Processing has been finished!"));
+int OscapScannerLocal::getMaxShardCount()
+{
+    const QByteArray override = qgetenv("SCAP_WORKBENCH_LOCAL_SCAN_SHARDS");
+    if (!override.isEmpty())
+    {
+        bool ok = false;
+        const int count = override.toInt(&ok);
+        if (ok && count >= 1)
+            return count;
+    }
+
+    return qBound(1, QThread::idealThreadCount(), MAX_AUTO_SHARD_COUNT);
+}
+
+QList<QStringList> OscapScannerLocal::planShards() const
+{
+    QList<QStringList> ret;
+
+    // Remediation changes the system, rules could affect each other
+    if (mScannerMode != SM_SCAN || !mCapabilities.multipleRuleFilters())
+        return ret;
+
+    const int maxShardCount = getMaxShardCount();
+    if (maxShardCount < 2)
+        return ret;
+
+    const int shardCount = qMin(maxShardCount, mSelectedRuleIDs.size() / MIN_RULES_PER_SHARD);
+    if (shardCount < 2)
+        return ret;
+
+    for (int i = 0; i < shardCount; ++i)
+        ret.append(QStringList());
+
+    // Neighbouring rules tend to be similarly expensive (the same group),
+    // dealing them round robin balances the shards.
+    for (int i = 0; i < mSelectedRuleIDs.size(); ++i)
+        ret[i % shardCount].append(mSelectedRuleIDs.at(i));
+
+    return ret;
+}
+
+void OscapScannerLocal::evaluateSharded(const QList<QStringList>& shards)
+{
+    emit infoMessage(QObject::tr("Creating temporary files..."));
+    ScanTrace::Span temporaryFilesSpan("create temporary files");
+
+    const QString scratchDirectory = ScratchSpace::getDirectory();
+
+    for (int i = 0; i < shards.size(); ++i)
+    {
+        Shard shard;
+        shard.workingDir = new TemporaryDir(scratchDirectory);
+        shard.resultFile = shard.workingDir->getPath() + "/xccdf-results.xml";
+        shard.arfFile = shard.workingDir->getPath() + "/arf.xml";
+
+        // the report is generated from the merged ARF
+        shard.args = buildEvaluationArgs(mInputFile,
+                mTailoringFile,
+                shard.resultFile,
+                QString(),
+                shard.arfFile,
+                false,
+                false,
+                shards[i]);
+
+        // oval results are written to the working directory, each shard needs its own
+        shard.process = new QProcess(this);
+        shard.process->setWorkingDirectory(shard.workingDir->getPath());
+        shard.started = false;
+
+        QObject::connect(
+            shard.process, SIGNAL(readyReadStandardOutput()),
+            this, SLOT(readShardStdOut())
+        );
+        QObject::connect(
+            shard.process, SIGNAL(readyReadStandardError()),
+            this, SLOT(readShardStdErr())
+        );
+        QObject::connect(
+            shard.process, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(shardFinished())
+        );
+
+        mShards.append(shard);
+    }
+
+    temporaryFilesSpan.end();
+
+    emit infoMessage(QObject::tr("Starting %1 oscap processes, each evaluating a part of the rules...").arg(mShards.size()));
+
+    QEventLoop loop;
+    QObject::connect(
+        this, SIGNAL(cancelRequested()),
+        &loop, SLOT(quit())
+    );
+    mShardLoop = &loop;
+    mRunningShards = 0;
+    mShardElevation = SHARD_ELEVATION_UNKNOWN;
+
+    ScanTrace::Span evaluationSpan("evaluation");
+    evaluationSpan.setArgument("processes", QString::number(mShards.size()));
+
+    startShard(0);
+
+    emit infoMessage(QObject::tr("Processing..."));
+    if (mRunningShards > 0 && !mCancelRequested)
+        loop.exec();
+
+    mShardLoop = 0;
+    evaluationSpan.end();
+
+    if (mCancelRequested)
+    {
+        emit infoMessage(QObject::tr("Cancellation was requested! Terminating scanning..."));
+
+        for (QList<Shard>::iterator it = mShards.begin(); it != mShards.end(); ++it)
+        {
+            QObject::disconnect(it->process, 0, this, 0);
+            if (it->process->state() != QProcess::NotRunning)
+            {
+                it->process->kill();
+                it->process->waitForFinished();
+            }
         }
+
+        emit infoMessage(QObject::tr("Scanning cancelled!"));
     }
     else
     {
-        emit infoMessage(QObject::tr("Scanning cancelled!"));
+        for (QList<Shard>::iterator it = mShards.begin(); it != mShards.end(); ++it)
+        {
+            if (!it->started)
+            {
+                // the first process has failed before it could tell how to run the rest
+                emit errorMessage(QObject::tr("There was an error during evaluation! Not all oscap processes could be started."));
+                mCancelRequested = true;
+                break;
+            }
+            if (it->process->exitCode() == 126) // the wrapper refused to run unprivileged
+            {
+                emit errorMessage(QObject::tr("Failed to elevate privileges of all oscap processes. "
+                    "The scan has been stopped so that rules are not evaluated with different privileges."));
+                mCancelRequested = true;
+                break;
+            }
+            if (it->process->exitCode() == 1) // error happened
+            {
+                emit errorMessage(QObject::tr("There was an error during evaluation! Exit code of the 'oscap' process was 1."));
+                // mark this run as canceled
+                mCancelRequested = true;
+                break;
+            }
+        }
+
+        if (!mCancelRequested)
+            mergeShardResults();
     }
 
+    for (QList<Shard>::iterator it = mShards.begin(); it != mShards.end(); ++it)
+    {
+        delete it->process;
+        delete it->workingDir;
+    }
+    mShards.clear();
+
     signalCompletion(mCancelRequested);
 }
 
+void OscapScannerLocal::startShard(int index)
+{
+    Shard& shard = mShards[index];
+
+    QStringList args = shard.args;
+    QString program;
+    if (index == 0)
+    {
+        args.prepend("--report-elevation");
+        program = getOscapProgramAndAdaptArgs(args);
+    }
+    else if (mShardElevation == SHARD_ELEVATION_ELEVATED)
+    {
+        // authentication is kept by polkit, the user is not asked again
+        args.prepend("--require-elevation");
+        program = getOscapProgramAndAdaptArgs(args);
+    }
+    else
+        program = getUnprivilegedOscapProgramAndAdaptArgs(args);
+
+    shard.started = true;
+    shard.process->start(program, args);
+    shard.process->waitForStarted();
+
+    if (shard.process->state() != QProcess::Running)
+    {
+        emit errorMessage(QObject::tr("Failed to start local scanning process '%1'. Perhaps the executable was not found?").arg(program));
+        mCancelRequested = true;
+
+        if (mShardLoop)
+            mShardLoop->quit();
+
+        return;
+    }
+
+    ++mRunningShards;
+}
+
+void OscapScannerLocal::startRemainingShards()
+{
+    if (mShardElevation == SHARD_ELEVATION_UNPRIVILEGED)
+        emit infoMessage(QObject::tr("oscap runs without elevated privileges, the remaining processes will too."));
+
+    for (int i = 1; i < mShards.size() && !mCancelRequested; ++i)
+        startShard(i);
+}
+
+bool OscapScannerLocal::readShardElevation(QProcess& process)
+{
+    static const QByteArray marker = "scap-workbench-elevated: ";
+
+    process.setReadChannel(QProcess::StandardError);
+    if (!process.canReadLine())
+        return false;
+
+    // anything else is left to watchStdErr
+    const QByteArray available = process.peek(process.bytesAvailable());
+    if (!available.startsWith(marker))
+        return false;
+
+    const QByteArray line = process.readLine().trimmed();
+    mShardElevation = line.mid(marker.size()) == "1" ? SHARD_ELEVATION_ELEVATED : SHARD_ELEVATION_UNPRIVILEGED;
+
+    return true;
+}
+
+int OscapScannerLocal::findShard(QObject* process) const
+{
+    for (int i = 0; i < mShards.size(); ++i)
+    {
+        if (mShards[i].process == process)
+            return i;
+    }
+
+    return -1;
+}
+
+void OscapScannerLocal::readShardStdOut()
+{
+    const int index = findShard(sender());
+    if (index == -1)
+        return;
+
+    Shard& shard = mShards[index];
+    readStdOut(*shard.process, shard.readBuffer, shard.lastRuleID);
+}
+
+void OscapScannerLocal::readShardStdErr()
+{
+    const int index = findShard(sender());
+    if (index == -1)
+        return;
+
+    QProcess& process = *mShards[index].process;
+
+    // the first process has got past authentication, the rest can start now
+    if (index == 0 && mShardElevation == SHARD_ELEVATION_UNKNOWN && readShardElevation(process))
+        startRemainingShards();
+
+    watchStdErr(process);
+}
+
+void OscapScannerLocal::shardFinished()
+{
+    const int index = findShard(sender());
+    if (index == -1)
+        return;
+
+    Shard& shard = mShards[index];
+
+    // the first process may have finished before its stderr was read
+    const bool elevationRead = index == 0 && mShardElevation == SHARD_ELEVATION_UNKNOWN &&
+        readShardElevation(*shard.process);
+
+    // read everything left over
+    readStdOut(*shard.process, shard.readBuffer, shard.lastRuleID);
+    watchStdErr(*shard.process);
+
+    --mRunningShards;
+
+    // without the elevation report the wrapper has failed, the rest is not started
+    if (elevationRead)
+        startRemainingShards();
+
+    if (mRunningShards == 0 && mShardLoop)
+        mShardLoop->quit();
+}
+
+void OscapScannerLocal::mergeShardResults()
+{
+    emit infoMessage(QObject::tr("The oscap processes have finished. Merging results..."));
+
+    QStringList resultFiles;
+    QStringList arfFiles;
+    for (QList<Shard>::const_iterator it = mShards.constBegin(); it != mShards.constEnd(); ++it)
+    {
+        resultFiles.append(it->resultFile);
+        arfFiles.append(it->arfFile);
+    }
+
+    ScanTrace::Span mergeSpan("merge results");
+    mergeResults(resultFiles, arfFiles);
+    mergeSpan.end();
+
+    if (!mCancelRequested)
+        emit infoMessage(QObject::tr("Processing has been finished!"));
+}
+
 OscapScannerLocal::OscapScannerLocal():
-    OscapScannerBase()
+    OscapScannerBase(),
+
+    mRunningShards(0),
+    mShardLoop(0),
+    mShardElevation(SHARD_ELEVATION_UNKNOWN)
 {}
 
 OscapScannerLocal::~OscapScannerLocal()
@@ -223,13 +573,7 @@ QStringList OscapScannerLocal::getCommandLineArgs() const
 
     if (mScannerMode == SM_OFFLINE_REMEDIATION)
     {
-        QTemporaryFile inputARFFile;
-        inputARFFile.setAutoRemove(true);
-        inputARFFile.open();
-        inputARFFile.write(getARFForRemediation());
-        inputARFFile.close();
-
-        args += buildOfflineRemediationArgs(inputARFFile.fileName(),
+        args += buildOfflineRemediationArgs(getPreviousARFPath(),
             "/tmp/xccdf-results.xml",
             "/tmp/report.html",
             "/tmp/arf.xml",
@@ -265,6 +609,21 @@ QString OscapScannerLocal::getPkexecOscapPath()
         return path;
 }
 
+QString OscapScannerLocal::getUnprivilegedOscapProgramAndAdaptArgs(QStringList& args)
+{
+    QString program;
+#ifdef SCAP_WORKBENCH_LOCAL_NICE_FOUND
+    args.prepend(SCAP_WORKBENCH_LOCAL_OSCAP_PATH);
+    args.prepend(QString::number(SCAP_WORKBENCH_LOCAL_OSCAP_NICENESS));
+    args.prepend("-n");
+
+    program = SCAP_WORKBENCH_LOCAL_NICE_PATH;
+#else
+    program = SCAP_WORKBENCH_LOCAL_OSCAP_PATH;
+#endif
+    return program;
+}
+
 QString OscapScannerLocal::getOscapProgramAndAdaptArgs(QStringList& args)
 {
     QString program;
@@ -20,14 +20,20 @@
  */
 
 #include "OscapScannerRemoteSsh.h"
+#include "ArchiveHelpers.h"
 #include "Exceptions.h"
 #include "ScanningSession.h"
+#include "ScanTrace.h"
+#include "ScanArtifacts.h"
+#include "ScratchSpace.h"
+#include "Utils.h"
 
 #include <QThread>
-#include <QAbstractEventDispatcher>
 #include <QTemporaryFile>
 #include <QFileInfo>
 #include <QDir>
+#include <QFile>
+#include <QMap>
 #include <cassert>
 
 extern "C"
@@ -36,11 +42,39 @@ extern "C"
 #include <xccdf_benchmark.h>
 }
 
+// Names of the files inside the remote working directory
+#define REMOTE_INPUT_FILE "input.xml"
+#define REMOTE_TAILORING_FILE "tailoring.xml"
+#define REMOTE_RESULT_FILE "xccdf-results.xml"
+#define REMOTE_REPORT_FILE "report.html"
+#define REMOTE_ARF_FILE "arf.xml"
+
+// Input files are cached on the remote machine, named by the hash of their contents
+#define REMOTE_CACHE_DIR "\"${XDG_CACHE_HOME:-$HOME/.cache}/scap-workbench/content\""
+// Least recently used files are removed when the cache grows over this size, in bytes
+#define REMOTE_CACHE_SIZE_LIMIT "536870912"
+
+// Exit codes of the bootstrap script
+static const int BOOTSTRAP_NO_OSCAP = 100;
+static const int BOOTSTRAP_NO_TEMP_DIR = 101;
+static const int BOOTSTRAP_NO_CAPABILITIES = 102;
+
+// Exit codes of the evaluation script when it fails before oscap is started,
+// oscap itself exits with 0, 1 (error) or 2 (some rules failed)
+static const int EVALUATE_NO_WORKING_DIR = 103;
+static const int EVALUATE_UPLOAD_FAILED = 104;
+static const int EVALUATE_TAILORING_FAILED = 105;
+// ssh exits with this code if the connection failed
+static const int SSH_FAILED = 255;
+
 OscapScannerRemoteSsh::OscapScannerRemoteSsh():
     OscapScannerBase(),
-    mSshConnection(this)
+    mSshConnection(this),
+    mRemoteGzipAvailable(false)
 {
     mSshConnection.setCancelRequestSource(&mCancelRequested);
+    // consecutive scans of the same machine reuse the connection
+    mSshConnection.setPooled(true);
 }
 
 OscapScannerRemoteSsh::~OscapScannerRemoteSsh()
@@ -92,7 +126,7 @@ void OscapScannerRemoteSsh::setSession(ScanningSession* session)
 {
     OscapScannerBase::setSession(session);
 
-    if (!mSession->isSDS())
+    if (!mInputIsSDS)
         throw OscapScannerRemoteSshException("You can only use source datastreams for scanning remotely! "
             "Remote scanning using plain XCCDF and OVAL files has not been implemented in SCAP Workbench yet.");
 }
@@ -105,13 +139,7 @@ QStringList OscapScannerRemoteSsh::getCommandLineArgs() const
 
     if (mScannerMode == SM_OFFLINE_REMEDIATION)
     {
-        QTemporaryFile inputARFFile;
-        inputARFFile.setAutoRemove(true);
-        inputARFFile.open();
-        inputARFFile.write(getARFForRemediation());
-        inputARFFile.close();
-
-        args += buildOfflineRemediationArgs(inputARFFile.fileName(),
+        args += buildOfflineRemediationArgs(getPreviousARFPath(),
             "/tmp/xccdf-results.xml",
             "/tmp/report.html",
             "/tmp/arf.xml",
@@ -145,7 +173,9 @@ void OscapScannerRemoteSsh::evaluate()
         return;
     }
 
+    ScanTrace::Span connectSpan("connect");
     ensureConnected();
+    connectSpan.end();
 
     if (mCancelRequested)
     {
@@ -153,112 +183,178 @@ void OscapScannerRemoteSsh::evaluate()
         return;
     }
 
+    // Results for offline remediation are different every time, caching them makes no sense
+    QString contentHash;
+    if (mScannerMode != SM_OFFLINE_REMEDIATION)
     {
-        SshSyncProcess proc(mSshConnection, this);
-        emit infoMessage(QObject::tr("Checking if oscap is available on remote machine..."));
-
-        proc.setCommand(QString("command"));
-        proc.setArguments(QStringList() << "-v" << SCAP_WORKBENCH_REMOTE_OSCAP_PATH);
-        proc.setCancelRequestSource(&mCancelRequested);
-        proc.run();
-
-        if (proc.getExitCode() != 0)
-        {
-            emit errorMessage(
-                QObject::tr("Failed to locate oscap on remote machine. "
-                        "Please, check that openscap-scanner is installed on the remote machine.")
-            );
-
-            mCancelRequested = true;
-            signalCompletion(mCancelRequested);
-            return;
-        }
-
-        emit infoMessage(QObject::tr("Querying capabilities on remote machine..."));
-        proc.setCommand(SCAP_WORKBENCH_REMOTE_OSCAP_PATH);
-        proc.setArguments(QStringList("-V"));
-        proc.setCancelRequestSource(&mCancelRequested);
-        proc.run();
+        ScanTrace::Span hashSpan("content hash");
+        contentHash = computeFileHash(mInputFile);
+    }
 
-        if (proc.getExitCode() != 0)
-        {
-            emit errorMessage(
-                QObject::tr("Failed to query capabilities of oscap on remote machine.\n"
-                        "Diagnostic info:\n%1").arg(proc.getDiagnosticInfo())
-            );
+    emit infoMessage(QObject::tr("Querying capabilities on remote machine..."));
 
-            mCancelRequested = true;
-            signalCompletion(mCancelRequested);
-            return;
-        }
+    QString workingDir;
+    bool contentCached = false;
+    ScanTrace::Span bootstrapSpan("capabilities and working directory");
+    const bool bootstrapped = bootstrapRemoteSession(workingDir, contentHash, contentCached);
+    bootstrapSpan.setArgument("content cached", contentCached ? "yes" : "no");
+    bootstrapSpan.end();
 
-        mCapabilities.parse(proc.getStdOutContents());
+    if (!bootstrapped)
+    {
+        mCancelRequested = true;
+        signalCompletion(mCancelRequested);
+        return;
     }
 
     if (!checkPrerequisites())
     {
+        // the cached capabilities could be stale, query them again next time
+        OscapCapabilitiesCache::invalidate(mTarget);
+        removeRemoteWorkingDirectory(workingDir);
+
         mCancelRequested = true;
         signalCompletion(mCancelRequested);
         return;
     }
 
-    QStringList baseArgs;
-    baseArgs.append("-o"); baseArgs.append(QString("ControlPath=%1").arg(mSshConnection._getMasterSocket()));
-    baseArgs.append(mTarget);
-
-    QString diagnosticInfo;
+    startRuleTiming();
 
-    emit infoMessage(QObject::tr("Copying input data to remote target..."));
+    QString localInputFile;
 
-    const QString inputFile = copyInputFileOver();
-    const QString tailoringFile = mSession->hasTailoring() ?
-        copyFileOver(mSession->getTailoringFilePath()) : QString();
+    QStringList args;
 
-    if (mCancelRequested)
+    if (mScannerMode == SM_OFFLINE_REMEDIATION)
     {
-        signalCompletion(true);
-        return;
+        localInputFile = getPreviousARFPath();
+
+        args = buildOfflineRemediationArgs(REMOTE_INPUT_FILE,
+                REMOTE_RESULT_FILE,
+                REMOTE_REPORT_FILE,
+                REMOTE_ARF_FILE);
     }
+    else
+    {
+        localInputFile = mInputFile;
 
-    const QString reportFile = createRemoteTemporaryFile();
-    const QString resultFile = createRemoteTemporaryFile();
-    const QString arfFile = createRemoteTemporaryFile();
-    const QString workingDir = createRemoteTemporaryDirectory();
+        args = buildEvaluationArgs(REMOTE_INPUT_FILE,
+                mTailoringFile.isEmpty() ? QString() : REMOTE_TAILORING_FILE,
+                REMOTE_RESULT_FILE,
+                REMOTE_REPORT_FILE,
+                REMOTE_ARF_FILE,
+                mScannerMode == SM_SCAN_ONLINE_REMEDIATION);
+    }
 
-    // TODO: We could be leaking any of the temporary files at this point!
-    if (mCancelRequested)
+    // Everything up to the evaluation happens in this one invocation. The
+    // input file (unless it is cached) and the tailoring file are uploaded
+    // as a tar archive over stdin, the command line stays short no matter
+    // how big they are.
+    QMap<QString, QString> uploadFiles;
+    if (!contentCached)
+        uploadFiles.insert(REMOTE_INPUT_FILE, localInputFile);
+    const bool uploadTailoring = mScannerMode != SM_OFFLINE_REMEDIATION && !mTailoringFile.isEmpty();
+    if (uploadTailoring)
+        uploadFiles.insert(REMOTE_TAILORING_FILE, mTailoringFile);
+
+    QTemporaryFile uploadFile(ScratchSpace::getFileTemplate());
+    if (!uploadFiles.isEmpty())
     {
-        signalCompletion(true);
-        return;
-    }
+        ScanTrace::Span archiveSpan("archive input");
+        try
+        {
+            if (!uploadFile.open())
+                throw ArchiveHelpersException("Failed to create a temporary file.");
 
-    QStringList args;
+            writeTarArchive(uploadFiles, uploadFile);
+            uploadFile.close();
+        }
+        catch (const ArchiveHelpersException& e)
+        {
+            emit errorMessage(QObject::tr("Failed to prepare input data for the upload. "
+                "Exception was: %1").arg(QString::fromUtf8(e.what())));
+            removeRemoteWorkingDirectory(workingDir);
 
-    if (mScannerMode == SM_OFFLINE_REMEDIATION)
+            mCancelRequested = true;
+            signalCompletion(mCancelRequested);
+            return;
+        }
+    }
+
+    // SCAP content compresses very well, the upload is gzip compressed
+    // whenever both sides support it.
+    QTemporaryFile compressedUploadFile(ScratchSpace::getFileTemplate());
+    QString localUploadFile = uploadFile.fileName();
+    bool compressUpload = !uploadFiles.isEmpty() && mRemoteGzipAvailable && isGzipSupported();
+    if (compressUpload)
     {
-        args = buildOfflineRemediationArgs(inputFile,
-                resultFile,
-                reportFile,
-                arfFile);
+        ScanTrace::Span compressSpan("compress input");
+        try
+        {
+            if (!uploadFile.open())
+                throw ArchiveHelpersException(QString("Failed to open '%1'.").arg(uploadFile.fileName()));
+            if (!compressedUploadFile.open())
+                throw ArchiveHelpersException("Failed to create a temporary file.");
+
+            gzipCompress(uploadFile, compressedUploadFile);
+            uploadFile.close();
+            compressedUploadFile.close();
+
+            localUploadFile = compressedUploadFile.fileName();
+        }
+        catch (const ArchiveHelpersException& e)
+        {
+            emit warningMessage(QObject::tr("Failed to compress input data, they will be uploaded uncompressed. "
+                "Exception was: %1").arg(QString::fromUtf8(e.what())));
+            uploadFile.close();
+            compressUpload = false;
+        }
     }
-    else
+
+    QString script = QString("cd %1 || exit %2\n").arg(shellQuote(workingDir)).arg(EVALUATE_NO_WORKING_DIR);
+    if (!uploadFiles.isEmpty())
     {
-        args = buildEvaluationArgs(inputFile,
-                tailoringFile,
-                resultFile,
-                reportFile,
-                arfFile,
-                mScannerMode == SM_SCAN_ONLINE_REMEDIATION);
+        // m - mtime of the local files doesn't matter and the clocks may differ
+        script += QString("%1tar xmf - || exit %2\n")
+            .arg(compressUpload ? "gzip -dc | " : "").arg(EVALUATE_UPLOAD_FAILED);
     }
+    script += buildInputScript(contentHash, contentCached);
+    if (uploadTailoring)
+        script += QString("[ -f %1 ] || exit %2\n").arg(REMOTE_TAILORING_FILE).arg(EVALUATE_TAILORING_FAILED);
 
-    const QString sshCmd = args.join(" ");
+    QStringList quotedArgs;
+    for (QStringList::const_iterator it = args.constBegin(); it != args.constEnd(); ++it)
+        quotedArgs.append(shellQuote(*it));
 
-    emit infoMessage(QObject::tr("Starting the remote process..."));
+    script += QString(SCAP_WORKBENCH_REMOTE_OSCAP_PATH " %1\n").arg(quotedArgs.join(" "));
+
+    QStringList baseArgs;
+    baseArgs.append("-o"); baseArgs.append(QString("ControlPath=%1").arg(mSshConnection._getMasterSocket()));
+    baseArgs.append(mTarget);
 
     QProcess process(this);
 
-    process.start(SCAP_WORKBENCH_LOCAL_SSH_PATH, baseArgs + QStringList(QString("cd '%1'; " SCAP_WORKBENCH_REMOTE_OSCAP_PATH " %2").arg(workingDir).arg(sshCmd)));
-    process.waitForStarted();
+    // the upload can't be told apart from the evaluation, it is the stdin of
+    // the same ssh invocation
+    ScanTrace::Span evaluationSpan(contentCached ? "evaluation" : "upload and evaluation");
+
+    if (contentCached)
+        emit infoMessage(QObject::tr("Input data are cached on the remote machine, starting the remote process..."));
+    else
+        emit infoMessage(QObject::tr("Copying input data (compression: %1) and starting the remote process...")
+            .arg(compressUpload ? QString("gzip") : QObject::tr("none")));
+
+    if (uploadFiles.isEmpty())
+    {
+        process.start(SCAP_WORKBENCH_LOCAL_SSH_PATH, baseArgs + QStringList(script));
+        process.waitForStarted();
+        process.closeWriteChannel();
+    }
+    else
+    {
+        process.setStandardInputFile(localUploadFile);
+        process.start(SCAP_WORKBENCH_LOCAL_SSH_PATH, baseArgs + QStringList(script));
+        process.waitForStarted();
+    }
 
     if (process.state() != QProcess::Running)
     {
@@ -266,246 +362,388 @@ void OscapScannerRemoteSsh::evaluate()
         mCancelRequested = true;
     }
 
-    const unsigned int pollInterval = 100;
-
     emit infoMessage(QObject::tr("Processing on the remote machine..."));
-    while (!process.waitForFinished(pollInterval))
+    waitForScanProcess(process, false);
+
+    if (!mCancelRequested && !checkEvaluationExitCode(process))
     {
-        // read everything new
-        readStdOut(process);
-        watchStdErr(process);
+        evaluationSpan.end();
 
-        // pump the event queue, mainly because the user might want to cancel
-        QAbstractEventDispatcher::instance(mScanThread)->processEvents(QEventLoop::AllEvents);
+        ScanTrace::Span cleanUpSpan("clean up");
+        removeRemoteWorkingDirectory(workingDir);
 
-        if (mCancelRequested)
-        {
-            emit infoMessage(QObject::tr("Cancellation was requested! Terminating..."));
-            // TODO: On Windows we have to kill immediately, terminate() posts WM_CLOSE
-            //       but oscap doesn't have any event loop running.
-            process.terminate();
-            break;
-        }
+        mCancelRequested = true;
+        signalCompletion(mCancelRequested);
+        return;
     }
 
-    if (mCancelRequested)
+    if (!mCancelRequested)
     {
-        unsigned int waited = 0;
-        while (!process.waitForFinished(pollInterval))
+        // read everything left over
+        readStdOut(process);
+        watchStdErr(process);
+        evaluationSpan.end();
+
+        emit infoMessage(QObject::tr("Copying results back and cleaning up..."));
+        fetchResultsAndCleanUp(workingDir);
+
+        if (mScannerMode == SM_RESCAN_FAILED && !mCancelRequested)
         {
-            waited += pollInterval;
-            if (waited > 10000) // 10 seconds should be enough for the process to terminate
-            {
-                emit warningMessage(QObject::tr("The oscap process didn't terminate in time, it will be killed instead."));
-                // if it didn't terminate, we have to kill it at this point
-                process.kill();
-                break;
-            }
+            ScanTrace::Span spliceSpan("splice results");
+            spliceRescanResults();
         }
     }
     else
     {
-        // read everything left over
-        readStdOut(process);
-        watchStdErr(process);
+        evaluationSpan.end();
 
-        mResults = readRemoteFile(resultFile, QObject::tr("XCCDF results")).toUtf8();
-        mReport = readRemoteFile(reportFile, QObject::tr("XCCDF report (HTML)")).toUtf8();
-        mARF = readRemoteFile(arfFile, QObject::tr("Result DataStream (ARF)")).toUtf8();
+        emit infoMessage(QObject::tr("Cleaning up..."));
+        ScanTrace::Span cleanUpSpan("clean up");
+        removeRemoteWorkingDirectory(workingDir);
     }
 
-    emit infoMessage(QObject::tr("Cleaning up..."));
-
-    // Remove all the temporary remote files
-    removeRemoteFile(inputFile, QObject::tr("input file"));
-    if (!tailoringFile.isEmpty())
-        removeRemoteFile(tailoringFile, QObject::tr("tailoring file"));
-    removeRemoteFile(resultFile, QObject::tr("XCCDF result file"));
-    removeRemoteFile(reportFile, QObject::tr("XCCDF report file"));
-    removeRemoteFile(arfFile, QObject::tr("Result DataStream file"));
-    removeRemoteDirectory(workingDir, QObject::tr("Temporary Working Directory"));
-
     emit infoMessage(QObject::tr("Processing has been finished!"));
     signalCompletion(mCancelRequested);
 }
 
-void OscapScannerRemoteSsh::ensureConnected()
+QString OscapScannerRemoteSsh::shellQuote(const QString& input)
 {
-    if (mSshConnection.isConnected())
-        return;
+    QString ret = input;
+    ret.replace("'", "'\\''");
+    return QString("'%1'").arg(ret);
+}
 
-    try
-    {
-        emit infoMessage(QObject::tr("Establishing connecting to remote target..."));
-        mSshConnection.connect();
-        emit infoMessage(QObject::tr("Connection established."));
-    }
-    catch(const SshConnectionException& e)
+QString OscapScannerRemoteSsh::buildInputScript(const QString& contentHash, bool cached)
+{
+    // the uploaded input is already in the working directory
+    if (contentHash.isEmpty())
+        return QString();
+
+    QString ret = "CACHE=" REMOTE_CACHE_DIR "\n";
+    ret += QString("CACHED=\"$CACHE/%1.xml\"\n").arg(contentHash);
+
+    if (cached)
     {
-        emit errorMessage(QObject::tr("Can't connect to remote machine! Exception was: %1").arg(QString::fromUtf8(e.what())));
-        mCancelRequested = true;
+        ret += QString("ln -s \"$CACHED\" %1 || exit %2\n").arg(REMOTE_INPUT_FILE).arg(EVALUATE_UPLOAD_FAILED);
+        return ret;
     }
+
+    // The copy goes to a temporary name first so that an interrupted copy
+    // never leaves a truncated file in the cache. If the input can't be
+    // cached it stays in the working directory.
+    ret += QString(
+        "if mkdir -p \"$CACHE\" 2>/dev/null && cp %1 \"$CACHED.$$\" 2>/dev/null && mv -f \"$CACHED.$$\" \"$CACHED\"; then\n"
+        "    rm -f %1 && ln -s \"$CACHED\" %1 || exit %2\n"
+        "else\n"
+        "    rm -f \"$CACHED.$$\"\n"
+        "fi\n"
+    ).arg(REMOTE_INPUT_FILE).arg(EVALUATE_UPLOAD_FAILED);
+
+    return ret;
 }
 
-QString OscapScannerRemoteSsh::copyFileOver(const QString& localPath)
+QString OscapScannerRemoteSsh::buildCachePruneScript()
 {
-    ensureConnected();
+    // Files are listed newest first, hits touch the cached file so this is
+    // least recently used order. Leftovers of interrupted uploads are removed
+    // after a day.
+    return QString(
+        "CACHE=" REMOTE_CACHE_DIR "\n"
+        "if [ -d \"$CACHE\" ]; then\n"
+        "    find \"$CACHE\" -name '*.xml.*' -mtime +1 -exec rm -f {} \\; 2>/dev/null\n"
+        "    TOTAL=0\n"
+        "    for f in $(ls -t \"$CACHE\"); do\n"
+        "        case \"$f\" in *.xml) ;; *) continue ;; esac\n"
+        "        TOTAL=$((TOTAL + $(wc -c < \"$CACHE/$f\")))\n"
+        "        [ \"$TOTAL\" -le " REMOTE_CACHE_SIZE_LIMIT " ] || rm -f \"$CACHE/$f\"\n"
+        "    done\n"
+        "fi\n"
+    );
+}
 
-    QString ret = createRemoteTemporaryFile();
+bool OscapScannerRemoteSsh::bootstrapRemoteSession(QString& workingDir, const QString& contentHash, bool& contentCached)
+{
+    // One round-trip checks that oscap is there, creates the working directory,
+    // looks the input up in the content cache, checks for gzip and queries
+    // oscap capabilities. The first line of stdout is the working directory,
+    // the second one is a list of words ("cached", "gzip"), the third one
+    // identifies the oscap binary and the rest is output of 'oscap -V'.
+    // A cache hit touches the file to keep it from being pruned. 'oscap -V'
+    // is skipped if the binary is the one we have capabilities cached for.
+    QString cachedIdentity;
+    QString cachedCapabilities;
+    OscapCapabilitiesCache::lookup(mTarget, cachedIdentity, cachedCapabilities);
+
+    QString probe = "S=missing\n";
+    if (!contentHash.isEmpty())
+    {
+        probe = QString(
+            "CACHED=" REMOTE_CACHE_DIR "/%1.xml\n"
+            "if [ -f \"$CACHED\" ] && touch \"$CACHED\" 2>/dev/null; then S=cached; else S=missing; fi\n"
+        ).arg(contentHash);
+    }
+    probe += "command -v gzip >/dev/null 2>&1 && S=\"$S gzip\"\n";
+    probe += "echo \"$S\"\n";
 
+    SshSyncProcess proc(mSshConnection, this);
+    proc.setCommand(QString(
+        "command -v " SCAP_WORKBENCH_REMOTE_OSCAP_PATH " >/dev/null 2>&1 || exit %1\n"
+        "WD=$(mktemp -d) || exit %2\n"
+        "echo \"$WD\"\n"
+        "%4"
+        "ID=$(LC_ALL=C ls -lLi \"$(command -v " SCAP_WORKBENCH_REMOTE_OSCAP_PATH ")\" 2>/dev/null)\n"
+        "echo \"$ID\"\n"
+        "if [ -z \"$ID\" ] || [ \"$ID\" != %5 ]; then\n"
+        "    " SCAP_WORKBENCH_REMOTE_OSCAP_PATH " -V || { rm -rf \"$WD\"; exit %3; }\n"
+        "fi"
+    ).arg(BOOTSTRAP_NO_OSCAP).arg(BOOTSTRAP_NO_TEMP_DIR).arg(BOOTSTRAP_NO_CAPABILITIES).arg(probe)
+        .arg(shellQuote(cachedIdentity)));
+    proc.setCancelRequestSource(&mCancelRequested);
+    proc.run();
+
+    switch (proc.getExitCode())
     {
-        SshSyncProcess proc(mSshConnection, this);
-        proc.setStdInFile(localPath);
-        proc.setCommand("tee");
-        proc.setArguments(QStringList(ret));
-        proc.setCancelRequestSource(&mCancelRequested);
-        proc.run();
+        case 0:
+            break;
 
-        if (proc.getExitCode() != 0)
-        {
+        case BOOTSTRAP_NO_OSCAP:
             emit errorMessage(
-                QObject::tr("Failed to copy '%1' over to the remote machine! "
-                            "Diagnostic info:\n%2").arg(localPath).arg(proc.getDiagnosticInfo())
+                QObject::tr("Failed to locate oscap on remote machine. "
+                        "Please, check that openscap-scanner is installed on the remote machine.")
             );
+            return false;
 
-            mCancelRequested = true;
-        }
-    }
+        case BOOTSTRAP_NO_TEMP_DIR:
+            emit errorMessage(
+                QObject::tr("Failed to create a valid temporary dir. "
+                            "Diagnostic info: %1").arg(proc.getDiagnosticInfo())
+            );
+            return false;
 
-    return ret;
-}
+        case BOOTSTRAP_NO_CAPABILITIES:
+            emit errorMessage(
+                QObject::tr("Failed to query capabilities of oscap on remote machine.\n"
+                        "Diagnostic info:\n%1").arg(proc.getDiagnosticInfo())
+            );
+            return false;
 
-QString OscapScannerRemoteSsh::copyInputFileOver()
-{
-    ensureConnected();
+        default:
+            emit errorMessage(
+                QObject::tr("Failed to set up the scan on remote machine.\n"
+                        "Diagnostic info:\n%1").arg(proc.getDiagnosticInfo())
+            );
+            return false;
+    }
 
-    QString localPath = "";
+    const QString& output = proc.getStdOutContents();
+    const int firstNewline = output.indexOf('\n');
+    const int secondNewline = firstNewline == -1 ? -1 : output.indexOf('\n', firstNewline + 1);
+    const int thirdNewline = secondNewline == -1 ? -1 : output.indexOf('\n', secondNewline + 1);
 
-    QTemporaryFile inputARFFile;
-    inputARFFile.setAutoRemove(true);
-    if (mScannerMode == SM_OFFLINE_REMEDIATION)
+    workingDir = output.left(firstNewline).trimmed();
+    if (thirdNewline == -1 || workingDir.isEmpty())
     {
-        inputARFFile.open();
-        inputARFFile.write(getARFForRemediation());
-        inputARFFile.close();
+        emit errorMessage(
+            QObject::tr("Failed to set up the scan on remote machine, unexpected output.\n"
+                    "Diagnostic info:\n%1").arg(proc.getDiagnosticInfo())
+        );
+        return false;
+    }
+
+    const QStringList probeResults = output.mid(firstNewline + 1, secondNewline - firstNewline - 1)
+        .split(' ', QString::SkipEmptyParts);
+    contentCached = probeResults.contains("cached");
+    mRemoteGzipAvailable = probeResults.contains("gzip");
 
-        localPath = inputARFFile.fileName();
+    const QString identity = output.mid(secondNewline + 1, thirdNewline - secondNewline - 1);
+    const QString versionOutput = output.mid(thirdNewline + 1);
+
+    if (versionOutput.trimmed().isEmpty() && !identity.isEmpty() && identity == cachedIdentity)
+    {
+        mCapabilities.parse(cachedCapabilities);
     }
     else
     {
-        localPath = mSession->getOpenedFilePath();
+        mCapabilities.parse(versionOutput);
+        OscapCapabilitiesCache::store(mTarget, identity, versionOutput);
     }
 
-    return copyFileOver(localPath);
+    return true;
 }
 
-QString OscapScannerRemoteSsh::createRemoteTemporaryFile(bool cancelOnFailure)
+void OscapScannerRemoteSsh::fetchResultsAndCleanUp(const QString& workingDir)
 {
-    ensureConnected();
+    // All results come back as one tar stream, gzip compressed if we can
+    // decompress it and gzip is available on the remote machine. Only the
+    // files that exist are archived, missing ones are reported below. The
+    // working directory is removed and the content cache pruned in the same
+    // round-trip.
+    QString archiveCommand = "tar cf - \"$@\"";
+    if (isGzipSupported())
+        archiveCommand = "if command -v gzip >/dev/null 2>&1; then tar cf - \"$@\" | gzip -c; else tar cf - \"$@\"; fi";
 
     SshSyncProcess proc(mSshConnection, this);
-    proc.setCommand("mktemp");
+    proc.setCommand(QString(
+        "cd %1 || exit 1\n"
+        "set --\n"
+        "for f in %2 %3 %4; do [ -f \"$f\" ] && set -- \"$@\" \"$f\"; done\n"
+        "RC=0\n"
+        "if [ $# -gt 0 ]; then\n"
+        "    " + archiveCommand + "\n"
+        "    RC=$?\n"
+        "fi\n"
+        "cd / && rm -rf %1\n" +
+        buildCachePruneScript() +
+        "exit $RC"
+    ).arg(shellQuote(workingDir), REMOTE_RESULT_FILE, REMOTE_REPORT_FILE, REMOTE_ARF_FILE));
     proc.setCancelRequestSource(&mCancelRequested);
-    proc.run();
 
-    if (proc.getExitCode() != 0)
+    // the archive goes straight to disk, results can be hundreds of MB large
+    QTemporaryFile archiveFile(ScratchSpace::getFileTemplate());
+    if (!archiveFile.open())
     {
-        emit errorMessage(
-            QObject::tr("Failed to create a valid temporary file to copy input "
-                        "data to! Diagnostic info: %1").arg(proc.getDiagnosticInfo())
-        );
-
+        emit errorMessage(QObject::tr("Failed to create a temporary file for results copied back from the remote machine."));
         mCancelRequested = true;
-        signalCompletion(mCancelRequested);
-        return "";
+        return;
     }
+    proc.setStdOutFile(archiveFile.fileName());
 
-    return proc.getStdOutContents().trimmed();
-}
-
-QString OscapScannerRemoteSsh::createRemoteTemporaryDirectory(bool cancelOnFailure)
-{
-    ensureConnected();
-
-    SshSyncProcess proc(mSshConnection, this);
-    proc.setCommand("mktemp");
-    proc.setArguments(QStringList("-d"));
-    proc.setCancelRequestSource(&mCancelRequested);
+    ScanTrace::Span downloadSpan("download results and clean up");
     proc.run();
+    downloadSpan.setArgument("bytes", QString::number(QFileInfo(archiveFile.fileName()).size()));
+    downloadSpan.end();
 
     if (proc.getExitCode() != 0)
     {
-        emit errorMessage(
-            QObject::tr("Failed to create a valid temporary dir. "
-                        "Diagnostic info: %1").arg(proc.getDiagnosticInfo())
-        );
+        emit warningMessage(QString(
+            QObject::tr("Failed to copy back the results or to remove the remote working directory. "
+            "You may not be able to save this data! Diagnostic info: %1")).arg(proc.getDiagnosticInfo()));
+    }
+
+    ScanTrace::Span extractSpan("extract results");
+    QStringList extracted;
+    try
+    {
+        // the results are unpacked in chunks straight into the artifacts
+        mArtifacts->clear();
+        QMap<QString, QString> destinations;
+        destinations.insert(REMOTE_RESULT_FILE, mArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS));
+        destinations.insert(REMOTE_REPORT_FILE, mArtifacts->getPath(ScanArtifacts::ARTIFACT_REPORT));
+        destinations.insert(REMOTE_ARF_FILE, mArtifacts->getPath(ScanArtifacts::ARTIFACT_ARF));
+
+        QFile archive(archiveFile.fileName());
+        if (!archive.open(QIODevice::ReadOnly))
+            throw ArchiveHelpersException(QString("Failed to open '%1' for reading!").arg(archive.fileName()));
+
+        // the output is empty if none of the results exist
+        if (isGzipCompressed(archive.peek(2)))
+        {
+            QTemporaryFile tarFile(ScratchSpace::getFileTemplate());
+            if (!tarFile.open())
+                throw ArchiveHelpersException("Failed to create a temporary file for the decompressed results!");
 
+            gzipDecompress(archive, tarFile);
+            tarFile.seek(0);
+            extractTarArchive(tarFile, destinations, extracted);
+        }
+        else if (archive.size() > 0)
+            extractTarArchive(archive, destinations, extracted);
+    }
+    catch (const std::exception& e)
+    {
+        emit warningMessage(QObject::tr("Failed to extract results copied back from the remote machine. "
+            "You will not be able to save this data! Exception was: %1").arg(QString::fromUtf8(e.what())));
         mCancelRequested = true;
-        signalCompletion(mCancelRequested);
-        return "";
+        return;
     }
 
-    return proc.getStdOutContents().trimmed();
+    QStringList missing;
+    if (!extracted.contains(REMOTE_RESULT_FILE))
+        missing.append(QObject::tr("XCCDF results"));
+    if (!extracted.contains(REMOTE_REPORT_FILE))
+        missing.append(QObject::tr("HTML report"));
+    if (!extracted.contains(REMOTE_ARF_FILE))
+        missing.append(QObject::tr("ARF"));
+
+    if (!missing.isEmpty())
+    {
+        emit errorMessage(QObject::tr("The scan on the remote machine didn't produce all results, "
+            "missing: %1.").arg(missing.join(", ")));
+        mCancelRequested = true;
+        return;
+    }
 }
 
-QString OscapScannerRemoteSsh::readRemoteFile(const QString& path, const QString& desc)
+bool OscapScannerRemoteSsh::checkEvaluationExitCode(QProcess& process)
 {
-    SshSyncProcess proc(mSshConnection, this);
-    proc.setCommand("cat");
-    proc.setArguments(QStringList(path));
-    proc.setCancelRequestSource(&mCancelRequested);
-    proc.run();
+    if (process.exitStatus() != QProcess::NormalExit)
+    {
+        watchStdErr(process);
+        emit errorMessage(QObject::tr("The ssh process has crashed."));
+        return false;
+    }
 
-    if (proc.getExitCode() != 0)
+    switch (process.exitCode())
     {
-        emit warningMessage(QString(
-            QObject::tr("Failed to copy back %1. "
-            "You will not be able to save this data! Diagnostic info: %2")).arg(desc).arg(proc.getDiagnosticInfo()));
+        case 0:
+        case 2: // some rules failed
+            return true;
 
-        mCancelRequested = true;
-        signalCompletion(mCancelRequested);
-        return "";
+        case EVALUATE_NO_WORKING_DIR:
+            emit errorMessage(QObject::tr("The working directory on the remote machine has disappeared."));
+            break;
+
+        case EVALUATE_UPLOAD_FAILED:
+            emit errorMessage(QObject::tr("Failed to copy input data to the remote machine."));
+            break;
+
+        case EVALUATE_TAILORING_FAILED:
+            emit errorMessage(QObject::tr("Failed to copy the tailoring file to the remote machine."));
+            break;
+
+        case SSH_FAILED:
+            emit errorMessage(QObject::tr("The connection to the remote machine has failed."));
+            break;
+
+        default:
+            emit errorMessage(QObject::tr("There was an error during evaluation! "
+                "Exit code of the 'oscap' process was %1.").arg(process.exitCode()));
+            break;
     }
 
-    return proc.getStdOutContents();
+    // the error message of the failed command is in stderr
+    watchStdErr(process);
+    return false;
 }
 
-void OscapScannerRemoteSsh::removeRemoteFile(const QString& path, const QString& desc)
+void OscapScannerRemoteSsh::removeRemoteWorkingDirectory(const QString& workingDir)
 {
     SshSyncProcess proc(mSshConnection, this);
-    proc.setCommand("rm");
-    proc.setArguments(QStringList(path));
-    proc.setCancelRequestSource(&mCancelRequested);
+    proc.setCommand(QString("rm -rf %1").arg(shellQuote(workingDir)));
     proc.run();
 
     if (proc.getExitCode() != 0)
     {
         emit warningMessage(QString(
-            QObject::tr("Failed to remove remote file %1. "
-            "Diagnostic info: %2")).arg(desc).arg(proc.getDiagnosticInfo()));
-
-        mCancelRequested = true;
-        signalCompletion(mCancelRequested);
+            QObject::tr("Failed to remove remote working directory %1. "
+            "Diagnostic info: %2")).arg(workingDir).arg(proc.getDiagnosticInfo()));
     }
 }
 
-void OscapScannerRemoteSsh::removeRemoteDirectory(const QString& path, const QString& desc)
+void OscapScannerRemoteSsh::ensureConnected()
 {
-    SshSyncProcess proc(mSshConnection, this);
-    proc.setCommand("rm");
-    QStringList args;
-    args.push_back("-rf"); args.push_back(path);
-    proc.setArguments(args);
-    proc.setCancelRequestSource(&mCancelRequested);
-    proc.run();
+    if (mSshConnection.isConnected())
+        return;
 
-    if (proc.getExitCode() != 0)
+    try
     {
-        emit warningMessage(QString(
-            QObject::tr("Failed to remove remote directory %1. "
-            "Diagnostic info: %2")).arg(desc).arg(proc.getDiagnosticInfo()));
-
+        emit infoMessage(QObject::tr("Establishing connecting to remote target..."));
+        mSshConnection.connect();
+        emit infoMessage(QObject::tr("Connection established."));
+    }
+    catch(const SshConnectionException& e)
+    {
+        emit errorMessage(QObject::tr("Can't connect to remote machine! Exception was: %1").arg(QString::fromUtf8(e.what())));
         mCancelRequested = true;
-        signalCompletion(mCancelRequested);
     }
 }
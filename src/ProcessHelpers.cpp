@@ -21,12 +21,14 @@
 
 #include "ProcessHelpers.h"
 #include "Exceptions.h"
+#include "ScanTrace.h"
 
 #include "ui_ProcessProgress.h"
 
 #include <QProcess>
 #include <QEventLoop>
-#include <QAbstractEventDispatcher>
+#include <QTimer>
+#include <QFileInfo>
 #include <cassert>
 
 class ProcessProgressDialog : public QDialog
@@ -77,7 +79,13 @@ SyncProcess::SyncProcess(QObject* parent):
     mCancelRequestSource(0),
     mLocalCancelRequested(false),
 
-    mExitCode(-1)
+    mProcess(0),
+    mDialog(0),
+    mEventLoop(0),
+
+    mExitCode(-1),
+    mStdOutDecoded(true),
+    mDiagnosticInfoComplete(true)
 {}
 
 SyncProcess::~SyncProcess()
@@ -127,56 +135,29 @@ void SyncProcess::run()
 {
     mDiagnosticInfo = "";
 
+    // recorded only when running in a traced scan, commands are shortened
+    // because they may contain whole scripts
+    ScanTrace::Span span(QFileInfo(generateFullCommand()).fileName(), "process");
+    span.setArgument("description", generateDescription().left(256));
+
     QProcess process(this);
     mDiagnosticInfo += QObject::tr("Starting process '%1'\n").arg(generateDescription());
     startQProcess(process);
 
     mRunning = true;
 
-    while (!process.waitForFinished(mPollInterval))
-    {
-        // pump the event queue, mainly because the user might want to cancel
-        QAbstractEventDispatcher::instance(thread())->processEvents(QEventLoop::AllEvents);
-
-        if (wasCancelRequested())
-        {
-            mDiagnosticInfo += QObject::tr("Cancel was requested! Sending terminate signal to the process...\n");
-
-            // TODO: On Windows we have to kill immediately, terminate() posts WM_CLOSE
-            //       but oscap doesn't have any event loop running.
-            process.terminate();
-            break;
-        }
-    }
-
-    if (wasCancelRequested())
-    {
-        unsigned int termWaited = 0;
-
-        while (!process.waitForFinished(mPollInterval))
-        {
-            QAbstractEventDispatcher::instance(thread())->processEvents(QEventLoop::AllEvents);
-            termWaited += mPollInterval;
-
-            if (termWaited > mTermLimit)
-            {
-                mDiagnosticInfo += QObject::tr("Process had to be killed! Didn't terminate after %1 msec of waiting.\n").arg(termWaited);
-                process.kill();
-                break;
-            }
-        }
-    }
+    waitForProcess(process, 0);
 
     mRunning = false;
 
-    mStdOutContents = QString::fromLocal8Bit(process.readAllStandardOutput());
+    mRawStdOutContents = process.readAllStandardOutput();
+    mStdOutContents = QString();
+    mStdOutDecoded = false;
     mStdErrContents = QString::fromLocal8Bit(process.readAllStandardError());
-
-    // TODO: We are duplicating data here!
-    mDiagnosticInfo += "stdout:\n===============================\n" + QString(mStdOutContents) + QString("\n");
-    mDiagnosticInfo += "stderr:\n===============================\n" + QString(mStdErrContents) + QString("\n");
+    mDiagnosticInfoComplete = false;
 
     mExitCode = process.exitCode();
+    span.setArgument("exit code", QString::number(mExitCode));
 }
 
 QDialog* SyncProcess::runWithDialog(QWidget* widgetParent, const QString& title,
@@ -201,52 +182,16 @@ QDialog* SyncProcess::runWithDialog(QWidget* widgetParent, const QString& title,
 
     mRunning = true;
 
-    while (!process.waitForFinished(mPollInterval))
-    {
-        // pump the event queue, mainly because the user might want to cancel
-        QAbstractEventDispatcher::instance(thread())->processEvents(QEventLoop::AllEvents);
-
-        readAllChannelsIntoDialog(process, *dialog);
-
-        if (wasCancelRequested())
-        {
-            mDiagnosticInfo += QObject::tr("Cancel was requested! Sending terminate signal to the process...\n");
-
-            // TODO: On Windows we have to kill immediately, terminate() posts WM_CLOSE
-            //       but oscap doesn't have any event loop running.
-            process.terminate();
-            break;
-        }
-    }
-
-    if (wasCancelRequested())
-    {
-        unsigned int termWaited = 0;
-
-        while (!process.waitForFinished(mPollInterval))
-        {
-            QAbstractEventDispatcher::instance(thread())->processEvents(QEventLoop::AllEvents);
-            termWaited += mPollInterval;
-
-            if (termWaited > mTermLimit)
-            {
-                mDiagnosticInfo += QObject::tr("Process had to be killed! Didn't terminate after %1 msec of waiting.\n").arg(termWaited);
-                process.kill();
-                break;
-            }
-        }
-    }
-
+    waitForProcess(process, dialog);
     readAllChannelsIntoDialog(process, *dialog);
 
     mRunning = false;
 
-    mStdOutContents = process.readAllStandardOutput();
+    mRawStdOutContents = process.readAllStandardOutput();
+    mStdOutContents = QString();
+    mStdOutDecoded = false;
     mStdErrContents = process.readAllStandardError();
-
-    // TODO: We are duplicating data here!
-    mDiagnosticInfo += "stdout:\n===============================\n" + QString(mStdOutContents) + QString("\n");
-    mDiagnosticInfo += "stderr:\n===============================\n" + QString(mStdErrContents) + QString("\n");
+    mDiagnosticInfoComplete = false;
 
     mExitCode = process.exitCode();
     dialog->notifyDone();
@@ -257,9 +202,81 @@ QDialog* SyncProcess::runWithDialog(QWidget* widgetParent, const QString& title,
     return dialog;
 }
 
+void SyncProcess::waitForProcess(QProcess& process, ProcessProgressDialog* dialog)
+{
+    QEventLoop loop;
+    QObject::connect(
+        &process, SIGNAL(finished(int, QProcess::ExitStatus)),
+        &loop, SLOT(quit())
+    );
+
+    // The cancel request source is a plain bool, we have to check it periodically.
+    // This does not delay anything else, the loop quits as soon as the process exits.
+    QTimer cancelPollTimer;
+    cancelPollTimer.setInterval(mPollInterval);
+    QObject::connect(
+        &cancelPollTimer, SIGNAL(timeout()),
+        this, SLOT(checkCancelRequest())
+    );
+
+    if (dialog)
+    {
+        QObject::connect(
+            &process, SIGNAL(readyReadStandardOutput()),
+            this, SLOT(readProcessIntoDialog())
+        );
+    }
+
+    mProcess = &process;
+    mDialog = dialog;
+    mEventLoop = &loop;
+
+    if (process.state() != QProcess::NotRunning && !wasCancelRequested())
+    {
+        cancelPollTimer.start();
+        loop.exec();
+        cancelPollTimer.stop();
+    }
+
+    mEventLoop = 0;
+    mDialog = 0;
+    mProcess = 0;
+
+    if (process.state() != QProcess::NotRunning && wasCancelRequested())
+    {
+        mDiagnosticInfo += QObject::tr("Cancel was requested! Sending terminate signal to the process...\n");
+
+        // TODO: On Windows we have to kill immediately, terminate() posts WM_CLOSE
+        //       but oscap doesn't have any event loop running.
+        process.terminate();
+
+        if (!process.waitForFinished(mTermLimit))
+        {
+            mDiagnosticInfo += QObject::tr("Process had to be killed! Didn't terminate after %1 msec of waiting.\n").arg(mTermLimit);
+            process.kill();
+            process.waitForFinished();
+        }
+    }
+}
+
+void SyncProcess::checkCancelRequest()
+{
+    if (mEventLoop && wasCancelRequested())
+        mEventLoop->quit();
+}
+
+void SyncProcess::readProcessIntoDialog()
+{
+    if (mProcess && mDialog)
+        readAllChannelsIntoDialog(*mProcess, *mDialog);
+}
+
 void SyncProcess::cancel()
 {
     mLocalCancelRequested = true;
+
+    if (mEventLoop)
+        mEventLoop->quit();
 }
 
 bool SyncProcess::isRunning() const
@@ -280,6 +297,19 @@ const QString& SyncProcess::getStdInFile() const
     return mStdInFile;
 }
 
+void SyncProcess::setStdOutFile(const QString& path)
+{
+    if (isRunning())
+        throw SyncProcessException("Can't set stdout file when the process is running!");
+
+    mStdOutFile = path;
+}
+
+const QString& SyncProcess::getStdOutFile() const
+{
+    return mStdOutFile;
+}
+
 int SyncProcess::getExitCode() const
 {
     if (isRunning())
@@ -293,9 +323,24 @@ const QString& SyncProcess::getStdOutContents() const
     if (isRunning())
         throw SyncProcessException("Can't query stdout when the process is running!");
 
+    // decoded on demand, callers reading binary output never pay for it
+    if (!mStdOutDecoded)
+    {
+        mStdOutContents = QString::fromLocal8Bit(mRawStdOutContents);
+        mStdOutDecoded = true;
+    }
+
     return mStdOutContents;
 }
 
+const QByteArray& SyncProcess::getRawStdOutContents() const
+{
+    if (isRunning())
+        throw SyncProcessException("Can't query stdout when the process is running!");
+
+    return mRawStdOutContents;
+}
+
 const QString& SyncProcess::getStdErrContents() const
 {
     if (isRunning())
@@ -309,6 +354,20 @@ const QString& SyncProcess::getDiagnosticInfo() const
     if (isRunning())
         throw SyncProcessException("Can't query diagnostic info when the process is running!");
 
+    if (!mDiagnosticInfoComplete)
+    {
+        mDiagnosticInfo += "stdout:\n===============================\n";
+        // binary output (archives) is useless in diagnostics and can be huge
+        if (mRawStdOutContents.contains('\0'))
+            mDiagnosticInfo += QObject::tr("<%1 bytes of binary data>").arg(mRawStdOutContents.size());
+        else
+            mDiagnosticInfo += getStdOutContents();
+        mDiagnosticInfo += "\n";
+
+        mDiagnosticInfo += "stderr:\n===============================\n" + mStdErrContents + QString("\n");
+        mDiagnosticInfoComplete = true;
+    }
+
     return mDiagnosticInfo;
 }
 
@@ -321,6 +380,9 @@ void SyncProcess::startQProcess(QProcess& process)
     if (!mStdInFile.isEmpty())
         process.setStandardInputFile(mStdInFile);
 
+    if (!mStdOutFile.isEmpty())
+        process.setStandardOutputFile(mStdOutFile);
+
     process.setProcessEnvironment(generateFullEnvironment());
     mDiagnosticInfo += QObject::tr("Starting process '%1'\n").arg(generateDescription());
     process.setWorkingDirectory(mWorkingDirectory);
@@ -27,6 +27,41 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QCoreApplication>
+#include <QMutexLocker>
+
+/**
+ * @brief Runs 'ssh -O command' against the master listening on given socket
+ *
+ * @return exit code of ssh, 0 means success
+ */
+static int runMasterControlCommand(const QString& masterSocket, unsigned short port, const QString& target,
+    const QString& command, const QProcessEnvironment& environment, QObject* parent = 0)
+{
+    QStringList args;
+#ifdef SCAP_WORKBENCH_LOCAL_SETSID_FOUND
+#   ifdef SCAP_WORKBENCH_LOCAL_SETSID_SUPPORTS_WAIT
+    args.append("--wait");
+#   endif
+    args.append(SCAP_WORKBENCH_LOCAL_SSH_PATH);
+#endif
+
+    args.append("-S"); args.append(masterSocket);
+    args.append("-p"); args.append(QString::number(port));
+    args.append("-O"); args.append(command);
+    args.append(target);
+
+    SyncProcess proc(parent);
+#ifdef SCAP_WORKBENCH_LOCAL_SETSID_FOUND
+    proc.setCommand(getSetSidPath());
+#else
+    proc.setCommand(SCAP_WORKBENCH_LOCAL_SSH_PATH);
+#endif
+    proc.setArguments(args);
+    proc.setEnvironment(environment);
+    proc.run();
+
+    return proc.getExitCode();
+}
 
 SshConnection::SshConnection(QObject* parent):
     QObject(parent),
@@ -38,6 +73,7 @@ SshConnection::SshConnection(QObject* parent):
 
     mEnvironment(QProcessEnvironment::systemEnvironment()),
     mConnected(false),
+    mPooled(false),
     mCancelRequestSource(0)
 {
     mEnvironment.remove("SSH_TTY");
@@ -95,20 +131,40 @@ void SshConnection::setCancelRequestSource(bool* source)
     mCancelRequestSource = source;
 }
 
+void SshConnection::setPooled(bool pooled)
+{
+    if (isConnected())
+        throw SshConnectionException(
+            "Can't change pooling after SSH has already been connected");
+
+    mPooled = pooled;
+}
+
+bool SshConnection::isPooled() const
+{
+    return mPooled;
+}
+
 void SshConnection::connect()
 {
     if (isConnected())
         throw SshConnectionException(
             "Already connected, disconnect first!");
 
-    try
+    if (mSocketDir)
     {
-        if (mSocketDir)
-        {
-            delete mSocketDir;
-            mSocketDir = 0;
-        }
+        delete mSocketDir;
+        mSocketDir = 0;
+    }
+
+    if (mPooled && SshConnectionPool::getInstance().acquire(mTarget, mPort, mSocketDir, mMasterSocket))
+    {
+        mConnected = true;
+        return;
+    }
 
+    try
+    {
         mSocketDir = new TemporaryDir();
         mMasterSocket = mSocketDir->getPath() + "/ssh_socket";
     }
@@ -137,6 +193,11 @@ void SshConnection::connect()
 
         // send keep alive null messages every 60 seconds to make sure the connection stays alive
         args.append("-o"); args.append(QString("ServerAliveInterval=%1").arg(60));
+        // pooled masters exit on their own once idle, even if we never get to close them
+        if (mPooled)
+        {
+            args.append("-o"); args.append(QString("ControlPersist=%1").arg(SshConnectionPool::getInstance().getIdleTimeout()));
+        }
         args.append("-o"); args.append(QString("ControlPath=%1").arg(mMasterSocket));
         args.append("-p"); args.append(QString::number(mPort));
         // TODO: sanitize input?
@@ -177,31 +238,17 @@ void SshConnection::disconnect()
         throw SshConnectionException(
             "Not connected, makes no sense to disconnect!");
 
+    if (mPooled)
     {
-        QStringList args;
-#ifdef SCAP_WORKBENCH_LOCAL_SETSID_FOUND
-#   ifdef SCAP_WORKBENCH_LOCAL_SETSID_SUPPORTS_WAIT
-        args.append("--wait");
-#   endif
-        args.append(SCAP_WORKBENCH_LOCAL_SSH_PATH);
-#endif
-
-        args.append("-S"); args.append(mMasterSocket);
-        args.append("-p"); args.append(QString::number(mPort));
-        args.append("-O"); args.append("exit");
-        args.append(mTarget);
-
-        SyncProcess proc(this);
-#ifdef SCAP_WORKBENCH_LOCAL_SETSID_FOUND
-        proc.setCommand(getSetSidPath());
-#else
-        proc.setCommand(SCAP_WORKBENCH_LOCAL_SSH_PATH);
-#endif
-        proc.setArguments(args);
-        proc.setEnvironment(mEnvironment);
-        proc.run();
+        // the pool takes over the master including its socket directory
+        SshConnectionPool::getInstance().release(mTarget, mPort, mSocketDir, mMasterSocket);
+        mSocketDir = 0;
+        mConnected = false;
+        return;
     }
 
+    runMasterControlCommand(mMasterSocket, mPort, mTarget, "exit", mEnvironment, this);
+
     // delete the parent temporary directory we created
     if (mSocketDir)
     {
@@ -227,6 +274,148 @@ const QProcessEnvironment& SshConnection::_getEnvironment() const
     return mEnvironment;
 }
 
+SshConnectionPool& SshConnectionPool::getInstance()
+{
+    static SshConnectionPool instance;
+    return instance;
+}
+
+SshConnectionPool::SshConnectionPool():
+    mIdleTimeout(600)
+{}
+
+SshConnectionPool::~SshConnectionPool()
+{
+    // This runs after the application is gone, no processes can be started
+    // anymore. Masters will exit on their own thanks to ControlPersist.
+    for (QList<Master>::iterator it = mMasters.begin(); it != mMasters.end(); ++it)
+        delete it->socketDir;
+}
+
+void SshConnectionPool::setIdleTimeout(unsigned int seconds)
+{
+    QMutexLocker locker(&mMutex);
+    mIdleTimeout = seconds;
+}
+
+unsigned int SshConnectionPool::getIdleTimeout() const
+{
+    QMutexLocker locker(&mMutex);
+    return mIdleTimeout;
+}
+
+bool SshConnectionPool::acquire(const QString& target, unsigned short port, TemporaryDir*& socketDir, QString& masterSocket)
+{
+    QList<Master> expired;
+    QList<Master> candidates;
+
+    {
+        QMutexLocker locker(&mMutex);
+        expired = takeExpiredMasters();
+
+        for (QList<Master>::iterator it = mMasters.begin(); it != mMasters.end();)
+        {
+            if (it->target == target && it->port == port)
+            {
+                candidates.append(*it);
+                it = mMasters.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    // processes are never run with the mutex locked, that would serialize all scans
+    for (QList<Master>::const_iterator it = expired.constBegin(); it != expired.constEnd(); ++it)
+        closeMaster(*it);
+
+    bool found = false;
+    for (QList<Master>::const_iterator it = candidates.constBegin(); it != candidates.constEnd(); ++it)
+    {
+        if (!found && runMasterControlCommand(it->masterSocket, it->port, it->target, "check",
+                QProcessEnvironment::systemEnvironment()) == 0)
+        {
+            socketDir = it->socketDir;
+            masterSocket = it->masterSocket;
+            found = true;
+        }
+        else if (found)
+        {
+            // only one is needed, the rest goes back
+            release(it->target, it->port, it->socketDir, it->masterSocket);
+        }
+        else
+        {
+            // the master died (network outage, ControlPersist expired, ...)
+            closeMaster(*it);
+        }
+    }
+
+    return found;
+}
+
+void SshConnectionPool::release(const QString& target, unsigned short port, TemporaryDir* socketDir, const QString& masterSocket)
+{
+    Master master;
+    master.target = target;
+    master.port = port;
+    master.socketDir = socketDir;
+    master.masterSocket = masterSocket;
+    master.releasedAt = QDateTime::currentDateTime();
+
+    QList<Master> expired;
+
+    {
+        QMutexLocker locker(&mMutex);
+        expired = takeExpiredMasters();
+        mMasters.append(master);
+    }
+
+    for (QList<Master>::const_iterator it = expired.constBegin(); it != expired.constEnd(); ++it)
+        closeMaster(*it);
+}
+
+void SshConnectionPool::closeAll()
+{
+    QList<Master> masters;
+
+    {
+        QMutexLocker locker(&mMutex);
+        masters = mMasters;
+        mMasters.clear();
+    }
+
+    for (QList<Master>::const_iterator it = masters.constBegin(); it != masters.constEnd(); ++it)
+        closeMaster(*it);
+}
+
+QList<SshConnectionPool::Master> SshConnectionPool::takeExpiredMasters()
+{
+    QList<Master> ret;
+    const QDateTime now = QDateTime::currentDateTime();
+
+    for (QList<Master>::iterator it = mMasters.begin(); it != mMasters.end();)
+    {
+        if (it->releasedAt.secsTo(now) >= static_cast<int>(mIdleTimeout))
+        {
+            ret.append(*it);
+            it = mMasters.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    return ret;
+}
+
+void SshConnectionPool::closeMaster(const Master& master)
+{
+    runMasterControlCommand(master.masterSocket, master.port, master.target, "exit",
+        QProcessEnvironment::systemEnvironment());
+
+    delete master.socketDir;
+}
+
 SshSyncProcess::SshSyncProcess(SshConnection& connection, QObject* parent):
     SyncProcess(parent),
 
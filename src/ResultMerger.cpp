@@ -0,0 +1,866 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+#include "ResultMerger.h"
+#include "Exceptions.h"
+
+#include <QFile>
+#include <QBuffer>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+static const QString XCCDF_NAMESPACE_PREFIX = "http://checklists.nist.gov/xccdf/";
+static const QString ARF_NAMESPACE = "http://scap.nist.gov/schema/asset-reporting-format/1.1";
+static const QString REPORTING_CORE_NAMESPACE = "http://scap.nist.gov/schema/reporting-core/1.1";
+static const QString OVAL_RESULTS_NAMESPACE = "http://oval.mitre.org/XMLSchema/oval-results-5";
+
+static const QString SCORING_DEFAULT = "urn:xccdf:scoring:default";
+static const QString SCORING_FLAT = "urn:xccdf:scoring:flat";
+static const QString SCORING_FLAT_UNWEIGHTED = "urn:xccdf:scoring:flat-unweighted";
+static const QString SCORING_ABSOLUTE = "urn:xccdf:scoring:absolute";
+
+ResultMerger::ResultMerger():
+    mPrecedence(PRECEDENCE_LATEST)
+{}
+
+ResultMerger::~ResultMerger()
+{}
+
+void ResultMerger::addInput(const QString& path)
+{
+    mInputs.append(path);
+}
+
+const QStringList& ResultMerger::getInputs() const
+{
+    return mInputs;
+}
+
+void ResultMerger::setPrecedence(Precedence precedence)
+{
+    mPrecedence = precedence;
+}
+
+ResultMerger::Precedence ResultMerger::getPrecedence() const
+{
+    return mPrecedence;
+}
+
+void ResultMerger::setScoringHierarchy(struct xccdf_benchmark* benchmark)
+{
+    mScoringItems.clear();
+    mScoringRootID.clear();
+
+    if (benchmark)
+    {
+        mScoringRootID = QString::fromUtf8(xccdf_benchmark_get_id(benchmark));
+        addScoringItems(xccdf_benchmark_to_item(benchmark), QString());
+    }
+}
+
+void ResultMerger::merge(QIODevice& output)
+{
+    if (mInputs.isEmpty())
+        throw ResultMergerException("No inputs to merge!");
+
+    mRuleResults.clear();
+    mRuleOrder.clear();
+    mOVALReportIDs.clear();
+    mRelationships.clear();
+    mBenchmarkID.clear();
+    mStartTime = QDateTime();
+    mEndTime = QDateTime();
+
+    for (int i = 0; i < mInputs.size(); ++i)
+        collectInput(i);
+
+    QFile base(mInputs.first());
+    if (!base.open(QIODevice::ReadOnly))
+        throw ResultMergerException(QString("Failed to open '%1' for reading!").arg(base.fileName()));
+
+    QXmlStreamReader reader(&base);
+    QXmlStreamWriter writer(&output);
+    writer.setAutoFormatting(false);
+
+    writeMergedDocument(reader, writer);
+
+    if (reader.hasError())
+        throw ResultMergerException(QString("Failed to parse '%1' at line %2: %3")
+            .arg(base.fileName()).arg(reader.lineNumber()).arg(reader.errorString()));
+
+    if (writer.hasError())
+        throw ResultMergerException("Failed to write the merged document!");
+}
+
+void ResultMerger::getRuleResults(QIODevice& document, QStringList& ruleIDs, QStringList& results)
+{
+    QXmlStreamReader reader(&document);
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (isRuleResult(reader))
+        {
+            ruleIDs.append(reader.attributes().value("idref").toString());
+
+            QString result;
+            captureElement(reader, result);
+            results.append(result);
+        }
+    }
+
+    if (reader.hasError())
+        throw ResultMergerException(QString("Failed to parse results at line %1: %2")
+            .arg(reader.lineNumber()).arg(reader.errorString()));
+}
+
+QStringList ResultMerger::getFailedRules(QIODevice& document)
+{
+    QStringList ruleIDs;
+    QStringList results;
+    getRuleResults(document, ruleIDs, results);
+
+    QStringList ret;
+    for (int i = 0; i < ruleIDs.size(); ++i)
+    {
+        // multi-check rules have more rule-results
+        if (isFailed(results[i]) && !ret.contains(ruleIDs[i]))
+            ret.append(ruleIDs[i]);
+    }
+
+    return ret;
+}
+
+bool ResultMerger::isFailed(const QString& result)
+{
+    return result == "fail" || result == "error" || result == "unknown";
+}
+
+void ResultMerger::collectInput(int input)
+{
+    QFile file(mInputs[input]);
+    if (!file.open(QIODevice::ReadOnly))
+        throw ResultMergerException(QString("Failed to open '%1' for reading!").arg(file.fileName()));
+
+    QXmlStreamReader reader(&file);
+    QString currentReportID;
+    bool benchmarkSeen = false;
+
+    // rule-results of this input, precedence is decided once all of them are read
+    QMap<QString, RuleResults> inputResults;
+    QStringList inputOrder;
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (isARFReport(reader))
+        {
+            currentReportID = reader.attributes().value("id").toString();
+        }
+        else if (input > 0 && reader.isStartElement() && reader.namespaceUri() == REPORTING_CORE_NAMESPACE &&
+            reader.name() == "relationship")
+        {
+            // relationships come before reports, the ones of OVAL reports are picked when writing
+            const QString subject = reader.attributes().value("subject").toString();
+            QString unused;
+            mRelationships[input].append(qMakePair(subject, captureElement(reader, unused)));
+        }
+        else if (reader.isStartElement() && reader.namespaceUri() == OVAL_RESULTS_NAMESPACE &&
+            reader.name() == "oval_results" && !currentReportID.isEmpty())
+        {
+            mOVALReportIDs[input].insert(currentReportID);
+            // nothing interesting inside, OVAL results can be huge
+            reader.skipCurrentElement();
+        }
+        else if (!benchmarkSeen && isXCCDFElement(reader, "Benchmark"))
+        {
+            benchmarkSeen = true;
+
+            const QString id = reader.attributes().value("id").toString();
+            if (input == 0)
+                mBenchmarkID = id;
+            else if (!id.isEmpty() && !mBenchmarkID.isEmpty() && id != mBenchmarkID)
+                throw ResultMergerException(QString("'%1' contains results of benchmark '%2', expected '%3'!")
+                    .arg(file.fileName()).arg(id).arg(mBenchmarkID));
+        }
+        else if (isXCCDFElement(reader, "TestResult"))
+        {
+            const QDateTime startTime = QDateTime::fromString(reader.attributes().value("start-time").toString(), Qt::ISODate);
+            const QDateTime endTime = QDateTime::fromString(reader.attributes().value("end-time").toString(), Qt::ISODate);
+
+            if (startTime.isValid() && (!mStartTime.isValid() || startTime < mStartTime))
+                mStartTime = startTime;
+            if (endTime.isValid() && (!mEndTime.isValid() || endTime > mEndTime))
+                mEndTime = endTime;
+        }
+        else if (isRuleResult(reader))
+        {
+            const QString ruleID = reader.attributes().value("idref").toString();
+
+            bool weightValid = false;
+            const double weight = reader.attributes().value("weight").toString().toDouble(&weightValid);
+
+            RuleResult ruleResult;
+            ruleResult.input = input;
+            ruleResult.weight = weightValid ? weight : -1;
+            ruleResult.fragment = captureElement(reader, ruleResult.result);
+            // the base is read again when the output is written
+            if (input == 0)
+                ruleResult.fragment.clear();
+
+            QMap<QString, RuleResults>::iterator it = inputResults.find(ruleID);
+            if (it == inputResults.end())
+            {
+                inputResults.insert(ruleID, RuleResults() << ruleResult);
+                inputOrder.append(ruleID);
+            }
+            else
+                it->append(ruleResult);
+        }
+    }
+
+    if (reader.hasError())
+        throw ResultMergerException(QString("Failed to parse '%1' at line %2: %3")
+            .arg(file.fileName()).arg(reader.lineNumber()).arg(reader.errorString()));
+
+    for (QStringList::const_iterator ruleID = inputOrder.constBegin(); ruleID != inputOrder.constEnd(); ++ruleID)
+    {
+        const RuleResults& ruleResults = inputResults[*ruleID];
+
+        // all rule-results of a multi-check rule are taken from the same input
+        QMap<QString, RuleResults>::iterator it = mRuleResults.find(*ruleID);
+        if (it == mRuleResults.end())
+        {
+            mRuleResults.insert(*ruleID, ruleResults);
+            mRuleOrder.append(*ruleID);
+        }
+        else if (takesPrecedence(combinedResult(ruleResults), combinedResult(*it)))
+            *it = ruleResults;
+    }
+}
+
+void ResultMerger::writeMergedDocument(QXmlStreamReader& reader, QXmlStreamWriter& writer)
+{
+    bool inTestResult = false;
+    bool ruleResultsComplete = false;
+    QSet<QString> written;
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+        if (reader.hasError())
+            return;
+
+        if (isXCCDFElement(reader, "TestResult"))
+        {
+            inTestResult = true;
+            writeTestResultStart(reader, writer);
+            continue;
+        }
+
+        if (!inTestResult)
+        {
+            copyCurrentToken(reader, writer);
+            continue;
+        }
+
+        if (isRuleResult(reader))
+        {
+            const QString ruleID = reader.attributes().value("idref").toString();
+
+            QString baseResult;
+            const QByteArray baseFragment = captureElement(reader, baseResult);
+
+            QMap<QString, RuleResults>::const_iterator it = mRuleResults.constFind(ruleID);
+            if (it == mRuleResults.constEnd() || it->first().input == 0)
+                writeFragment(baseFragment, 0, writer);
+            // the base may list a rule more than once (multi-check), all its
+            // rule-results are replaced by all rule-results of the winning input
+            else if (!written.contains(ruleID))
+            {
+                for (RuleResults::const_iterator ruleResult = it->constBegin(); ruleResult != it->constEnd(); ++ruleResult)
+                    writeFragment(ruleResult->fragment, ruleResult->input, writer);
+            }
+
+            written.insert(ruleID);
+            continue;
+        }
+
+        const bool testResultEnd = reader.isEndElement() && reader.name() == "TestResult" &&
+            reader.namespaceUri().toString().startsWith(XCCDF_NAMESPACE_PREFIX);
+
+        // rule-results are followed by scores, rules missing in the base go right before them
+        if (!ruleResultsComplete && (isXCCDFElement(reader, "score") || isXCCDFElement(reader, "metadata") || testResultEnd))
+        {
+            writeRemainingRuleResults(writer, written);
+            ruleResultsComplete = true;
+        }
+
+        if (isXCCDFElement(reader, "score"))
+        {
+            writeScore(reader, writer);
+            continue;
+        }
+
+        if (testResultEnd)
+            inTestResult = false;
+
+        // relationships of the appended OVAL reports go to the end of the list of relationships
+        if (reader.isEndElement() && reader.namespaceUri() == REPORTING_CORE_NAMESPACE && reader.name() == "relationships")
+        {
+            for (int i = 1; i < mInputs.size(); ++i)
+                writeOVALRelationships(i, writer);
+        }
+
+        // OVAL reports of other inputs go to the end of the list of reports
+        if (reader.isEndElement() && reader.namespaceUri() == ARF_NAMESPACE && reader.name() == "reports")
+        {
+            for (int i = 1; i < mInputs.size(); ++i)
+                copyOVALReports(i, writer);
+        }
+
+        copyCurrentToken(reader, writer);
+    }
+}
+
+void ResultMerger::writeRemainingRuleResults(QXmlStreamWriter& writer, const QSet<QString>& written) const
+{
+    for (QStringList::const_iterator it = mRuleOrder.constBegin(); it != mRuleOrder.constEnd(); ++it)
+    {
+        if (written.contains(*it))
+            continue;
+
+        const RuleResults& ruleResults = mRuleResults[*it];
+        // rule-results of the base were all written already
+        if (ruleResults.first().input == 0)
+            continue;
+
+        for (RuleResults::const_iterator ruleResult = ruleResults.constBegin(); ruleResult != ruleResults.constEnd(); ++ruleResult)
+            writeFragment(ruleResult->fragment, ruleResult->input, writer);
+    }
+}
+
+void ResultMerger::writeScore(QXmlStreamReader& reader, QXmlStreamWriter& writer) const
+{
+    const QString system = reader.attributes().value("system").toString();
+
+    double score = 0;
+    double maximum = 100;
+
+    if (system == SCORING_DEFAULT)
+        score = computeDefaultScore();
+    else if (system == SCORING_FLAT)
+        computeFlatScore(false, score, maximum);
+    else if (system == SCORING_FLAT_UNWEIGHTED)
+        computeFlatScore(true, score, maximum);
+    else if (system == SCORING_ABSOLUTE)
+    {
+        double flatMaximum = 0;
+        computeFlatScore(false, score, flatMaximum);
+        score = (score == flatMaximum) ? 1 : 0;
+        maximum = 1;
+    }
+    else
+    {
+        // we have no idea how to compute this one
+        copyElement(reader, writer);
+        return;
+    }
+
+    QXmlStreamAttributes attributes;
+    const QXmlStreamAttributes original = reader.attributes();
+    for (QXmlStreamAttributes::const_iterator it = original.constBegin(); it != original.constEnd(); ++it)
+    {
+        if (it->name() != "maximum")
+            attributes.append(*it);
+    }
+    attributes.append("maximum", QString::number(maximum, 'f', 6));
+
+    writeStartElement(reader, writer, attributes);
+    writer.writeCharacters(QString::number(score, 'f', 6));
+    writer.writeEndElement();
+
+    reader.skipCurrentElement();
+}
+
+void ResultMerger::writeTestResultStart(const QXmlStreamReader& reader, QXmlStreamWriter& writer) const
+{
+    QXmlStreamAttributes attributes;
+    const QXmlStreamAttributes original = reader.attributes();
+    for (QXmlStreamAttributes::const_iterator it = original.constBegin(); it != original.constEnd(); ++it)
+    {
+        if (it->name() == "start-time" && mStartTime.isValid())
+            attributes.append("start-time", mStartTime.toString(Qt::ISODate));
+        else if (it->name() == "end-time" && mEndTime.isValid())
+            attributes.append("end-time", mEndTime.toString(Qt::ISODate));
+        else
+            attributes.append(*it);
+    }
+
+    writeStartElement(reader, writer, attributes);
+}
+
+bool ResultMerger::takesPrecedence(const QString& candidate, const QString& current) const
+{
+    const bool candidateEvaluated = isEvaluated(candidate);
+    const bool currentEvaluated = isEvaluated(current);
+
+    if (candidateEvaluated != currentEvaluated)
+        return candidateEvaluated;
+
+    if (!candidateEvaluated)
+        // notchecked tells more than notselected
+        return resultStrictness(candidate) > resultStrictness(current);
+
+    if (mPrecedence == PRECEDENCE_LATEST)
+        return true;
+
+    return resultStrictness(candidate) > resultStrictness(current);
+}
+
+QString ResultMerger::combinedResult(const RuleResults& ruleResults)
+{
+    QString ret;
+    for (RuleResults::const_iterator it = ruleResults.constBegin(); it != ruleResults.constEnd(); ++it)
+    {
+        const bool evaluated = isEvaluated(it->result);
+        if (it == ruleResults.constBegin() || (evaluated && !isEvaluated(ret)) ||
+            (evaluated == isEvaluated(ret) && resultStrictness(it->result) > resultStrictness(ret)))
+            ret = it->result;
+    }
+
+    return ret;
+}
+
+int ResultMerger::resultStrictness(const QString& result)
+{
+    static const char* const order[] = {
+        "notselected", "notchecked", "notapplicable", "informational",
+        "pass", "fixed", "unknown", "error", "fail"
+    };
+
+    for (unsigned int i = 0; i < sizeof(order) / sizeof(order[0]); ++i)
+    {
+        if (result == order[i])
+            return i;
+    }
+
+    // unknown values are treated as least strict
+    return -1;
+}
+
+bool ResultMerger::isEvaluated(const QString& result)
+{
+    return result != "notselected" && result != "notchecked" && !result.isEmpty();
+}
+
+bool ResultMerger::isCounted(const QString& result)
+{
+    // see XCCDF 1.2 specification, section 7.3.2 - only these results affect scores
+    return result == "pass" || result == "fail" || result == "error" ||
+        result == "unknown" || result == "fixed";
+}
+
+bool ResultMerger::isPassed(const QString& result)
+{
+    return result == "pass" || result == "fixed";
+}
+
+double ResultMerger::getRuleWeight(const QString& ruleID, const RuleResult& ruleResult) const
+{
+    if (ruleResult.weight >= 0)
+        return ruleResult.weight;
+
+    QMap<QString, ScoringItem>::const_iterator it = mScoringItems.constFind(ruleID);
+    if (it != mScoringItems.constEnd())
+        return it->weight;
+
+    // the default weight according to the XCCDF specification
+    return 1;
+}
+
+void ResultMerger::computeFlatScore(bool unweighted, double& score, double& maximum) const
+{
+    score = 0;
+    maximum = 0;
+
+    for (QMap<QString, RuleResults>::const_iterator it = mRuleResults.constBegin(); it != mRuleResults.constEnd(); ++it)
+    {
+        // every rule-result of a multi-check rule counts
+        for (RuleResults::const_iterator ruleResult = it->constBegin(); ruleResult != it->constEnd(); ++ruleResult)
+        {
+            if (!isCounted(ruleResult->result))
+                continue;
+
+            double weight = getRuleWeight(it.key(), *ruleResult);
+            if (unweighted)
+                weight = weight > 0 ? 1 : 0;
+
+            maximum += weight;
+            if (isPassed(ruleResult->result))
+                score += weight;
+        }
+    }
+}
+
+double ResultMerger::computeDefaultScore() const
+{
+    // parent ID -> IDs of children
+    QMap<QString, QStringList> children;
+    for (QMap<QString, ScoringItem>::const_iterator it = mScoringItems.constBegin(); it != mScoringItems.constEnd(); ++it)
+        children[it->parentID].append(it.key());
+
+    // without the hierarchy all rules are treated as children of the benchmark
+    for (QMap<QString, RuleResults>::const_iterator it = mRuleResults.constBegin(); it != mRuleResults.constEnd(); ++it)
+    {
+        if (!mScoringItems.contains(it.key()))
+            children[mScoringRootID].append(it.key());
+    }
+
+    double score = 0;
+    computeDefaultItemScore(mScoringRootID, children, score);
+    return score;
+}
+
+bool ResultMerger::computeDefaultItemScore(const QString& id, const QMap<QString, QStringList>& children,
+    double& score) const
+{
+    QMap<QString, RuleResults>::const_iterator ruleResults = mRuleResults.constFind(id);
+    if (ruleResults != mRuleResults.constEnd())
+    {
+        // multi-check rules score the average of their counted rule-results
+        int counted = 0;
+        int passed = 0;
+        for (RuleResults::const_iterator it = ruleResults->constBegin(); it != ruleResults->constEnd(); ++it)
+        {
+            if (!isCounted(it->result))
+                continue;
+
+            ++counted;
+            if (isPassed(it->result))
+                ++passed;
+        }
+
+        if (counted == 0)
+            return false;
+
+        score = 100.0 * passed / counted;
+        return true;
+    }
+
+    double accumulator = 0;
+    double weightSum = 0;
+    bool counted = false;
+
+    const QStringList itemChildren = children.value(id);
+    for (QStringList::const_iterator it = itemChildren.constBegin(); it != itemChildren.constEnd(); ++it)
+    {
+        double childScore = 0;
+        if (!computeDefaultItemScore(*it, children, childScore))
+            continue;
+
+        QMap<QString, RuleResults>::const_iterator ruleResults = mRuleResults.constFind(*it);
+        const double weight = ruleResults != mRuleResults.constEnd() ?
+            getRuleWeight(*it, ruleResults->first()) : mScoringItems[*it].weight;
+        accumulator += childScore * weight;
+        weightSum += weight;
+        counted = true;
+    }
+
+    score = weightSum > 0 ? accumulator / weightSum : 0;
+    return counted;
+}
+
+void ResultMerger::addScoringItems(struct xccdf_item* item, const QString& parentID)
+{
+    const QString id = QString::fromUtf8(xccdf_item_get_id(item));
+
+    ScoringItem scoringItem;
+    scoringItem.parentID = parentID;
+    scoringItem.weight = xccdf_item_get_weight(item);
+    mScoringItems.insert(id, scoringItem);
+
+    if (xccdf_item_get_type(item) == XCCDF_BENCHMARK ||
+        xccdf_item_get_type(item) == XCCDF_GROUP)
+    {
+        struct xccdf_item_iterator* it = xccdf_item_get_content(item);
+        while (xccdf_item_iterator_has_more(it))
+            addScoringItems(xccdf_item_iterator_next(it), id);
+        xccdf_item_iterator_free(it);
+    }
+}
+
+void ResultMerger::copyOVALReports(int input, QXmlStreamWriter& writer)
+{
+    const QSet<QString> reportIDs = mOVALReportIDs.value(input);
+    if (reportIDs.isEmpty())
+        return;
+
+    QFile file(mInputs[input]);
+    if (!file.open(QIODevice::ReadOnly))
+        throw ResultMergerException(QString("Failed to open '%1' for reading!").arg(file.fileName()));
+
+    QXmlStreamReader reader(&file);
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (isARFReport(reader))
+        {
+            const QString id = reader.attributes().value("id").toString();
+            if (reportIDs.contains(id))
+                copyElement(reader, writer, uniqueReportID(id, input));
+        }
+    }
+
+    if (reader.hasError())
+        throw ResultMergerException(QString("Failed to parse '%1' at line %2: %3")
+            .arg(file.fileName()).arg(reader.lineNumber()).arg(reader.errorString()));
+}
+
+void ResultMerger::writeOVALRelationships(int input, QXmlStreamWriter& writer) const
+{
+    const QSet<QString> reportIDs = mOVALReportIDs.value(input);
+    const QList<QPair<QString, QByteArray> > relationships = mRelationships.value(input);
+
+    for (QList<QPair<QString, QByteArray> >::const_iterator it = relationships.constBegin(); it != relationships.constEnd(); ++it)
+    {
+        if (reportIDs.contains(it->first))
+            writeFragment(it->second, input, writer);
+    }
+}
+
+QByteArray ResultMerger::captureElement(QXmlStreamReader& reader, QString& result)
+{
+    QByteArray ret;
+    QBuffer buffer(&ret);
+    buffer.open(QIODevice::WriteOnly);
+
+    QXmlStreamWriter writer(&buffer);
+    writer.setAutoFormatting(false);
+
+    int depth = 0;
+    bool inResult = false;
+
+    while (!reader.atEnd())
+    {
+        if (reader.isStartElement())
+        {
+            ++depth;
+            inResult = depth == 2 && reader.name() == "result";
+        }
+        else if (reader.isCharacters() && inResult)
+        {
+            result += reader.text().toString().trimmed();
+        }
+        else if (reader.isEndElement())
+        {
+            --depth;
+            inResult = false;
+        }
+
+        copyCurrentToken(reader, writer);
+
+        if (depth == 0)
+            break;
+
+        reader.readNext();
+    }
+
+    return ret;
+}
+
+void ResultMerger::writeFragment(const QByteArray& fragment, int input, QXmlStreamWriter& writer) const
+{
+    QXmlStreamReader reader(fragment);
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (reader.isStartElement())
+        {
+            // namespace declarations of the fragment are left out, the ones
+            // in scope of the output are used instead
+            writer.writeStartElement(reader.namespaceUri().toString(), reader.name().toString());
+
+            const QXmlStreamAttributes attributes = reader.attributes();
+            for (QXmlStreamAttributes::const_iterator it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+            {
+                const QString value = it->value().toString();
+
+                if (input > 0 && it->name() == "href" && value.startsWith('#') &&
+                    mOVALReportIDs.value(input).contains(value.mid(1)))
+                {
+                    writer.writeAttribute(it->qualifiedName().toString(), "#" + uniqueReportID(value.mid(1), input));
+                }
+                else if (input > 0 && it->name() == "subject" && mOVALReportIDs.value(input).contains(value))
+                {
+                    writer.writeAttribute(it->qualifiedName().toString(), uniqueReportID(value, input));
+                }
+                else
+                    writer.writeAttribute(*it);
+            }
+        }
+        else if (!reader.isStartDocument() && !reader.isEndDocument())
+        {
+            copyCurrentToken(reader, writer);
+        }
+    }
+}
+
+void ResultMerger::copyElement(QXmlStreamReader& reader, QXmlStreamWriter& writer, const QString& id)
+{
+    int depth = 0;
+
+    while (!reader.atEnd())
+    {
+        if (reader.isStartElement())
+        {
+            ++depth;
+
+            if (depth == 1 && !id.isEmpty())
+            {
+                QXmlStreamAttributes attributes;
+                const QXmlStreamAttributes original = reader.attributes();
+                for (QXmlStreamAttributes::const_iterator it = original.constBegin(); it != original.constEnd(); ++it)
+                {
+                    if (it->name() == "id" && it->namespaceUri().isEmpty())
+                        attributes.append("id", id);
+                    else
+                        attributes.append(*it);
+                }
+
+                writeStartElement(reader, writer, attributes);
+                reader.readNext();
+                continue;
+            }
+        }
+        else if (reader.isEndElement())
+        {
+            --depth;
+        }
+
+        copyCurrentToken(reader, writer);
+
+        if (depth == 0)
+            break;
+
+        reader.readNext();
+    }
+}
+
+void ResultMerger::copyCurrentToken(QXmlStreamReader& reader, QXmlStreamWriter& writer)
+{
+    switch (reader.tokenType())
+    {
+        case QXmlStreamReader::StartDocument:
+        {
+            const QString version = reader.documentVersion().isEmpty() ? QString("1.0") : reader.documentVersion().toString();
+            if (reader.isStandaloneDocument())
+                writer.writeStartDocument(version, true);
+            else
+                writer.writeStartDocument(version);
+            break;
+        }
+
+        case QXmlStreamReader::EndDocument:
+            writer.writeEndDocument();
+            break;
+
+        case QXmlStreamReader::StartElement:
+            writeStartElement(reader, writer, reader.attributes());
+            break;
+
+        case QXmlStreamReader::EndElement:
+            writer.writeEndElement();
+            break;
+
+        case QXmlStreamReader::Characters:
+            if (reader.isCDATA())
+                writer.writeCDATA(reader.text().toString());
+            else
+                writer.writeCharacters(reader.text().toString());
+            break;
+
+        case QXmlStreamReader::Comment:
+            writer.writeComment(reader.text().toString());
+            break;
+
+        case QXmlStreamReader::DTD:
+            writer.writeDTD(reader.text().toString());
+            break;
+
+        case QXmlStreamReader::EntityReference:
+            writer.writeEntityReference(reader.name().toString());
+            break;
+
+        case QXmlStreamReader::ProcessingInstruction:
+            writer.writeProcessingInstruction(reader.processingInstructionTarget().toString(),
+                reader.processingInstructionData().toString());
+            break;
+
+        default:
+            break;
+    }
+}
+
+void ResultMerger::writeStartElement(const QXmlStreamReader& reader, QXmlStreamWriter& writer,
+    const QXmlStreamAttributes& attributes)
+{
+    // Declaring the namespaces before the element makes the writer use
+    // the original prefixes instead of generated ones.
+    const QXmlStreamNamespaceDeclarations declarations = reader.namespaceDeclarations();
+    for (QXmlStreamNamespaceDeclarations::const_iterator it = declarations.constBegin(); it != declarations.constEnd(); ++it)
+    {
+        if (it->prefix().isEmpty())
+            writer.writeDefaultNamespace(it->namespaceUri().toString());
+        else
+            writer.writeNamespace(it->namespaceUri().toString(), it->prefix().toString());
+    }
+
+    writer.writeStartElement(reader.namespaceUri().toString(), reader.name().toString());
+    writer.writeAttributes(attributes);
+}
+
+bool ResultMerger::isXCCDFElement(const QXmlStreamReader& reader, const QString& name)
+{
+    return reader.isStartElement() && reader.name() == name &&
+        reader.namespaceUri().toString().startsWith(XCCDF_NAMESPACE_PREFIX);
+}
+
+bool ResultMerger::isRuleResult(const QXmlStreamReader& reader)
+{
+    return isXCCDFElement(reader, "rule-result");
+}
+
+bool ResultMerger::isARFReport(const QXmlStreamReader& reader)
+{
+    return reader.isStartElement() && reader.name() == "report" && reader.namespaceUri() == ARF_NAMESPACE;
+}
+
+QString ResultMerger::uniqueReportID(const QString& id, int input) const
+{
+    return QString("%1-merged%2").arg(id).arg(input);
+}
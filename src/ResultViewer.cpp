@@ -27,6 +27,9 @@
 #include "ScanningSession.h"
 #include "Utils.h"
 #include "RemediationRoleSaver.h"
+#include "RuleTimingsDialog.h"
+#include "ScanArtifacts.h"
+#include "Exceptions.h"
 
 #include <QFileDialog>
 #include <QMessageBox>
@@ -34,10 +37,14 @@
 ResultViewer::ResultViewer(QWidget* parent):
     QWidget(parent),
 
-    mReportFile(0)
+    mArtifacts(0),
+    mRuleTimingsDialog(0)
 {
     mUI.setupUi(this);
 
+    mRuleTimingsDialog = new RuleTimingsDialog(this);
+    mRuleTimingsDialog->hide();
+
     mSaveResultsAction = new QAction("&XCCDF Result file", this);
     QObject::connect(
         mSaveResultsAction, SIGNAL(triggered()),
@@ -53,10 +60,23 @@ ResultViewer::ResultViewer(QWidget* parent):
         mSaveReportAction, SIGNAL(triggered()),
         this, SLOT(saveReport())
     );
+    mSaveRuleTimingsCSVAction = new QAction("Rule &Timings (CSV)", this);
+    QObject::connect(
+        mSaveRuleTimingsCSVAction, SIGNAL(triggered()),
+        mRuleTimingsDialog, SLOT(saveCSV())
+    );
+    mSaveRuleTimingsJSONAction = new QAction("Rule Timings (&JSON)", this);
+    QObject::connect(
+        mSaveRuleTimingsJSONAction, SIGNAL(triggered()),
+        mRuleTimingsDialog, SLOT(saveJSON())
+    );
     mSaveMenu = new QMenu(this);
     mSaveMenu->addAction(mSaveResultsAction);
     mSaveMenu->addAction(mSaveARFAction);
     mSaveMenu->addAction(mSaveReportAction);
+    mSaveMenu->addSeparator();
+    mSaveMenu->addAction(mSaveRuleTimingsCSVAction);
+    mSaveMenu->addAction(mSaveRuleTimingsJSONAction);
     mUI.saveButton->setMenu(mSaveMenu);
 
     QAction* genBashRemediation = new QAction("&bash", this);
@@ -84,21 +104,30 @@ ResultViewer::ResultViewer(QWidget* parent):
         mUI.openReportButton, SIGNAL(clicked()),
         this, SLOT(openReport())
     );
+    QObject::connect(
+        mUI.ruleTimingsButton, SIGNAL(clicked()),
+        mRuleTimingsDialog, SLOT(show())
+    );
 }
 
 ResultViewer::~ResultViewer()
 {
-    delete mReportFile;
-    mReportFile = 0;
+    delete mArtifacts;
+    mArtifacts = 0;
 }
 
 void ResultViewer::clear()
 {
     mInputBaseName.clear();
 
-    mResults.clear();
-    mReport.clear();
-    mARF.clear();
+    delete mArtifacts;
+    mArtifacts = 0;
+
+    mRuleTimingsDialog->setReport(RuleTimingReport(), QString());
+    mRuleTimingsDialog->hide();
+    mUI.ruleTimingsButton->setEnabled(false);
+    mSaveRuleTimingsCSVAction->setEnabled(false);
+    mSaveRuleTimingsJSONAction->setEnabled(false);
 }
 
 void ResultViewer::loadContent(Scanner* scanner)
@@ -115,19 +144,42 @@ void ResultViewer::loadContent(Scanner* scanner)
             mInputBaseName.chop(QString("-xccdf").length());
     }
 
-    mReport.clear();
-    scanner->getReport(mReport);
+    delete mArtifacts;
+    mArtifacts = scanner->takeArtifacts();
 
-    mResults.clear();
-    scanner->getResults(mResults);
+    QHash<QString, qint64> ruleTimings;
+    scanner->getRuleTimings(ruleTimings);
+    RuleTimingReport ruleTimingReport;
+    ruleTimingReport.build(ruleTimings, session);
+    mRuleTimingsDialog->setReport(ruleTimingReport, mInputBaseName);
 
-    mARF.clear();
-    scanner->getARF(mARF);
+    const bool hasRuleTimings = !ruleTimingReport.isEmpty();
+    mUI.ruleTimingsButton->setEnabled(hasRuleTimings);
+    mSaveRuleTimingsCSVAction->setEnabled(hasRuleTimings);
+    mSaveRuleTimingsJSONAction->setEnabled(hasRuleTimings);
 }
 
-const QByteArray& ResultViewer::getARF() const
+ScanArtifacts* ResultViewer::takeArtifacts()
 {
-    return mARF;
+    ScanArtifacts* ret = mArtifacts;
+    mArtifacts = 0;
+    return ret;
+}
+
+QString ResultViewer::getResultsPath() const
+{
+    if (!mArtifacts || !mArtifacts->has(ScanArtifacts::ARTIFACT_RESULTS))
+        return QString();
+
+    return mArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS);
+}
+
+QString ResultViewer::getARFPath() const
+{
+    if (!mArtifacts || !mArtifacts->has(ScanArtifacts::ARTIFACT_ARF))
+        return QString();
+
+    return mArtifacts->getPath(ScanArtifacts::ARTIFACT_ARF);
 }
 
 void ResultViewer::saveReport()
@@ -144,48 +196,34 @@ void ResultViewer::saveReport()
     if (filename.isEmpty())
         return;
 
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly);
-    file.write(mReport);
-    file.close();
+    saveArtifact(ScanArtifacts::ARTIFACT_REPORT, filename);
 }
 
 void ResultViewer::openReport()
 {
-    if (mReportFile)
-    {
-        delete mReportFile;
-        mReportFile = 0;
-    }
-
-    mReportFile = new QTemporaryFile();
-    mReportFile->setFileTemplate(mReportFile->fileTemplate() + ".html");
-    mReportFile->open();
-    mReportFile->write(mReport);
-    mReportFile->flush();
-    mReportFile->close();
-
-    openUrlGuarded(QUrl::fromLocalFile(mReportFile->fileName()));
+    if (!mArtifacts || !mArtifacts->has(ScanArtifacts::ARTIFACT_REPORT))
+        return;
 
-    // the temporary file will be destroyed when SCAP Workbench closes or after another one is requested
+    // the report stays in the artifacts directory until results are cleared or SCAP Workbench closes
+    openUrlGuarded(QUrl::fromLocalFile(mArtifacts->getPath(ScanArtifacts::ARTIFACT_REPORT)));
 }
 
 
 void ResultViewer::generateBashRemediationRole()
 {
-    BashResultRemediationSaver remediation(this, mARF);
+    BashResultRemediationSaver remediation(this, getARFPath());
     remediation.selectFilenameAndSaveRole();
 }
 
 void ResultViewer::generateAnsibleRemediationRole()
 {
-    AnsibleResultRemediationSaver remediation(this, mARF);
+    AnsibleResultRemediationSaver remediation(this, getARFPath());
     remediation.selectFilenameAndSaveRole();
 }
 
 void ResultViewer::generatePuppetRemediationRole()
 {
-    PuppetResultRemediationSaver remediation(this, mARF);
+    PuppetResultRemediationSaver remediation(this, getARFPath());
     remediation.selectFilenameAndSaveRole();
 }
 
@@ -203,10 +241,7 @@ void ResultViewer::saveResults()
     if (filename.isEmpty())
         return;
 
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly);
-    file.write(mResults);
-    file.close();
+    saveArtifact(ScanArtifacts::ARTIFACT_RESULTS, filename);
 }
 
 void ResultViewer::saveARF()
@@ -223,8 +258,21 @@ void ResultViewer::saveARF()
     if (filename.isEmpty())
         return;
 
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly);
-    file.write(mARF);
-    file.close();
+    saveArtifact(ScanArtifacts::ARTIFACT_ARF, filename);
+}
+
+void ResultViewer::saveArtifact(ScanArtifacts::Artifact artifact, const QString& filename)
+{
+    try
+    {
+        if (!mArtifacts)
+            throw ScanArtifactsException("There are no results to save.");
+
+        mArtifacts->copyTo(artifact, filename);
+    }
+    catch (const std::exception& e)
+    {
+        QMessageBox::critical(this, QObject::tr("Failed to save results"),
+            QObject::tr("Failed to write '%1'.\n\n%2").arg(filename, QString::fromUtf8(e.what())));
+    }
 }
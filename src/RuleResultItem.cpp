@@ -25,12 +25,27 @@
 
 RuleResultItem::RuleResultItem(struct xccdf_rule* rule, struct xccdf_policy* policy, QWidget* parent):
     QWidget(parent)
+{
+    init(oscapItemGetReadableTitle(xccdf_rule_to_item(rule), policy),
+        oscapItemGetReadableDescription(xccdf_rule_to_item(rule), policy));
+}
+
+RuleResultItem::RuleResultItem(const QString& title, const QString& descriptionHTML, QWidget* parent):
+    QWidget(parent)
+{
+    init(title, descriptionHTML);
+}
+
+RuleResultItem::~RuleResultItem()
+{}
+
+void RuleResultItem::init(const QString& title, const QString& descriptionHTML)
 {
     mUi.setupUi(this);
     mUi.description->hide();
 
-    mUi.title->setText(oscapItemGetReadableTitle(xccdf_rule_to_item(rule), policy));
-    mDescriptionHTML = oscapItemGetReadableDescription(xccdf_rule_to_item(rule), policy);
+    mUi.title->setText(title);
+    mDescriptionHTML = descriptionHTML;
 
     mUi.showDescriptionCheckBox->setStyleSheet(QString("") +
         "QCheckBox {\n" +
@@ -57,9 +72,6 @@ RuleResultItem::RuleResultItem(struct xccdf_rule* rule, struct xccdf_policy* pol
     );
 }
 
-RuleResultItem::~RuleResultItem()
-{}
-
 void RuleResultItem::setRuleResult(const QString& result)
 {
     QString resultStyleSheet = "text-align: center; font-weight: bold; color: #ffffff; padding: 3px; ";
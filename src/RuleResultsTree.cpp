@@ -24,6 +24,7 @@
 #include "ScanningSession.h"
 #include "APIHelpers.h"
 #include "Exceptions.h"
+#include "SessionMetadataCache.h"
 
 #include <QLabel>
 
@@ -48,34 +49,6 @@ RuleResultsTree::RuleResultsTree(QWidget* parent):
 RuleResultsTree::~RuleResultsTree()
 {}
 
-/*
-Unfortunately, xccdf_policy won't let us see its "selected-final" hashmap.
-Instead we have to gather all rules and for each rule ID we check the policy.
-*/
-inline void gatherAllSelectedRules(struct xccdf_policy* policy, struct xccdf_item* current,
-    std::vector<struct xccdf_rule*>& result)
-{
-    if (xccdf_item_get_type(current) == XCCDF_RULE)
-    {
-        struct xccdf_rule* rule = xccdf_item_to_rule(current);
-        const bool selected = xccdf_policy_is_item_selected(policy, xccdf_rule_get_id(rule));
-
-        if (selected)
-            result.push_back(rule);
-    }
-    else if (xccdf_item_get_type(current) == XCCDF_BENCHMARK ||
-        xccdf_item_get_type(current) == XCCDF_GROUP)
-    {
-        struct xccdf_item_iterator* it = xccdf_item_get_content(current);
-        while (xccdf_item_iterator_has_more(it))
-        {
-            struct xccdf_item* item = xccdf_item_iterator_next(it);
-            gatherAllSelectedRules(policy, item, result);
-        }
-        xccdf_item_iterator_free(it);
-    }
-}
-
 void RuleResultsTree::refreshSelectedRules(ScanningSession* scanningSession)
 {
     clearAllItems();
@@ -131,6 +104,32 @@ void RuleResultsTree::refreshSelectedRules(ScanningSession* scanningSession)
     mUI.scrollArea->setUpdatesEnabled(true);
 }
 
+void RuleResultsTree::refreshSelectedRules(const QList<SessionRuleItem>& rules)
+{
+    clearAllItems();
+
+    mUI.scrollArea->setUpdatesEnabled(false);
+
+    for (QList<SessionRuleItem>::const_iterator it = rules.begin();
+         it != rules.end(); ++it)
+    {
+        RuleResultItem* item = new RuleResultItem(it->title, it->descriptionHTML, mUI.scrollArea);
+
+        QObject::connect(
+            item, SIGNAL(ruleResultDescriptionToggled(bool)),
+            this, SLOT(checkRuleResultsExpanded(bool))
+        );
+
+        mRuleIdToWidgetItemMap[it->id] = item;
+
+        mInternalLayout->addWidget(item);
+    }
+
+    mInternalLayout->addStretch();
+
+    mUI.scrollArea->setUpdatesEnabled(true);
+}
+
 unsigned int RuleResultsTree::getSelectedRulesCount()
 {
     // assumes that we are in a refreshed state
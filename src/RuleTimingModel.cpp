@@ -0,0 +1,184 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "RuleTimingModel.h"
+
+#include <QSettings>
+#include <QDateTime>
+#include <QVariantMap>
+
+/// Assumed duration of a rule if there is no history at all, only relative durations matter then
+static const qint64 UNKNOWN_RULE_DURATION = 1000;
+/// Weight of the newest measurement in the history, the rest is the previous value
+static const double HISTORY_SMOOTHING = 0.5;
+/// A running rule never counts as more than this part of its expected duration
+static const double RUNNING_RULE_MAX_CREDIT = 0.9;
+
+RuleTimingModel::RuleTimingModel():
+    mTotalExpected(0),
+    mFinishedExpected(0),
+    mDefaultDuration(UNKNOWN_RULE_DURATION),
+    mStartTime(0),
+    mLastFinishTime(0)
+{}
+
+RuleTimingModel::~RuleTimingModel()
+{}
+
+void RuleTimingModel::start(const QString& benchmarkID, const QString& target, const QStringList& ruleIDs)
+{
+    mBenchmarkID = benchmarkID;
+    mTarget = target;
+
+    mHistory.clear();
+    mMeasured.clear();
+    mRunning.clear();
+
+    QSettings settings;
+    const QVariantMap history = settings.value(settingsKey(benchmarkID, target)).toMap();
+    for (QVariantMap::const_iterator it = history.constBegin(); it != history.constEnd(); ++it)
+        mHistory.insert(it.key(), it.value().toLongLong());
+
+    mPlannedRules = ruleIDs.toSet();
+
+    // rules we know nothing about are assumed to be average
+    qint64 knownSum = 0;
+    int knownCount = 0;
+    for (QSet<QString>::const_iterator it = mPlannedRules.constBegin(); it != mPlannedRules.constEnd(); ++it)
+    {
+        QHash<QString, qint64>::const_iterator known = mHistory.constFind(*it);
+        if (known != mHistory.constEnd())
+        {
+            knownSum += *known;
+            ++knownCount;
+        }
+    }
+    mDefaultDuration = knownCount > 0 ? qMax(knownSum / knownCount, qint64(1)) : UNKNOWN_RULE_DURATION;
+
+    mTotalExpected = 0;
+    for (QSet<QString>::const_iterator it = mPlannedRules.constBegin(); it != mPlannedRules.constEnd(); ++it)
+        mTotalExpected += getExpectedDuration(*it);
+
+    mFinishedExpected = 0;
+    mStartTime = QDateTime::currentMSecsSinceEpoch();
+    mLastFinishTime = mStartTime;
+}
+
+void RuleTimingModel::save()
+{
+    if (!isStarted() || mMeasured.isEmpty())
+        return;
+
+    QVariantMap history;
+    for (QHash<QString, qint64>::const_iterator it = mHistory.constBegin(); it != mHistory.constEnd(); ++it)
+        history.insert(it.key(), it.value());
+
+    for (QHash<QString, qint64>::const_iterator it = mMeasured.constBegin(); it != mMeasured.constEnd(); ++it)
+    {
+        QVariantMap::iterator previous = history.find(it.key());
+        if (previous == history.end())
+            history.insert(it.key(), it.value());
+        else
+            *previous = qint64(HISTORY_SMOOTHING * it.value() + (1 - HISTORY_SMOOTHING) * previous->toLongLong());
+    }
+
+    QSettings settings;
+    settings.setValue(settingsKey(mBenchmarkID, mTarget), history);
+}
+
+bool RuleTimingModel::isStarted() const
+{
+    return mStartTime != 0;
+}
+
+void RuleTimingModel::ruleStarted(const QString& ruleID)
+{
+    if (!mRunning.contains(ruleID))
+        mRunning.insert(ruleID, QDateTime::currentMSecsSinceEpoch());
+}
+
+void RuleTimingModel::ruleFinished(const QString& ruleID)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // multi-check rules report several results, only the first one is measured
+    if (mMeasured.contains(ruleID))
+        return;
+
+    const qint64 started = mRunning.contains(ruleID) ? mRunning.take(ruleID) : mLastFinishTime;
+    mMeasured.insert(ruleID, qMax(now - started, qint64(0)));
+    mLastFinishTime = now;
+
+    if (mPlannedRules.contains(ruleID))
+        mFinishedExpected += getExpectedDuration(ruleID);
+}
+
+double RuleTimingModel::getProgress() const
+{
+    if (mTotalExpected <= 0)
+        return 0;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // rules taking minutes would leave the progress standing still otherwise
+    double runningCredit = 0;
+    for (QHash<QString, qint64>::const_iterator it = mRunning.constBegin(); it != mRunning.constEnd(); ++it)
+    {
+        const double expected = getExpectedDuration(it.key());
+        runningCredit += qMin(double(now - it.value()), RUNNING_RULE_MAX_CREDIT * expected);
+    }
+
+    return qBound(0.0, (mFinishedExpected + runningCredit) / mTotalExpected, 1.0);
+}
+
+int RuleTimingModel::getRemainingSeconds() const
+{
+    const double progress = getProgress();
+    const qint64 elapsed = QDateTime::currentMSecsSinceEpoch() - mStartTime;
+
+    // too early to tell
+    if (!isStarted() || progress < 0.01 || elapsed < 2000)
+        return -1;
+
+    // the elapsed time already covers the speed of the target and parallel evaluation
+    return int(elapsed * (1 - progress) / progress / 1000);
+}
+
+const QHash<QString, qint64>& RuleTimingModel::getMeasuredDurations() const
+{
+    return mMeasured;
+}
+
+qint64 RuleTimingModel::getExpectedDuration(const QString& ruleID) const
+{
+    QHash<QString, qint64>::const_iterator it = mHistory.constFind(ruleID);
+    // rules measured to take 0ms still take some time
+    return it != mHistory.constEnd() ? qMax(*it, qint64(1)) : mDefaultDuration;
+}
+
+// Targets may contain characters with special meaning in QSettings keys ('/')
+QString RuleTimingModel::settingsKey(const QString& benchmarkID, const QString& target)
+{
+    return QString("rule-timings/%1/%2")
+        .arg(QString::fromLatin1(benchmarkID.toUtf8().toHex()))
+        .arg(QString::fromLatin1(target.toUtf8().toHex()));
+}
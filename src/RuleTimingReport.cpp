@@ -0,0 +1,230 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "RuleTimingReport.h"
+#include "ScanningSession.h"
+#include "APIHelpers.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+extern "C"
+{
+#include <xccdf_session.h>
+}
+
+RuleTimingReport::RuleTimingReport():
+    mTotalDuration(0)
+{}
+
+RuleTimingReport::~RuleTimingReport()
+{}
+
+void RuleTimingReport::build(const QHash<QString, qint64>& durations, ScanningSession* session)
+{
+    clear();
+
+    QHash<QString, QString> titles;
+
+    if (session && session->fileOpened())
+    {
+        try
+        {
+            struct xccdf_benchmark* benchmark = session->getXCCDFInputBenchmark();
+            struct xccdf_policy* policy = xccdf_session_get_xccdf_policy(session->getXCCDFSession());
+
+            if (benchmark)
+            {
+                QList<int> groupStack;
+                addGroups(xccdf_benchmark_to_item(benchmark), policy, durations, groupStack);
+            }
+
+            for (QHash<QString, qint64>::const_iterator it = durations.constBegin(); it != durations.constEnd(); ++it)
+            {
+                struct xccdf_item* item = benchmark ?
+                    xccdf_benchmark_get_item(benchmark, it.key().toUtf8().constData()) : NULL;
+                if (item)
+                    titles.insert(it.key(), oscapItemGetReadableTitle(item, policy));
+            }
+        }
+        catch (const std::exception&)
+        {
+            // the report is still useful without titles and groups
+        }
+    }
+
+    for (QHash<QString, qint64>::const_iterator it = durations.constBegin(); it != durations.constEnd(); ++it)
+    {
+        Entry rule;
+        rule.id = it.key();
+        rule.title = titles.value(it.key());
+        rule.duration = it.value();
+        rule.ruleCount = 1;
+        mRules.append(rule);
+
+        mTotalDuration += it.value();
+    }
+
+    std::stable_sort(mRules.begin(), mRules.end(), slowerThan);
+    std::stable_sort(mGroups.begin(), mGroups.end(), slowerThan);
+}
+
+void RuleTimingReport::clear()
+{
+    mRules.clear();
+    mGroups.clear();
+    mTotalDuration = 0;
+}
+
+bool RuleTimingReport::isEmpty() const
+{
+    return mRules.isEmpty();
+}
+
+const QList<RuleTimingReport::Entry>& RuleTimingReport::getRules() const
+{
+    return mRules;
+}
+
+const QList<RuleTimingReport::Entry>& RuleTimingReport::getGroups() const
+{
+    return mGroups;
+}
+
+qint64 RuleTimingReport::getTotalDuration() const
+{
+    return mTotalDuration;
+}
+
+QByteArray RuleTimingReport::toCSV() const
+{
+    QString csv = "type,id,title,duration_ms,share_percent,rules\n";
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        const QList<Entry>& entries = pass == 0 ? mRules : mGroups;
+        for (QList<Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+        {
+            const double share = mTotalDuration > 0 ? 100.0 * it->duration / mTotalDuration : 0;
+
+            // multi-argument arg() so that '%' in titles is never substituted
+            csv += QString("%1,%2,%3,%4,%5,%6\n").arg(
+                pass == 0 ? "rule" : "group",
+                csvQuote(it->id),
+                csvQuote(it->title),
+                QString::number(it->duration),
+                QString::number(share, 'f', 2),
+                QString::number(it->ruleCount));
+        }
+    }
+
+    return csv.toUtf8();
+}
+
+QByteArray RuleTimingReport::toJSON() const
+{
+    QString json = QString("{\n  \"total_duration_ms\": %1,\n  \"rules\": [").arg(mTotalDuration);
+    appendJSONEntries(json, mRules, false);
+    json += "\n  ],\n  \"groups\": [";
+    appendJSONEntries(json, mGroups, true);
+    json += "\n  ]\n}\n";
+
+    return json.toUtf8();
+}
+
+void RuleTimingReport::addGroups(struct xccdf_item* item, struct xccdf_policy* policy,
+    const QHash<QString, qint64>& durations, QList<int>& groupStack)
+{
+    const xccdf_type_t type = xccdf_item_get_type(item);
+
+    if (type == XCCDF_RULE)
+    {
+        QHash<QString, qint64>::const_iterator duration = durations.constFind(QString::fromUtf8(xccdf_item_get_id(item)));
+        if (duration == durations.constEnd())
+            return;
+
+        // the rule counts for all groups it is nested in
+        for (QList<int>::const_iterator it = groupStack.constBegin(); it != groupStack.constEnd(); ++it)
+        {
+            mGroups[*it].duration += *duration;
+            mGroups[*it].ruleCount += 1;
+        }
+    }
+    else if (type == XCCDF_BENCHMARK || type == XCCDF_GROUP)
+    {
+        const bool isGroup = type == XCCDF_GROUP;
+        if (isGroup)
+        {
+            Entry group;
+            group.id = QString::fromUtf8(xccdf_item_get_id(item));
+            group.title = oscapItemGetReadableTitle(item, policy);
+            group.duration = 0;
+            group.ruleCount = 0;
+            mGroups.append(group);
+            groupStack.append(mGroups.size() - 1);
+        }
+
+        struct xccdf_item_iterator* it = xccdf_item_get_content(item);
+        while (xccdf_item_iterator_has_more(it))
+            addGroups(xccdf_item_iterator_next(it), policy, durations, groupStack);
+        xccdf_item_iterator_free(it);
+
+        if (isGroup)
+        {
+            groupStack.removeLast();
+
+            // groups with no evaluated rules would only clutter the report
+            if (mGroups.last().ruleCount == 0)
+                mGroups.removeLast();
+        }
+    }
+}
+
+bool RuleTimingReport::slowerThan(const Entry& a, const Entry& b)
+{
+    return a.duration > b.duration;
+}
+
+QString RuleTimingReport::csvQuote(const QString& value)
+{
+    if (!value.contains(',') && !value.contains('"') && !value.contains('\n'))
+        return value;
+
+    QString ret = value;
+    ret.replace("\"", "\"\"");
+    return "\"" + ret + "\"";
+}
+
+void RuleTimingReport::appendJSONEntries(QString& json, const QList<Entry>& entries, bool groups)
+{
+    for (QList<Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        json += it == entries.constBegin() ? "\n    " : ",\n    ";
+        json += QString("{\"id\": %1, \"title\": %2, \"duration_ms\": %3").arg(
+            jsonQuote(it->id), jsonQuote(it->title), QString::number(it->duration));
+
+        if (groups)
+            json += QString(", \"rules\": %1").arg(it->ruleCount);
+
+        json += "}";
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "RuleTimingsDialog.h"
+
+#include <QFileDialog>
+#include <QMessageBox>
+
+RuleTimingsDialog::RuleTimingsDialog(QWidget* parent):
+    QDialog(parent)
+{
+    mUI.setupUi(this);
+
+    QObject::connect(
+        mUI.saveCSVButton, SIGNAL(clicked()),
+        this, SLOT(saveCSV())
+    );
+    QObject::connect(
+        mUI.saveJSONButton, SIGNAL(clicked()),
+        this, SLOT(saveJSON())
+    );
+    QObject::connect(
+        mUI.closeButton, SIGNAL(clicked()),
+        this, SLOT(hide())
+    );
+}
+
+RuleTimingsDialog::~RuleTimingsDialog()
+{}
+
+void RuleTimingsDialog::setReport(const RuleTimingReport& report, const QString& baseName)
+{
+    mReport = report;
+    mBaseName = baseName;
+
+    mUI.summaryLabel->setText(QObject::tr("%1 rules were evaluated in %2 s in total.")
+        .arg(mReport.getRules().size()).arg(mReport.getTotalDuration() / 1000.0, 0, 'f', 1));
+
+    fillTable(mUI.rulesTable, mReport.getRules(), false);
+    fillTable(mUI.groupsTable, mReport.getGroups(), true);
+}
+
+void RuleTimingsDialog::saveCSV()
+{
+    saveFile(QObject::tr("Save Rule Timings (CSV)"),
+        QObject::tr("%1-rule-timings.csv").arg(mBaseName),
+        QObject::tr("CSV (*.csv)"), mReport.toCSV());
+}
+
+void RuleTimingsDialog::saveJSON()
+{
+    saveFile(QObject::tr("Save Rule Timings (JSON)"),
+        QObject::tr("%1-rule-timings.json").arg(mBaseName),
+        QObject::tr("JSON (*.json)"), mReport.toJSON());
+}
+
+void RuleTimingsDialog::fillTable(QTableWidget* table, const QList<RuleTimingReport::Entry>& entries, bool groups)
+{
+    // sorting while filling would shuffle the rows we are filling
+    table->setSortingEnabled(false);
+    table->clearContents();
+    table->setRowCount(entries.size());
+
+    const qint64 total = mReport.getTotalDuration();
+
+    int row = 0;
+    for (QList<RuleTimingReport::Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it, ++row)
+    {
+        QTableWidgetItem* duration = new QTableWidgetItem();
+        duration->setData(Qt::DisplayRole, it->duration / 1000.0);
+        QTableWidgetItem* share = new QTableWidgetItem();
+        share->setData(Qt::DisplayRole, total > 0 ? qRound(1000.0 * it->duration / total) / 10.0 : 0.0);
+
+        table->setItem(row, 0, new QTableWidgetItem(it->id));
+        table->setItem(row, 1, new QTableWidgetItem(it->title));
+        table->setItem(row, 2, duration);
+        table->setItem(row, 3, share);
+
+        if (groups)
+        {
+            QTableWidgetItem* rules = new QTableWidgetItem();
+            rules->setData(Qt::DisplayRole, it->ruleCount);
+            table->setItem(row, 4, rules);
+        }
+    }
+
+    table->setSortingEnabled(true);
+    table->sortByColumn(2, Qt::DescendingOrder);
+    table->resizeColumnToContents(0);
+}
+
+void RuleTimingsDialog::saveFile(const QString& caption, const QString& fileName, const QString& filter, const QByteArray& data)
+{
+    const QString filename = QFileDialog::getSaveFileName(this,
+        caption, fileName, filter, 0
+#ifndef SCAP_WORKBENCH_USE_NATIVE_FILE_DIALOGS
+        , QFileDialog::DontUseNativeDialog
+#endif
+    );
+
+    if (filename.isEmpty())
+        return;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+    {
+        QMessageBox::critical(this, QObject::tr("Failed to save rule timings"),
+            QObject::tr("Failed to write '%1'.").arg(filename));
+    }
+}
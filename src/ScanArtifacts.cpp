@@ -0,0 +1,140 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ScanArtifacts.h"
+#include "Exceptions.h"
+#include "ScratchSpace.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+/// Chunk size used when copying artifacts
+static const qint64 COPY_CHUNK_SIZE = 64 * 1024;
+
+static const char* getFileName(ScanArtifacts::Artifact artifact)
+{
+    switch (artifact)
+    {
+        case ScanArtifacts::ARTIFACT_RESULTS:
+            return "xccdf-results.xml";
+        case ScanArtifacts::ARTIFACT_REPORT:
+            return "report.html";
+        case ScanArtifacts::ARTIFACT_ARF:
+            return "arf.xml";
+    }
+
+    return "";
+}
+
+ScanArtifacts::ScanArtifacts():
+    mDir(ScratchSpace::getDirectory())
+{}
+
+ScanArtifacts::~ScanArtifacts()
+{}
+
+QString ScanArtifacts::getPath(Artifact artifact) const
+{
+    return mDir.getPath() + "/" + getFileName(artifact);
+}
+
+bool ScanArtifacts::has(Artifact artifact) const
+{
+    return getSize(artifact) > 0;
+}
+
+qint64 ScanArtifacts::getSize(Artifact artifact) const
+{
+    const QFileInfo info(getPath(artifact));
+    return info.exists() ? info.size() : 0;
+}
+
+void ScanArtifacts::adopt(Artifact artifact, const QString& path)
+{
+    const QString destination = getPath(artifact);
+    if (path == destination)
+        return;
+
+    QFile::remove(destination);
+
+    // renaming is free on the same filesystem, QFile::rename falls back to copying otherwise
+    if (!QFile::rename(path, destination))
+        throw ScanArtifactsException(QString("Failed to move '%1' to '%2'.").arg(path, destination));
+}
+
+void ScanArtifacts::write(Artifact artifact, const QByteArray& data)
+{
+    QFile file(getPath(artifact));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+        throw ScanArtifactsException(QString("Failed to write '%1'.").arg(file.fileName()));
+}
+
+QByteArray ScanArtifacts::read(Artifact artifact) const
+{
+    QFile file(getPath(artifact));
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    return file.readAll();
+}
+
+void ScanArtifacts::copyTo(Artifact artifact, const QString& destination) const
+{
+    QFile source(getPath(artifact));
+    if (!source.open(QIODevice::ReadOnly))
+        throw ScanArtifactsException(QString("Failed to open '%1' for reading.").arg(source.fileName()));
+
+    QFile target(destination);
+    if (!target.open(QIODevice::WriteOnly))
+        throw ScanArtifactsException(QString("Failed to open '%1' for writing.").arg(destination));
+
+    QByteArray chunk;
+    while (!(chunk = source.read(COPY_CHUNK_SIZE)).isEmpty())
+    {
+        if (target.write(chunk) != chunk.size())
+            throw ScanArtifactsException(QString("Failed to write '%1'.").arg(destination));
+    }
+
+    if (source.error() != QFile::NoError)
+        throw ScanArtifactsException(QString("Failed to read '%1'.").arg(source.fileName()));
+}
+
+void ScanArtifacts::clear()
+{
+    QFile::remove(getPath(ARTIFACT_RESULTS));
+    QFile::remove(getPath(ARTIFACT_REPORT));
+    QFile::remove(getPath(ARTIFACT_ARF));
+}
+
+QString ScanArtifacts::getOutputFileName(Artifact artifact, const QString& baseName)
+{
+    switch (artifact)
+    {
+        case ARTIFACT_RESULTS:
+            return QString("%1-xccdf.results.xml").arg(baseName);
+        case ARTIFACT_REPORT:
+            return QString("%1-xccdf.report.html").arg(baseName);
+        case ARTIFACT_ARF:
+        default:
+            return QString("%1-arf.xml").arg(baseName);
+    }
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ScanTrace.h"
+#include "Utils.h"
+
+#include <QThread>
+#include <QSettings>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QRegExp>
+
+// Current trace of each thread. QThreadStorage would delete the trace when
+// the thread exits, the scanner owns it instead.
+static QMutex currentTracesMutex;
+static QHash<Qt::HANDLE, ScanTrace*> currentTraces;
+
+ScanTrace::Span::Span(const QString& name, const QString& category):
+    mTrace(ScanTrace::getCurrent()),
+    mName(name),
+    mCategory(category),
+    mStart(mTrace ? mTrace->now() : 0)
+{}
+
+ScanTrace::Span::~Span()
+{
+    end();
+}
+
+void ScanTrace::Span::setArgument(const QString& key, const QString& value)
+{
+    if (mTrace)
+        mArguments.append(qMakePair(key, value));
+}
+
+void ScanTrace::Span::end()
+{
+    if (!mTrace)
+        return;
+
+    mTrace->addSpan(mName, mCategory, mStart, mTrace->now() - mStart, mArguments);
+    mTrace = 0;
+}
+
+ScanTrace* ScanTrace::createIfEnabled(const QString& target)
+{
+    QString directory = QString::fromLocal8Bit(qgetenv("SCAP_WORKBENCH_TRACE_DIR"));
+    if (directory.isEmpty())
+    {
+        QSettings settings;
+        directory = settings.value("scan-trace-directory").toString();
+    }
+
+    if (directory.isEmpty())
+        return 0;
+
+    return new ScanTrace(directory, target);
+}
+
+ScanTrace::ScanTrace(const QString& directory, const QString& target):
+    mDirectory(directory),
+    mTarget(target),
+    mCreated(QDateTime::currentDateTime())
+{
+    mTimer.start();
+}
+
+ScanTrace::~ScanTrace()
+{
+    // don't leave a dangling current trace behind
+    QMutexLocker locker(&currentTracesMutex);
+    for (QHash<Qt::HANDLE, ScanTrace*>::iterator it = currentTraces.begin(); it != currentTraces.end();)
+    {
+        if (it.value() == this)
+            it = currentTraces.erase(it);
+        else
+            ++it;
+    }
+}
+
+qint64 ScanTrace::now() const
+{
+    return mTimer.nsecsElapsed() / 1000;
+}
+
+void ScanTrace::addSpan(const QString& name, const QString& category, qint64 start, qint64 duration,
+    const Arguments& arguments)
+{
+    QMutexLocker locker(&mMutex);
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.duration = duration;
+    event.thread = currentThreadIndex();
+    event.arguments = arguments;
+    mEvents.append(event);
+}
+
+QString ScanTrace::write() const
+{
+    QMutexLocker locker(&mMutex);
+
+    QString json = "{\"displayTimeUnit\": \"ms\", \"otherData\": {";
+    // multi-argument arg() so that '%' in the values is never substituted
+    json += QString("\"target\": %1, \"started\": %2, \"version\": %3}").arg(
+        jsonQuote(mTarget),
+        jsonQuote(mCreated.toString(Qt::ISODate)),
+        jsonQuote(QCoreApplication::applicationVersion()));
+    json += ",\n\"traceEvents\": [\n";
+    json += QString("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": %1}}")
+        .arg(jsonQuote(QString("scan of %1").arg(mTarget)));
+
+    for (QList<Event>::const_iterator it = mEvents.constBegin(); it != mEvents.constEnd(); ++it)
+    {
+        json += QString(",\n{\"name\": %1, \"cat\": %2, \"ph\": \"X\", \"ts\": %3, \"dur\": %4, \"pid\": 1, \"tid\": %5, \"args\": {").arg(
+            jsonQuote(it->name), jsonQuote(it->category),
+            QString::number(it->start), QString::number(it->duration), QString::number(it->thread));
+
+        for (Arguments::const_iterator arg = it->arguments.constBegin(); arg != it->arguments.constEnd(); ++arg)
+        {
+            if (arg != it->arguments.constBegin())
+                json += ", ";
+            json += QString("%1: %2").arg(jsonQuote(arg->first), jsonQuote(arg->second));
+        }
+
+        json += "}}";
+    }
+    json += "\n]}\n";
+
+    // targets contain '@' and ':', keep the file names portable
+    QString targetName = mTarget;
+    targetName.replace(QRegExp("[^A-Za-z0-9._-]"), "_");
+
+    const QDir dir(mDirectory);
+    if (!dir.exists() && !QDir().mkpath(mDirectory))
+        return QString();
+
+    const QString path = dir.absoluteFilePath(QString("scap-workbench-trace-%1-%2.json")
+        .arg(targetName).arg(mCreated.toString("yyyyMMdd-hhmmss-zzz")));
+
+    QFile file(path);
+    const QByteArray data = json.toUtf8();
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+        return QString();
+
+    return path;
+}
+
+void ScanTrace::setCurrent(ScanTrace* trace)
+{
+    QMutexLocker locker(&currentTracesMutex);
+
+    if (trace)
+        currentTraces.insert(QThread::currentThreadId(), trace);
+    else
+        currentTraces.remove(QThread::currentThreadId());
+}
+
+ScanTrace* ScanTrace::getCurrent()
+{
+    QMutexLocker locker(&currentTracesMutex);
+    return currentTraces.value(QThread::currentThreadId(), 0);
+}
+
+int ScanTrace::currentThreadIndex()
+{
+    // mMutex is held by the caller
+    const Qt::HANDLE thread = QThread::currentThreadId();
+
+    QHash<Qt::HANDLE, int>::const_iterator it = mThreads.constFind(thread);
+    if (it != mThreads.constEnd())
+        return *it;
+
+    const int index = mThreads.size() + 1;
+    mThreads.insert(thread, index);
+    return index;
+}
@@ -20,6 +20,8 @@
  */
 
 #include "Scanner.h"
+#include "ScanTrace.h"
+#include "ScanArtifacts.h"
 #include <QThread>
 
 Scanner::Scanner():
@@ -30,11 +32,14 @@ Scanner::Scanner():
     mSkipValid(false),
     mFetchRemoteResources(false),
     mSession(0),
-    mTarget("")
+    mTarget(""),
+    mPreviousArtifacts(0)
 {}
 
 Scanner::~Scanner()
-{}
+{
+    delete mPreviousArtifacts;
+}
 
 void Scanner::setScanThread(QThread* thread)
 {
@@ -73,7 +78,6 @@ bool Scanner::getFetchRemoteResources() const
 
 void Scanner::setSession(ScanningSession* session)
 {
-    // TODO: assert that we are not running
     mSession = session;
 }
 
@@ -82,9 +86,18 @@ ScanningSession* Scanner::getSession() const
     return mSession;
 }
 
+void Scanner::setTailoringFile(const QString& path)
+{
+    mTailoringFile = path;
+}
+
+const QString& Scanner::getTailoringFile() const
+{
+    return mTailoringFile;
+}
+
 void Scanner::setTarget(const QString& target)
 {
-    // TODO: assert that we are not running
     mTarget = target;
 }
 
@@ -95,7 +108,6 @@ const QString& Scanner::getTarget() const
 
 void Scanner::setScannerMode(ScannerMode mode)
 {
-    // TODO: assert that we are not running
     mScannerMode = mode;
 }
 
@@ -104,27 +116,60 @@ ScannerMode Scanner::getScannerMode() const
     return mScannerMode;
 }
 
-void Scanner::setARFForRemediation(const QByteArray& results)
+void Scanner::setPreviousArtifacts(ScanArtifacts* artifacts)
 {
-    mARFForRemediation = results;
+    if (artifacts != mPreviousArtifacts)
+        delete mPreviousArtifacts;
+
+    mPreviousArtifacts = artifacts;
+}
+
+QString Scanner::getPreviousResultsPath() const
+{
+    if (!mPreviousArtifacts || !mPreviousArtifacts->has(ScanArtifacts::ARTIFACT_RESULTS))
+        return QString();
+
+    return mPreviousArtifacts->getPath(ScanArtifacts::ARTIFACT_RESULTS);
 }
 
-const QByteArray& Scanner::getARFForRemediation() const
+QString Scanner::getPreviousARFPath() const
 {
-    return mARFForRemediation;
+    if (!mPreviousArtifacts || !mPreviousArtifacts->has(ScanArtifacts::ARTIFACT_ARF))
+        return QString();
+
+    return mPreviousArtifacts->getPath(ScanArtifacts::ARTIFACT_ARF);
 }
 
 void Scanner::evaluateExceptionGuard()
 {
-    try
+    // the trace belongs to this call, the scanner may be deleted by the main
+    // thread as soon as evaluate() signals completion
+    ScanTrace* trace = mDryRun ? 0 : ScanTrace::createIfEnabled(mTarget);
+    ScanTrace::setCurrent(trace);
+
     {
-        evaluate();
+        ScanTrace::Span span("scan");
+        span.setArgument("target", mTarget);
+        span.setArgument("mode", QString::number(mScannerMode));
+
+        try
+        {
+            evaluate();
+        }
+        catch (const std::exception& e)
+        {
+            span.setArgument("exception", QString::fromUtf8(e.what()));
+            emit errorMessage(
+                QObject::tr("Exception was thrown while evaluating! Details follow:\n%1").arg(QString::fromUtf8(e.what())));
+            signalCompletion(true);
+        }
     }
-    catch (const std::exception& e)
+
+    if (trace)
     {
-        emit errorMessage(
-            QObject::tr("Exception was thrown while evaluating! Details follow:\n%1").arg(QString::fromUtf8(e.what())));
-        signalCompletion(true);
+        trace->write();
+        ScanTrace::setCurrent(0);
+        delete trace;
     }
 }
 
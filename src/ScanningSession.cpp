@@ -23,6 +23,8 @@
 #include "ResultViewer.h"
 #include "Exceptions.h"
 #include "APIHelpers.h"
+#include "ValidationCache.h"
+#include "Utils.h"
 
 extern "C" {
 #include <xccdf_policy.h>
@@ -30,6 +32,7 @@ extern "C" {
 #include <scap_ds.h>
 #include <oscap.h>
 #include <oscap_error.h>
+#include <oscap_source.h>
 }
 
 #include <cassert>
@@ -46,7 +49,7 @@ ScanningSession::ScanningSession():
     mTailoring(0),
 
     mSkipValid(false),
-    mSessionDirty(false),
+    mDirtyLayers(0),
     mTailoringUserChanges(false)
 {
     mTailoringFile.setAutoRemove(true);
@@ -65,13 +68,18 @@ void ScanningSession::setSkipValid(bool skipValid)
         xccdf_session_set_validation(mSession, mSkipValid, false);
 }
 
+bool ScanningSession::getSkipValid() const
+{
+    return mSkipValid;
+}
+
 struct xccdf_session* ScanningSession::getXCCDFSession() const
 {
     reloadSession();
     return mSession;
 }
 
-void ScanningSession::openFile(const QString& path)
+void ScanningSession::openFile(const QString& path, bool load)
 {
     if (mSession)
         closeFile();
@@ -88,25 +96,29 @@ void ScanningSession::openFile(const QString& path)
 
     xccdf_session_set_validation(mSession, mSkipValid, false);
 
-    mSessionDirty = true;
+    mDirtyLayers = DIRTY_CONTENT;
     mTailoringUserChanges = false;
 
     // set default profile after opening, this ensures that xccdf_policy can be returned
-    setProfile(QString());
+    if (load)
+        setProfile(QString());
 }
 
 void ScanningSession::closeFile()
 {
     if (mSession)
     {
-        // session "owns" mTailoring and will free it as part of xccdf_policy_model
-        xccdf_session_free(mSession);
-
-        mSession = 0;
-        mTailoring = 0;
+        // session "owns" mTailoring and will free it as part of xccdf_policy_model,
+        // the content is kept in the pool in case it gets opened again
+        releaseSession();
 
-        mSessionDirty = false;
+        mDirtyLayers = 0;
         mTailoringUserChanges = false;
+
+        mUserTailoringFile = "";
+        mUserTailoringCID = "";
+        mRequestedDatastreamID = "";
+        mRequestedComponentID = "";
     }
 }
 
@@ -303,7 +315,8 @@ void ScanningSession::setDatastreamID(const QString& datastreamID)
     else
         xccdf_session_set_datastream_id(mSession, datastreamID.toUtf8().constData());
 
-    mSessionDirty = true;
+    mRequestedDatastreamID = datastreamID;
+    mDirtyLayers |= DIRTY_CONTENT;
 }
 
 QString ScanningSession::getDatastreamID() const
@@ -323,7 +336,8 @@ void ScanningSession::setComponentID(const QString& componentID)
     else
         xccdf_session_set_component_id(mSession, componentID.toUtf8().constData());
 
-    mSessionDirty = true;
+    mRequestedComponentID = componentID;
+    mDirtyLayers |= DIRTY_CONTENT;
 }
 
 QString ScanningSession::getComponentID() const
@@ -359,7 +373,7 @@ void ScanningSession::resetTailoring()
     xccdf_session_set_user_tailoring_file(mSession, 0);
     mUserTailoringFile = "";
 
-    mSessionDirty = true;
+    mDirtyLayers |= DIRTY_TAILORING;
     mTailoringUserChanges = false;
 }
 
@@ -379,7 +393,7 @@ void ScanningSession::setTailoringFile(const QString& tailoringFile)
     xccdf_session_set_user_tailoring_file(mSession, tailoringFile.toUtf8().constData());
     mUserTailoringFile = tailoringFile;
 
-    mSessionDirty = true;
+    mDirtyLayers |= DIRTY_TAILORING;
     mTailoringUserChanges = false;
 }
 
@@ -399,7 +413,8 @@ void ScanningSession::setTailoringComponentID(const QString& componentID)
     xccdf_session_set_user_tailoring_cid(mSession, componentID.toUtf8().constData());
     mUserTailoringCID = componentID;
 
-    mSessionDirty = true;
+    // a tailoring component can only be loaded together with the datastream
+    mDirtyLayers |= DIRTY_CONTENT;
     mTailoringUserChanges = false;
 }
 
@@ -608,17 +623,88 @@ bool ScanningSession::isSelectedProfileTailoring() const
 }
 
 
+/// Sets up parameters of a session so that loading it gives content of given key
+static void applyPoolKey(struct xccdf_session* session, const SessionPoolKey& key)
+{
+    xccdf_session_set_datastream_id(session,
+        key.datastreamID.isEmpty() ? 0 : key.datastreamID.toUtf8().constData());
+    xccdf_session_set_component_id(session,
+        key.componentID.isEmpty() ? 0 : key.componentID.toUtf8().constData());
+    xccdf_session_set_user_tailoring_file(session,
+        key.tailoringFile.isEmpty() ? 0 : key.tailoringFile.toUtf8().constData());
+    xccdf_session_set_user_tailoring_cid(session,
+        key.tailoringComponentID.isEmpty() ? 0 : key.tailoringComponentID.toUtf8().constData());
+    xccdf_session_set_validation(session, key.skipValid, false);
+}
+
 void ScanningSession::reloadSession(bool forceReload) const
 {
     if (!fileOpened())
         throw ScanningSessionException(
             QString("Can't reload session, file hasn't been opened!"));
 
-    if (mSessionDirty || forceReload)
+    if (mDirtyLayers == DIRTY_TAILORING && !forceReload && reloadTailoring())
     {
-        if (xccdf_session_load(mSession) != 0)
-            throw ScanningSessionException(
-                QString("Failed to reload session. OpenSCAP error message:\n%1").arg(oscapErrGetFullError()));
+        mDirtyLayers = 0;
+
+        if (mLoadedKey.isValid())
+            mLoadedKey = getPoolKey();
+    }
+    else if (mDirtyLayers != 0 || forceReload)
+    {
+        const SessionPoolKey key = getPoolKey();
+
+        // our own tailoring lives in the policy model of mSession, it has to stay
+        const bool canSwapSession = !mTailoringUserChanges && key.isValid();
+
+        struct xccdf_session* pooled = canSwapSession ? mSessionPool.take(key) : 0;
+        if (pooled)
+        {
+            releaseSession();
+            mSession = pooled;
+        }
+        else
+        {
+            // keep the loaded content in the pool and load into a new session
+            if (canSwapSession && mLoadedKey.isValid() && !(mLoadedKey == key))
+            {
+                struct xccdf_session* session = xccdf_session_new(key.contentPath.toUtf8().constData());
+                if (!session)
+                    throw ScanningSessionException(
+                        QString("Failed to create session for '%1'. OpenSCAP error message:\n%2").arg(key.contentPath).arg(oscapErrDesc()));
+
+                applyPoolKey(session, key);
+                releaseSession();
+                mSession = session;
+            }
+
+            // content that has already passed validation is not validated again
+            QString validationKey;
+            bool skipValid = mSkipValid;
+            if (!mSkipValid && ValidationCache::isEnabled())
+            {
+                validationKey = ValidationCache::getKey(getOpenedFilePath(), mUserTailoringFile,
+                    getDatastreamID(), getComponentID(), mUserTailoringCID);
+                skipValid = ValidationCache::isKnownValid(validationKey);
+            }
+
+            // the content of mSession gets replaced, nothing can be reused if the load fails
+            mLoadedKey = SessionPoolKey();
+
+            xccdf_session_set_validation(mSession, skipValid, false);
+            const int loadResult = xccdf_session_load(mSession);
+            xccdf_session_set_validation(mSession, mSkipValid, false);
+
+            if (loadResult != 0)
+                throw ScanningSessionException(
+                    QString("Failed to reload session. OpenSCAP error message:\n%1").arg(oscapErrGetFullError()));
+
+            // files referenced by plain XCCDF content are not covered by the key
+            if (!skipValid && xccdf_session_is_sds(mSession))
+                ValidationCache::markValid(validationKey);
+        }
+
+        mLoadedKey = key;
 
         struct xccdf_policy_model* policyModel = xccdf_session_get_policy_model(mSession);
 
@@ -631,10 +717,134 @@ void ScanningSession::reloadSession(bool forceReload) const
         else
             xccdf_policy_model_set_tailoring(policyModel, mTailoring);
 
-        mSessionDirty = false;
+        mDirtyLayers = 0;
     }
 }
 
+SessionPoolKey ScanningSession::getPoolKey() const
+{
+    SessionPoolKey key;
+    key.contentPath = getOpenedFilePath();
+    key.contentHash = computeFileHash(key.contentPath);
+    key.datastreamID = mRequestedDatastreamID;
+    key.componentID = mRequestedComponentID;
+    key.tailoringFile = mUserTailoringFile;
+    key.tailoringComponentID = mUserTailoringCID;
+    key.skipValid = mSkipValid;
+
+    if (!mUserTailoringFile.isEmpty())
+    {
+        key.tailoringFileHash = computeFileHash(mUserTailoringFile);
+
+        // content of the tailoring file is unknown, the session can't be reused
+        if (key.tailoringFileHash.isEmpty())
+            return SessionPoolKey();
+    }
+
+    return key;
+}
+
+void ScanningSession::releaseSession() const
+{
+    if (!mSession)
+        return;
+
+    // user changes to the tailoring are in the policy model, such session can't be reused
+    if (mLoadedKey.isValid() && !mTailoringUserChanges)
+    {
+        // setters may have changed the parameters after the session was loaded
+        applyPoolKey(mSession, mLoadedKey);
+        mSessionPool.put(mLoadedKey, mSession);
+    }
+    else
+        xccdf_session_free(mSession);
+
+    mSession = 0;
+    mTailoring = 0;
+    mLoadedKey = SessionPoolKey();
+}
+
+/// Validation errors are reported by oscapErrGetFullError
+static int ignoreValidationMessage(const char* /*file*/, int /*line*/, const char* /*msg*/, void* /*arg*/)
+{
+    return 0;
+}
+
+/**
+ * The policy model caches a policy for every profile it has been asked for,
+ * xccdf_policy_model_set_tailoring doesn't drop them. Returns false if some
+ * of them would stay in use with given tailoring in the model although they
+ * were made for another profile.
+ */
+static bool policiesSurviveTailoring(struct xccdf_policy_model* policyModel, struct xccdf_tailoring* tailoring)
+{
+    bool ret = true;
+
+    struct xccdf_policy_iterator* policies = xccdf_policy_model_get_policies(policyModel);
+    while (ret && xccdf_policy_iterator_has_more(policies))
+    {
+        struct xccdf_policy* policy = xccdf_policy_iterator_next(policies);
+        struct xccdf_profile* profile = xccdf_policy_get_profile(policy);
+
+        // the default profile isn't affected by tailoring
+        if (!profile)
+            continue;
+
+        // made for a profile of the tailoring that gets replaced
+        if (xccdf_profile_get_tailoring(profile))
+            ret = false;
+        // made for a benchmark profile that the new tailoring shadows
+        else if (tailoring && xccdf_profile_get_id(profile) &&
+            xccdf_tailoring_get_profile_by_id(tailoring, xccdf_profile_get_id(profile)))
+            ret = false;
+    }
+    xccdf_policy_iterator_free(policies);
+
+    return ret;
+}
+
+bool ScanningSession::reloadTailoring() const
+{
+    struct xccdf_policy_model* policyModel = xccdf_session_get_policy_model(mSession);
+    struct xccdf_tailoring* tailoring = 0;
+
+    if (!mUserTailoringFile.isEmpty())
+    {
+        struct oscap_source* source = oscap_source_new_from_file(mUserTailoringFile.toUtf8().constData());
+
+        if (!mSkipValid && oscap_source_validate(source, ignoreValidationMessage, 0) != 0)
+        {
+            oscap_source_free(source);
+            throw ScanningSessionException(
+                QString("Tailoring file '%1' is not valid. OpenSCAP error message:\n%2").arg(mUserTailoringFile).arg(oscapErrGetFullError()));
+        }
+
+        tailoring = xccdf_tailoring_import_source(source, xccdf_policy_model_get_benchmark(policyModel));
+        oscap_source_free(source);
+
+        if (!tailoring)
+            throw ScanningSessionException(
+                QString("Failed to load tailoring file '%1'. OpenSCAP error message:\n%2").arg(mUserTailoringFile).arg(oscapErrGetFullError()));
+    }
+
+    // policies selecting rules of the previous tailoring would be used for the new one,
+    // the whole content has to be loaded then
+    if (!policiesSurviveTailoring(policyModel, tailoring))
+    {
+        if (tailoring)
+            xccdf_tailoring_free(tailoring);
+
+        return false;
+    }
+
+    // xccdf_session_load puts the tailoring into the policy model the same way,
+    // the benchmark stays as it is
+    xccdf_policy_model_set_tailoring(policyModel, tailoring);
+    mTailoring = tailoring;
+
+    return true;
+}
+
 struct xccdf_profile* ScanningSession::tailorCurrentProfile(bool shadowed, const QString& newIdBase)
 {
     reloadSession();
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ScratchSpace.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QAtomicInt>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/statvfs.h>
+#endif
+
+/// tmpfs with less free space is skipped, large ARFs wouldn't fit
+static const quint64 MIN_TMPFS_FREE_SPACE = 512 * 1024 * 1024;
+
+/// Every temporary file asks for the directory, an unusable one is reported just once
+static QAtomicInt sUnusableDirectoryReported(0);
+
+static bool isUsableDirectory(const QString& path, quint64 minFreeSpace)
+{
+    if (path.isEmpty())
+        return false;
+
+    const QFileInfo info(path);
+    if (!info.isDir() || !info.isWritable())
+        return false;
+
+#ifndef _WIN32
+    if (minFreeSpace > 0)
+    {
+        struct statvfs stats;
+        if (statvfs(QFile::encodeName(path).constData(), &stats) != 0)
+            return false;
+
+        if (static_cast<quint64>(stats.f_bavail) * stats.f_frsize < minFreeSpace)
+            return false;
+    }
+#else
+    Q_UNUSED(minFreeSpace);
+#endif
+
+    return true;
+}
+
+QString ScratchSpace::getDirectory()
+{
+    QString configured = QString::fromLocal8Bit(qgetenv("SCAP_WORKBENCH_SCRATCH_DIR"));
+    if (configured.isEmpty())
+    {
+        QSettings settings;
+        configured = settings.value("scratch-directory").toString();
+    }
+
+    if (!configured.isEmpty())
+    {
+        if (isUsableDirectory(configured, 0))
+            return QDir(configured).absolutePath();
+
+        if (sUnusableDirectoryReported.testAndSetOrdered(0, 1))
+            std::cerr << "Scratch directory '" << configured.toUtf8().constData()
+                << "' is not a writable directory, using the default one." << std::endl;
+    }
+
+#ifndef _WIN32
+    const QString runtimeDir = QString::fromLocal8Bit(qgetenv("XDG_RUNTIME_DIR"));
+    if (isUsableDirectory(runtimeDir, MIN_TMPFS_FREE_SPACE))
+        return runtimeDir;
+
+    if (isUsableDirectory("/dev/shm", MIN_TMPFS_FREE_SPACE))
+        return "/dev/shm";
+#endif
+
+    return QDir::tempPath();
+}
+
+QString ScratchSpace::getFileTemplate()
+{
+    return QDir(getDirectory()).absoluteFilePath("scap-workbench-XXXXXX");
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "SessionLoader.h"
+#include "ScanningSession.h"
+#include "APIHelpers.h"
+#include "SessionMetadataCache.h"
+
+#include <QFileInfo>
+#include <QThread>
+
+#include <map>
+#include <vector>
+
+extern "C" {
+#include <xccdf_policy.h>
+#include <xccdf_session.h>
+#include <scap_ds.h>
+}
+
+SessionLoader::SessionLoader(ScanningSession* session):
+    mSession(session),
+    mMainThread(QThread::currentThread()),
+
+    mCancelRequested(0),
+    mCanceled(false),
+
+    mMetadataCached(false)
+{}
+
+SessionLoader::~SessionLoader()
+{}
+
+void SessionLoader::setFileToOpen(const QString& path, const QString& tailoringPath)
+{
+    mPath = path;
+    mTailoringPath = tailoringPath;
+}
+
+const QString& SessionLoader::getTailoringPath() const
+{
+    return mTailoringPath;
+}
+
+void SessionLoader::cancel()
+{
+    mCancelRequested.fetchAndStoreOrdered(1);
+}
+
+bool SessionLoader::wasCanceled() const
+{
+    return mCanceled;
+}
+
+bool SessionLoader::hasFailed() const
+{
+    return !mErrorMessage.isEmpty();
+}
+
+const QString& SessionLoader::getErrorMessage() const
+{
+    return mErrorMessage;
+}
+
+const SessionMetadata& SessionLoader::getMetadata() const
+{
+    return mMetadata;
+}
+
+bool SessionLoader::isMetadataCached() const
+{
+    return mMetadataCached;
+}
+
+QList<SessionProfileItem> SessionLoader::buildProfileList(ScanningSession* session)
+{
+    QList<SessionProfileItem> ret;
+
+    const std::map<QString, struct xccdf_profile*> profiles = session->getAvailableProfiles();
+    struct xccdf_policy_model* policyModel = xccdf_session_get_policy_model(session->getXCCDFSession());
+
+    // A nice side effect here is that profiles will be sorted by their IDs
+    // because of the RB-tree implementation of std::map.
+    for (std::map<QString, struct xccdf_profile*>::const_iterator it = profiles.begin();
+         it != profiles.end(); ++it)
+    {
+        SessionProfileItem item;
+        item.id = it->first;
+
+        struct xccdf_policy* policy = xccdf_policy_new(policyModel, it->second);
+        const int selectedRulesCount = xccdf_policy_get_selected_rules_count(policy);
+        xccdf_policy_free(policy);
+
+        item.title = oscapTextIteratorGetPreferred(xccdf_profile_get_title(it->second)) +
+            " (" + QString::number(selectedRulesCount) + ")";
+        ret.append(item);
+    }
+
+    // default profile
+    {
+        SessionProfileItem item;
+        item.title = QObject::tr("(default)");
+
+        // We use QT_VERSION_CHECK to transform major, minor, patch numbers into
+        // one easy comparable number.
+        // We can only count selected rules for default profile if we are compiling against
+        // OpenSCAP versions newer than 1.2.12.
+        // See https://github.com/OpenSCAP/openscap/pull/607
+#if (QT_VERSION_CHECK(OPENSCAP_VERSION_MAJOR, OPENSCAP_VERSION_MINOR, OPENSCAP_VERSION_PATCH) > QT_VERSION_CHECK(1, 2, 12))
+        struct xccdf_policy* policy = xccdf_policy_new(policyModel, NULL);
+        const int selectedRulesCount = xccdf_policy_get_selected_rules_count(policy);
+        xccdf_policy_free(policy);
+
+        item.title = item.title + " (" + QString::number(selectedRulesCount) + ")";
+#endif
+
+        // Intentionally comes last. Users are more likely to use profiles other than (default)
+        ret.append(item);
+    }
+
+    return ret;
+}
+
+QList<QStringList> SessionLoader::buildChecklistList(ScanningSession* session)
+{
+    QList<QStringList> ret;
+
+    if (!session->isSDS())
+        return ret;
+
+    struct ds_sds_index* sds_idx = xccdf_session_get_sds_idx(session->getXCCDFSession());
+
+    struct ds_stream_index_iterator* streams_it = ds_sds_index_get_streams(sds_idx);
+    while (ds_stream_index_iterator_has_more(streams_it))
+    {
+        struct ds_stream_index* stream_idx = ds_stream_index_iterator_next(streams_it);
+        const QString stream_id = QString::fromUtf8(ds_stream_index_get_id(stream_idx));
+
+        struct oscap_string_iterator* checklists_it = ds_stream_index_get_checklists(stream_idx);
+        while (oscap_string_iterator_has_more(checklists_it))
+        {
+            const QString checklist_id = QString::fromUtf8(oscap_string_iterator_next(checklists_it));
+
+            QStringList data;
+            data.append(stream_id);
+            data.append(checklist_id);
+            ret.append(data);
+        }
+        oscap_string_iterator_free(checklists_it);
+    }
+    ds_stream_index_iterator_free(streams_it);
+
+    return ret;
+}
+
+QList<SessionRuleItem> SessionLoader::buildRuleList(ScanningSession* session)
+{
+    QList<SessionRuleItem> ret;
+
+    struct xccdf_session* xccdfSession = session->getXCCDFSession();
+    struct xccdf_policy* policy = xccdf_session_get_xccdf_policy(xccdfSession);
+    struct xccdf_benchmark* benchmark = xccdf_policy_model_get_benchmark(xccdf_session_get_policy_model(xccdfSession));
+
+    std::vector<struct xccdf_rule*> selectedRules;
+    gatherAllSelectedRules(policy, xccdf_benchmark_to_item(benchmark), selectedRules);
+
+    for (std::vector<struct xccdf_rule*>::const_iterator it = selectedRules.begin();
+         it != selectedRules.end(); ++it)
+    {
+        struct xccdf_item* item = xccdf_rule_to_item(*it);
+
+        SessionRuleItem rule;
+        rule.id = QString::fromUtf8(xccdf_rule_get_id(*it));
+        rule.title = oscapItemGetReadableTitle(item, policy);
+        rule.descriptionHTML = oscapItemGetReadableDescription(item, policy);
+        ret.append(rule);
+    }
+
+    return ret;
+}
+
+void SessionLoader::run()
+{
+    try
+    {
+        if (!mPath.isEmpty() &&
+            startStage(STAGE_OPEN, QObject::tr("Reading '%1'...").arg(QFileInfo(mPath).fileName())))
+        {
+            // content with a tailoring file is never cached, profiles depend on the tailoring
+            if (mTailoringPath.isEmpty() && SessionMetadataCache::isEnabled())
+            {
+                mCacheKey = SessionMetadataCache::getKey(mPath, QString(), QString());
+                mMetadataCached = SessionMetadataCache::load(mCacheKey, mMetadata);
+
+                if (mMetadataCached)
+                    emit metadataLoaded();
+            }
+
+            // the content is loaded by the next stage, together with the tailoring
+            mSession->openFile(mPath, false);
+
+            if (!mTailoringPath.isEmpty())
+                mSession->setTailoringFile(mTailoringPath);
+        }
+
+        if (startStage(STAGE_LOAD, mSession->getSkipValid() ?
+            QObject::tr("Parsing the content and building the policy model...") :
+            QObject::tr("Parsing and validating the content, building the policy model...")))
+        {
+            mSession->reloadSession();
+
+            if (!mPath.isEmpty())
+            {
+                // In case openscap autonegotiated opening a tailoring file directly
+                if (mTailoringPath.isEmpty() && mSession->hasTailoring())
+                {
+                    mTailoringPath = mPath;
+                    mSession->setTailoringFile(mTailoringPath);
+                    mSession->reloadSession();
+                }
+
+                // set default profile after opening, this ensures that xccdf_policy can be returned
+                mSession->setProfile(QString());
+            }
+        }
+
+        if (!mMetadataCached &&
+            startStage(STAGE_METADATA, QObject::tr("Counting rules selected by each profile...")))
+        {
+            buildMetadata();
+
+            // the file may have turned out to be a tailoring file
+            if (!mCacheKey.isEmpty() && !mSession->hasTailoring())
+                SessionMetadataCache::store(mCacheKey, mMetadata);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        mErrorMessage = QString::fromUtf8(e.what());
+    }
+
+    // a canceled open doesn't leave a half loaded file behind
+    if (mCanceled && !mPath.isEmpty())
+        mSession->closeFile();
+
+    // results are read right after finished, the thread may be gone by then
+    moveToThread(mMainThread);
+    emit finished();
+}
+
+void SessionLoader::buildMetadata()
+{
+    mMetadata = SessionMetadata();
+
+    mMetadata.benchmarkTitle = mSession->getBenchmarkTitle();
+    mMetadata.checklists = buildChecklistList(mSession);
+    mMetadata.datastreamID = mSession->getDatastreamID();
+    mMetadata.componentID = mSession->getComponentID();
+    mMetadata.profiles = buildProfileList(mSession);
+
+    if (!mPath.isEmpty() && !mMetadata.profiles.isEmpty())
+    {
+        // the main window selects the first profile once the file is opened
+        mMetadata.rulesProfileID = mMetadata.profiles.first().id;
+        mSession->setProfile(mMetadata.rulesProfileID);
+        mMetadata.rules = buildRuleList(mSession);
+    }
+}
+
+bool SessionLoader::startStage(Stage stage, const QString& description)
+{
+    if (mCancelRequested.fetchAndAddOrdered(0) != 0)
+    {
+        mCanceled = true;
+        return false;
+    }
+
+    emit stageStarted(stage, description);
+    return true;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "SessionMetadataCache.h"
+#include "Utils.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+
+extern "C" {
+#include <oscap.h>
+}
+
+/// "SWMC", identifies the cache files
+static const quint32 CACHE_FILE_MAGIC = 0x53574d43;
+/// Increment whenever the layout of the cache files changes
+static const quint32 CACHE_FILE_FORMAT = 1;
+/// Least recently stored entries are removed when there are more
+static const int MAX_CACHE_ENTRIES = 32;
+
+static QDataStream& operator<<(QDataStream& stream, const SessionProfileItem& item)
+{
+    return stream << item.id << item.title;
+}
+
+static QDataStream& operator>>(QDataStream& stream, SessionProfileItem& item)
+{
+    return stream >> item.id >> item.title;
+}
+
+static QDataStream& operator<<(QDataStream& stream, const SessionRuleItem& item)
+{
+    return stream << item.id << item.title << item.descriptionHTML;
+}
+
+static QDataStream& operator>>(QDataStream& stream, SessionRuleItem& item)
+{
+    return stream >> item.id >> item.title >> item.descriptionHTML;
+}
+
+/// Versions of the code that derived the metadata, entries of other versions are stale
+static QString getProducerVersion()
+{
+    return QString("%1 %2").arg(SCAP_WORKBENCH_VERSION, QString::fromUtf8(oscap_get_version()));
+}
+
+bool SessionMetadataCache::isEnabled()
+{
+    QSettings settings;
+    return settings.value("metadata-cache", true).toBool();
+}
+
+QString SessionMetadataCache::getKey(const QString& contentPath, const QString& datastreamID, const QString& componentID)
+{
+    const QString contentHash = computeFileHash(contentPath);
+    if (contentHash.isEmpty())
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(contentHash.toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(datastreamID.toUtf8());
+    hash.addData("\n", 1);
+    hash.addData(componentID.toUtf8());
+
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool SessionMetadataCache::load(const QString& key, SessionMetadata& metadata)
+{
+    if (key.isEmpty())
+        return false;
+
+    QFile file(QDir(getDirectory()).absoluteFilePath(key + ".bin"));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0;
+    quint32 format = 0;
+    QString producerVersion;
+    stream >> magic >> format >> producerVersion;
+
+    if (magic != CACHE_FILE_MAGIC || format != CACHE_FILE_FORMAT || producerVersion != getProducerVersion())
+        return false;
+
+    SessionMetadata ret;
+    stream >> ret.benchmarkTitle
+        >> ret.checklists >> ret.datastreamID >> ret.componentID
+        >> ret.profiles
+        >> ret.rulesProfileID >> ret.rules;
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    metadata = ret;
+    return true;
+}
+
+void SessionMetadataCache::store(const QString& key, const SessionMetadata& metadata)
+{
+    if (key.isEmpty())
+        return;
+
+    const QDir dir(getDirectory());
+    if (!dir.exists() && !QDir().mkpath(dir.absolutePath()))
+        return;
+
+    const QString path = dir.absoluteFilePath(key + ".bin");
+    // written next to the entry and renamed, readers never see a partial entry
+    const QString partialPath = path + ".partial";
+
+    {
+        QFile file(partialPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return;
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_6);
+
+        stream << CACHE_FILE_MAGIC << CACHE_FILE_FORMAT << getProducerVersion();
+        stream << metadata.benchmarkTitle
+            << metadata.checklists << metadata.datastreamID << metadata.componentID
+            << metadata.profiles
+            << metadata.rulesProfileID << metadata.rules;
+
+        if (stream.status() != QDataStream::Ok || !file.flush())
+        {
+            file.close();
+            QFile::remove(partialPath);
+            return;
+        }
+    }
+
+    QFile::remove(path);
+    if (!QFile::rename(partialPath, path))
+    {
+        QFile::remove(partialPath);
+        return;
+    }
+
+    const QFileInfoList entries = dir.entryInfoList(QStringList("*.bin"), QDir::Files, QDir::Time);
+    for (int i = MAX_CACHE_ENTRIES; i < entries.size(); ++i)
+        QFile::remove(entries[i].absoluteFilePath());
+}
+
+QString SessionMetadataCache::getDirectory()
+{
+    return QDir(QDesktopServices::storageLocation(QDesktopServices::CacheLocation)).absoluteFilePath("metadata");
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "SessionPool.h"
+
+#include <QFileInfo>
+#include <QSettings>
+
+/// Parsed content and the policy model take roughly this many times the size of the input file
+static const qint64 MEMORY_PER_CONTENT_BYTE = 10;
+
+SessionPoolKey::SessionPoolKey():
+    skipValid(false)
+{}
+
+bool SessionPoolKey::isValid() const
+{
+    return !contentHash.isEmpty();
+}
+
+bool SessionPoolKey::operator==(const SessionPoolKey& other) const
+{
+    return contentPath == other.contentPath &&
+        contentHash == other.contentHash &&
+        datastreamID == other.datastreamID &&
+        componentID == other.componentID &&
+        tailoringFile == other.tailoringFile &&
+        tailoringFileHash == other.tailoringFileHash &&
+        tailoringComponentID == other.tailoringComponentID &&
+        skipValid == other.skipValid;
+}
+
+SessionPool::SessionPool():
+    mEstimatedMemory(0)
+{
+    QSettings settings;
+    mMaxSessions = settings.value("session-pool-size", 3).toInt();
+    mMaxMemory = settings.value("session-pool-memory", 1024).toLongLong() * 1024 * 1024;
+}
+
+SessionPool::~SessionPool()
+{
+    clear();
+}
+
+struct xccdf_session* SessionPool::take(const SessionPoolKey& key)
+{
+    for (QList<Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+    {
+        if (it->key == key)
+        {
+            struct xccdf_session* ret = it->session;
+            mEstimatedMemory -= it->estimatedMemory;
+            mEntries.erase(it);
+
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+void SessionPool::put(const SessionPoolKey& key, struct xccdf_session* session)
+{
+    Entry entry;
+    entry.key = key;
+    entry.session = session;
+    entry.estimatedMemory = QFileInfo(key.contentPath).size() * MEMORY_PER_CONTENT_BYTE;
+
+    mEntries.prepend(entry);
+    mEstimatedMemory += entry.estimatedMemory;
+
+    while (!mEntries.isEmpty() &&
+        (mEntries.size() > mMaxSessions || mEstimatedMemory > mMaxMemory))
+    {
+        const Entry evicted = mEntries.takeLast();
+        mEstimatedMemory -= evicted.estimatedMemory;
+        xccdf_session_free(evicted.session);
+    }
+}
+
+void SessionPool::clear()
+{
+    for (QList<Entry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+        xccdf_session_free(it->session);
+
+    mEntries.clear();
+    mEstimatedMemory = 0;
+}
@@ -52,7 +52,8 @@ static bool recursiveRemoveDir(const QString& dirName)
     return result;
 }
 
-TemporaryDir::TemporaryDir():
+TemporaryDir::TemporaryDir(const QString& parentDirectory):
+    mParentDirectory(parentDirectory),
     mAutoRemove(true)
 {}
 
@@ -119,6 +120,8 @@ void TemporaryDir::ensurePath() const
 
     if (mPath.isEmpty())
     {
+        const QDir parent(mParentDirectory.isEmpty() ? QDir::tempPath() : mParentDirectory);
+
         QString dirName;
         while (true)
         {
@@ -132,11 +135,11 @@ void TemporaryDir::ensurePath() const
             dirName += letters[nextRand(v)];
             dirName += letters[nextRand(v)];
 
-            if (QDir::temp().mkdir(dirName))
+            if (parent.mkdir(dirName))
                 break;
         }
 
-        const QDir dir(QDir::temp().absoluteFilePath(dirName));
+        const QDir dir(parent.absoluteFilePath(dirName));
 
         if (!dir.exists())
             throw TemporaryDirException(
@@ -144,6 +147,10 @@ void TemporaryDir::ensurePath() const
                     "but the directory does not exist!")
             );
 
+        // the parent may be shared by all users, /dev/shm for example
+        QFile::setPermissions(dir.absolutePath(),
+            QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
         mPath = dir.absolutePath();
     }
 }
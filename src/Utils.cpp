@@ -24,6 +24,17 @@
 #include <QDesktopServices>
 #include <QMessageBox>
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
 
 #if defined(__APPLE__)
 inline QDir _generateShareDir()
@@ -217,3 +228,152 @@ const QString& getSetSidPath()
     return ret;
 #endif
 }
+
+QString jsonQuote(const QString& value)
+{
+    QString ret = "\"";
+    for (QString::const_iterator it = value.constBegin(); it != value.constEnd(); ++it)
+    {
+        const ushort c = it->unicode();
+
+        if (c == '"')
+            ret += "\\\"";
+        else if (c == '\\')
+            ret += "\\\\";
+        else if (c == '\n')
+            ret += "\\n";
+        else if (c == '\t')
+            ret += "\\t";
+        else if (c < 0x20)
+            ret += QString("\\u%1").arg(c, 4, 16, QChar('0'));
+        else
+            ret += *it;
+    }
+    ret += "\"";
+
+    return ret;
+}
+
+namespace
+{
+    /**
+     * What tells whether a file could have changed since it was hashed.
+     *
+     * QFileInfo only has modification times with second resolution, a file
+     * rewritten within the same second keeping its size would look unchanged.
+     * Where we can, the inode and the change time are compared as well, with
+     * whatever resolution the filesystem has.
+     */
+    struct FileIdentity
+    {
+        qint64 size;
+        QDateTime lastModified;
+#ifndef _WIN32
+        quint64 device;
+        quint64 inode;
+        qint64 modificationTime;
+        qint64 modificationTimeNsec;
+        qint64 changeTime;
+        qint64 changeTimeNsec;
+#endif
+
+        explicit FileIdentity(const QFileInfo& info):
+            size(info.size()),
+            lastModified(info.lastModified())
+#ifndef _WIN32
+            , device(0),
+            inode(0),
+            modificationTime(0),
+            modificationTimeNsec(0),
+            changeTime(0),
+            changeTimeNsec(0)
+#endif
+        {
+#ifndef _WIN32
+            struct stat st;
+            if (::stat(QFile::encodeName(info.filePath()).constData(), &st) == 0)
+            {
+                size = st.st_size;
+                device = st.st_dev;
+                inode = st.st_ino;
+                modificationTime = st.st_mtime;
+                changeTime = st.st_ctime;
+#if defined(__APPLE__)
+                modificationTimeNsec = st.st_mtimespec.tv_nsec;
+                changeTimeNsec = st.st_ctimespec.tv_nsec;
+#else
+                modificationTimeNsec = st.st_mtim.tv_nsec;
+                changeTimeNsec = st.st_ctim.tv_nsec;
+#endif
+            }
+#endif
+        }
+
+        bool operator==(const FileIdentity& other) const
+        {
+            return size == other.size && lastModified == other.lastModified
+#ifndef _WIN32
+                && device == other.device && inode == other.inode
+                && modificationTime == other.modificationTime
+                && modificationTimeNsec == other.modificationTimeNsec
+                && changeTime == other.changeTime
+                && changeTimeNsec == other.changeTimeNsec
+#endif
+                ;
+        }
+    };
+
+    struct FileHashCacheEntry
+    {
+        FileHashCacheEntry(const FileIdentity& identity, const QString& hash):
+            identity(identity),
+            hash(hash)
+        {}
+
+        FileIdentity identity;
+        QString hash;
+    };
+}
+
+// Fleet scans run many scanners with the same content concurrently, hashes are remembered for all of them
+static QMutex sFileHashCacheMutex;
+static QMap<QString, FileHashCacheEntry> sFileHashCache;
+
+QString computeFileHash(const QString& path, bool remembered)
+{
+    const QFileInfo info(path);
+    const QString canonicalPath = info.canonicalFilePath();
+    // taken before reading, a change while we read makes the entry stale rather than wrong
+    const FileIdentity identity(info);
+
+    if (remembered)
+    {
+        QMutexLocker locker(&sFileHashCacheMutex);
+
+        QMap<QString, FileHashCacheEntry>::const_iterator it = sFileHashCache.constFind(canonicalPath);
+        if (it != sFileHashCache.constEnd() && it->identity == identity)
+            return it->hash;
+    }
+
+    // The lock is not held while reading, scanners hashing other files must
+    // not wait for a big one. Two scanners may hash the same file at once,
+    // both get the same hash, the latter entry wins.
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QByteArray buffer;
+    while (!(buffer = file.read(1024 * 1024)).isEmpty())
+        hash.addData(buffer);
+
+    if (file.error() != QFile::NoError)
+        return QString();
+
+    const QString ret = QString::fromLatin1(hash.result().toHex());
+
+    QMutexLocker locker(&sFileHashCacheMutex);
+    sFileHashCache.insert(canonicalPath, FileHashCacheEntry(identity, ret));
+
+    return ret;
+}
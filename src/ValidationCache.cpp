@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ValidationCache.h"
+#include "Utils.h"
+
+#include <QCryptographicHash>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include <QStringList>
+
+extern "C" {
+#include <oscap.h>
+}
+
+/// Least recently validated entries are removed when there are more
+static const int MAX_CACHE_ENTRIES = 256;
+
+bool ValidationCache::isEnabled()
+{
+    QSettings settings;
+    return settings.value("validation-cache", true).toBool();
+}
+
+QString ValidationCache::getKey(const QString& contentPath, const QString& tailoringPath,
+    const QString& datastreamID, const QString& componentID, const QString& tailoringComponentID)
+{
+    // a stale hash would skip validation of changed content, don't trust the memo
+    const QString contentHash = computeFileHash(contentPath, false);
+    if (contentHash.isEmpty())
+        return QString();
+
+    QString tailoringHash;
+    if (!tailoringPath.isEmpty())
+    {
+        tailoringHash = computeFileHash(tailoringPath, false);
+        if (tailoringHash.isEmpty())
+            return QString();
+    }
+
+    QStringList parts;
+    parts.append(QString::fromUtf8(oscap_get_version()));
+    parts.append(contentHash);
+    parts.append(tailoringHash);
+    parts.append(datastreamID);
+    parts.append(componentID);
+    parts.append(tailoringComponentID);
+
+    return QString::fromLatin1(
+        QCryptographicHash::hash(parts.join("\n").toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+bool ValidationCache::isKnownValid(const QString& key)
+{
+    if (key.isEmpty())
+        return false;
+
+    return QFile::exists(QDir(getDirectory()).absoluteFilePath(key));
+}
+
+void ValidationCache::markValid(const QString& key)
+{
+    if (key.isEmpty())
+        return;
+
+    const QDir dir(getDirectory());
+    if (!dir.exists() && !QDir().mkpath(dir.absolutePath()))
+        return;
+
+    QFile file(dir.absoluteFilePath(key));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    file.close();
+
+    const QFileInfoList entries = dir.entryInfoList(QDir::Files, QDir::Time);
+    for (int i = MAX_CACHE_ENTRIES; i < entries.size(); ++i)
+        QFile::remove(entries[i].absoluteFilePath());
+}
+
+QString ValidationCache::getDirectory()
+{
+    return QDir(QDesktopServices::storageLocation(QDesktopServices::CacheLocation)).absoluteFilePath("validation");
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ArchiveHelpers.h"
+#include "Exceptions.h"
+
+#include <QtTest>
+#include <QBuffer>
+#include <QTemporaryFile>
+
+class ArchiveHelpersTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void tarRoundTrip();
+        void tarNameTooLong();
+        void gzipRoundTrip();
+
+    private:
+        static QByteArray readFile(const QString& path);
+};
+
+QByteArray ArchiveHelpersTest::readFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    return file.readAll();
+}
+
+void ArchiveHelpersTest::tarRoundTrip()
+{
+    QTemporaryFile input;
+    QVERIFY(input.open());
+    // not a multiple of the block size so that padding is exercised
+    const QByteArray inputData = QByteArray("<Benchmark/>\n").repeated(1000);
+    input.write(inputData);
+    input.close();
+
+    QTemporaryFile empty;
+    QVERIFY(empty.open());
+    empty.close();
+
+    QMap<QString, QString> files;
+    files.insert("input.xml", input.fileName());
+    files.insert("tailoring.xml", empty.fileName());
+
+    QByteArray archive;
+    QBuffer buffer(&archive);
+    buffer.open(QIODevice::WriteOnly);
+    writeTarArchive(files, buffer);
+
+    QCOMPARE(archive.size() % 512, 0);
+
+    QTemporaryFile inputCopy;
+    QVERIFY(inputCopy.open());
+    QTemporaryFile emptyCopy;
+    QVERIFY(emptyCopy.open());
+    emptyCopy.write("not empty");
+    emptyCopy.close();
+
+    // entries without a destination are skipped
+    QMap<QString, QString> destinations;
+    destinations.insert("input.xml", inputCopy.fileName());
+    destinations.insert("tailoring.xml", emptyCopy.fileName());
+    destinations.insert("missing.xml", emptyCopy.fileName() + ".missing");
+
+    buffer.close();
+    buffer.open(QIODevice::ReadOnly);
+    QStringList extracted;
+    extractTarArchive(buffer, destinations, extracted);
+
+    QCOMPARE(extracted, QStringList() << "input.xml" << "tailoring.xml");
+    QCOMPARE(readFile(inputCopy.fileName()), inputData);
+    QVERIFY(readFile(emptyCopy.fileName()).isEmpty());
+    QVERIFY(!QFile::exists(emptyCopy.fileName() + ".missing"));
+}
+
+void ArchiveHelpersTest::tarNameTooLong()
+{
+    QTemporaryFile input;
+    QVERIFY(input.open());
+    input.close();
+
+    QMap<QString, QString> files;
+    files.insert(QString(100, 'a'), input.fileName());
+
+    QByteArray archive;
+    QBuffer buffer(&archive);
+    buffer.open(QIODevice::WriteOnly);
+
+    bool thrown = false;
+    try
+    {
+        writeTarArchive(files, buffer);
+    }
+    catch (const ArchiveHelpersException&)
+    {
+        thrown = true;
+    }
+
+    QVERIFY(thrown);
+}
+
+void ArchiveHelpersTest::gzipRoundTrip()
+{
+    if (!isGzipSupported())
+        QSKIP("scap-workbench was built without zlib", SkipSingle);
+
+    // larger than the chunks used by both directions
+    QByteArray data;
+    for (int i = 0; i < 100000; ++i)
+        data += QString("<rule-result idref=\"rule_%1\"><result>pass</result></rule-result>\n").arg(i).toUtf8();
+
+    QBuffer input(&data);
+    input.open(QIODevice::ReadOnly);
+    QByteArray compressed;
+    QBuffer compressedOutput(&compressed);
+    compressedOutput.open(QIODevice::WriteOnly);
+    gzipCompress(input, compressedOutput);
+
+    QVERIFY(isGzipCompressed(compressed));
+    QVERIFY(compressed.size() < data.size());
+
+    QBuffer compressedInput(&compressed);
+    compressedInput.open(QIODevice::ReadOnly);
+    QByteArray decompressed;
+    QBuffer output(&decompressed);
+    output.open(QIODevice::WriteOnly);
+    gzipDecompress(compressedInput, output);
+
+    QCOMPARE(decompressed, data);
+
+    // truncated data must not pass silently
+    compressed.chop(16);
+    QBuffer truncatedInput(&compressed);
+    truncatedInput.open(QIODevice::ReadOnly);
+    QByteArray ignored;
+    QBuffer ignoredOutput(&ignored);
+    ignoredOutput.open(QIODevice::WriteOnly);
+
+    bool thrown = false;
+    try
+    {
+        gzipDecompress(truncatedInput, ignoredOutput);
+    }
+    catch (const ArchiveHelpersException&)
+    {
+        thrown = true;
+    }
+
+    QVERIFY(thrown);
+}
+
+QTEST_MAIN(ArchiveHelpersTest)
+#include "ArchiveHelpersTest.moc"
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "OscapScannerBase.h"
+
+#include <QtTest>
+
+/// Exposes parsing of oscap --progress output, nothing gets evaluated
+class ProgressParsingScanner : public OscapScannerBase
+{
+    public:
+        virtual QStringList getCommandLineArgs() const
+        {
+            return QStringList();
+        }
+
+        virtual void evaluate()
+        {}
+
+        void feed(const QByteArray& chunk)
+        {
+            parseStdOutChunk(chunk, mReadBuffer, mLastRuleID);
+        }
+};
+
+class OscapScannerBaseTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void wholeLines();
+        void ruleIDSplitFromResult();
+        void splitInsideRuleID();
+        void splitInsideResult();
+        void byteByByte();
+        void benchmarkParsing_data();
+        void benchmarkParsing();
+
+    private:
+        /// Returns ruleIDs and results of all batches joined as "ruleID:result"
+        static QStringList batchResults(const QSignalSpy& spy);
+};
+
+QStringList OscapScannerBaseTest::batchResults(const QSignalSpy& spy)
+{
+    QStringList ret;
+    for (int i = 0; i < spy.count(); ++i)
+    {
+        const QStringList ruleIDs = spy.at(i).at(0).toStringList();
+        const QStringList results = spy.at(i).at(1).toStringList();
+        Q_ASSERT(ruleIDs.size() == results.size());
+
+        for (int j = 0; j < ruleIDs.size(); ++j)
+            ret.append(ruleIDs[j] + ":" + results[j]);
+    }
+
+    return ret;
+}
+
+void OscapScannerBaseTest::wholeLines()
+{
+    ProgressParsingScanner scanner;
+    QSignalSpy spy(&scanner, SIGNAL(progressReportBatch(QStringList,QStringList)));
+
+    scanner.feed("rule_a:pass\nrule_b:fail\n");
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(batchResults(spy), QStringList() << "rule_a:pass" << "rule_b:fail");
+}
+
+void OscapScannerBaseTest::ruleIDSplitFromResult()
+{
+    ProgressParsingScanner scanner;
+    QSignalSpy spy(&scanner, SIGNAL(progressReportBatch(QStringList,QStringList)));
+
+    // oscap prints "ruleID:" when it starts evaluating the rule and the
+    // result when it is done, the chunks get split right in between
+    scanner.feed("rule_a:");
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(batchResults(spy), QStringList() << "rule_a:processing");
+
+    scanner.feed("pass\nrule_b:");
+    QCOMPARE(spy.count(), 2);
+
+    scanner.feed("fail\n");
+    QCOMPARE(spy.count(), 3);
+
+    QCOMPARE(batchResults(spy), QStringList()
+        << "rule_a:processing"
+        << "rule_a:pass" << "rule_b:processing"
+        << "rule_b:fail");
+}
+
+void OscapScannerBaseTest::splitInsideRuleID()
+{
+    ProgressParsingScanner scanner;
+    QSignalSpy spy(&scanner, SIGNAL(progressReportBatch(QStringList,QStringList)));
+
+    scanner.feed("rul");
+    QCOMPARE(spy.count(), 0);
+
+    scanner.feed("e_a:pass\n");
+    QCOMPARE(batchResults(spy), QStringList() << "rule_a:pass");
+}
+
+void OscapScannerBaseTest::splitInsideResult()
+{
+    ProgressParsingScanner scanner;
+    QSignalSpy spy(&scanner, SIGNAL(progressReportBatch(QStringList,QStringList)));
+
+    scanner.feed("rule_a:notch");
+    scanner.feed("ecked\n");
+
+    QCOMPARE(batchResults(spy), QStringList() << "rule_a:processing" << "rule_a:notchecked");
+}
+
+void OscapScannerBaseTest::byteByByte()
+{
+    const QByteArray output = "rule_a:pass\nrule_b:fail\nrule_c:notapplicable\n";
+
+    ProgressParsingScanner scanner;
+    QSignalSpy spy(&scanner, SIGNAL(progressReportBatch(QStringList,QStringList)));
+
+    for (int i = 0; i < output.size(); ++i)
+        scanner.feed(output.mid(i, 1));
+
+    // "processing" is reported just once per rule, no matter how many chunks it takes
+    QCOMPARE(batchResults(spy), QStringList()
+        << "rule_a:processing" << "rule_a:pass"
+        << "rule_b:processing" << "rule_b:fail"
+        << "rule_c:processing" << "rule_c:notapplicable");
+}
+
+void OscapScannerBaseTest::benchmarkParsing_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    // a pipe buffer page, the default QProcess read size and a large read
+    QTest::newRow("512 B chunks") << 512;
+    QTest::newRow("4 KiB chunks") << 4096;
+    QTest::newRow("64 KiB chunks") << 65536;
+}
+
+void OscapScannerBaseTest::benchmarkParsing()
+{
+    QFETCH(int, chunkSize);
+
+    // 100k rule results shaped like SSG output of oscap --progress
+    static const int RULE_COUNT = 100000;
+    const char* const results[] = {"pass", "fail", "notapplicable", "notchecked"};
+    QByteArray output;
+    for (int i = 0; i < RULE_COUNT; ++i)
+    {
+        output += "xccdf_org.ssgproject.content_rule_synthetic_";
+        output += QByteArray::number(i);
+        output += ':';
+        output += results[i % 4];
+        output += '\n';
+    }
+
+    QBENCHMARK
+    {
+        ProgressParsingScanner scanner;
+        for (int offset = 0; offset < output.size(); offset += chunkSize)
+            scanner.feed(output.mid(offset, chunkSize));
+    }
+
+    // the chunking must not lose any results
+    ProgressParsingScanner scanner;
+    QSignalSpy spy(&scanner, SIGNAL(progressReportBatch(QStringList,QStringList)));
+    for (int offset = 0; offset < output.size(); offset += chunkSize)
+        scanner.feed(output.mid(offset, chunkSize));
+
+    // "processing" is only reported for rules split between chunks
+    const QStringList reported = batchResults(spy);
+    QCOMPARE(reported.size() - reported.filter(":processing").size(), RULE_COUNT);
+    QCOMPARE(reported.last(), QString("xccdf_org.ssgproject.content_rule_synthetic_%1:notchecked").arg(RULE_COUNT - 1));
+}
+
+QTEST_MAIN(OscapScannerBaseTest)
+#include "OscapScannerBaseTest.moc"
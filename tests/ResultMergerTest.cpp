@@ -0,0 +1,247 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ResultMerger.h"
+
+#include <QtTest>
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QXmlStreamReader>
+
+class ResultMergerTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void multiCheckReplacedAsWhole();
+        void multiCheckWithFewerRuleResults();
+        void multiCheckStrictest();
+        void arfOVALReportsAppended();
+        void cleanup();
+
+    private:
+        /// Writes an XCCDF result document with given "ruleID:result" rule-results
+        QString writeResults(const QStringList& ruleResults);
+        /// Writes an ARF with given "ruleID:result" rule-results, all of them checked by the OVAL report "oval0"
+        QString writeARF(const QStringList& ruleResults);
+        QByteArray merge(const QStringList& inputs, ResultMerger::Precedence precedence);
+        static QStringList ruleResults(const QByteArray& document);
+
+        QList<QTemporaryFile*> mFiles;
+};
+
+QString ResultMergerTest::writeResults(const QStringList& ruleResults)
+{
+    QTemporaryFile* file = new QTemporaryFile();
+    mFiles.append(file);
+    if (!file->open())
+        return QString();
+
+    QByteArray document =
+        "<?xml version=\"1.0\"?>\n"
+        "<Benchmark xmlns=\"http://checklists.nist.gov/xccdf/1.2\" id=\"xccdf_org.example_benchmark_test\">\n"
+        "<TestResult id=\"xccdf_org.example_testresult_test\">\n";
+
+    for (QStringList::const_iterator it = ruleResults.constBegin(); it != ruleResults.constEnd(); ++it)
+    {
+        const QStringList parts = it->split(':');
+        document += QString("<rule-result idref=\"%1\"><result>%2</result></rule-result>\n")
+            .arg(parts[0], parts[1]).toUtf8();
+    }
+
+    document +=
+        "<score system=\"urn:xccdf:scoring:flat\" maximum=\"0\">0</score>\n"
+        "</TestResult>\n"
+        "</Benchmark>\n";
+
+    file->write(document);
+    file->close();
+    return file->fileName();
+}
+
+QString ResultMergerTest::writeARF(const QStringList& ruleResults)
+{
+    QTemporaryFile* file = new QTemporaryFile();
+    mFiles.append(file);
+    if (!file->open())
+        return QString();
+
+    QByteArray document =
+        "<?xml version=\"1.0\"?>\n"
+        "<arf:asset-report-collection xmlns:arf=\"http://scap.nist.gov/schema/asset-reporting-format/1.1\" "
+        "xmlns:core=\"http://scap.nist.gov/schema/reporting-core/1.1\">\n"
+        "<core:relationships>\n"
+        "<core:relationship type=\"arfvocab:isAbout\" subject=\"xccdf1\"><core:ref>asset0</core:ref></core:relationship>\n"
+        "<core:relationship type=\"arfvocab:isAbout\" subject=\"oval0\"><core:ref>asset0</core:ref></core:relationship>\n"
+        "</core:relationships>\n"
+        "<arf:reports>\n"
+        "<arf:report id=\"xccdf1\"><arf:content>\n"
+        "<TestResult xmlns=\"http://checklists.nist.gov/xccdf/1.2\" id=\"xccdf_org.example_testresult_test\">\n";
+
+    for (QStringList::const_iterator it = ruleResults.constBegin(); it != ruleResults.constEnd(); ++it)
+    {
+        const QStringList parts = it->split(':');
+        document += QString("<rule-result idref=\"%1\"><result>%2</result>"
+            "<check system=\"http://oval.mitre.org/XMLSchema/oval-definitions-5\">"
+            "<check-content-ref name=\"oval:org.example:def:1\" href=\"#oval0\"/></check></rule-result>\n")
+            .arg(parts[0], parts[1]).toUtf8();
+    }
+
+    document +=
+        "<score system=\"urn:xccdf:scoring:flat\" maximum=\"0\">0</score>\n"
+        "</TestResult>\n"
+        "</arf:content></arf:report>\n"
+        "<arf:report id=\"oval0\"><arf:content>\n"
+        "<oval_results xmlns=\"http://oval.mitre.org/XMLSchema/oval-results-5\"/>\n"
+        "</arf:content></arf:report>\n"
+        "</arf:reports>\n"
+        "</arf:asset-report-collection>\n";
+
+    file->write(document);
+    file->close();
+    return file->fileName();
+}
+
+QByteArray ResultMergerTest::merge(const QStringList& inputs, ResultMerger::Precedence precedence)
+{
+    ResultMerger merger;
+    merger.setPrecedence(precedence);
+    for (QStringList::const_iterator it = inputs.constBegin(); it != inputs.constEnd(); ++it)
+        merger.addInput(*it);
+
+    QByteArray ret;
+    QBuffer buffer(&ret);
+    buffer.open(QIODevice::WriteOnly);
+    merger.merge(buffer);
+
+    return ret;
+}
+
+QStringList ResultMergerTest::ruleResults(const QByteArray& document)
+{
+    QStringList ruleIDs;
+    QStringList results;
+    QBuffer buffer;
+    buffer.setData(document);
+    buffer.open(QIODevice::ReadOnly);
+    ResultMerger::getRuleResults(buffer, ruleIDs, results);
+
+    QStringList ret;
+    for (int i = 0; i < ruleIDs.size(); ++i)
+        ret.append(ruleIDs[i] + ":" + results[i]);
+
+    return ret;
+}
+
+void ResultMergerTest::cleanup()
+{
+    qDeleteAll(mFiles);
+    mFiles.clear();
+}
+
+void ResultMergerTest::multiCheckReplacedAsWhole()
+{
+    const QString base = writeResults(QStringList()
+        << "rule_a:fail" << "rule_a:fail" << "rule_b:pass");
+    const QString rescan = writeResults(QStringList()
+        << "rule_a:pass" << "rule_a:pass");
+
+    const QByteArray merged = merge(QStringList() << base << rescan, ResultMerger::PRECEDENCE_LATEST);
+
+    // no stale fail may be left behind from the base
+    QCOMPARE(ruleResults(merged), QStringList() << "rule_a:pass" << "rule_a:pass" << "rule_b:pass");
+    QVERIFY(merged.contains("maximum=\"3.000000\">3.000000</score>"));
+}
+
+void ResultMergerTest::multiCheckWithFewerRuleResults()
+{
+    const QString base = writeResults(QStringList()
+        << "rule_a:fail" << "rule_b:pass" << "rule_a:error");
+    const QString rescan = writeResults(QStringList()
+        << "rule_a:pass");
+
+    const QByteArray merged = merge(QStringList() << base << rescan, ResultMerger::PRECEDENCE_LATEST);
+
+    QCOMPARE(ruleResults(merged), QStringList() << "rule_a:pass" << "rule_b:pass");
+    QVERIFY(merged.contains("maximum=\"2.000000\">2.000000</score>"));
+}
+
+void ResultMergerTest::multiCheckStrictest()
+{
+    const QString first = writeResults(QStringList()
+        << "rule_a:pass" << "rule_a:fail");
+    const QString second = writeResults(QStringList()
+        << "rule_a:pass" << "rule_a:pass");
+
+    // one failed check is enough for the first input to win
+    const QByteArray merged = merge(QStringList() << first << second, ResultMerger::PRECEDENCE_STRICTEST);
+
+    QCOMPARE(ruleResults(merged), QStringList() << "rule_a:pass" << "rule_a:fail");
+    QVERIFY(merged.contains("maximum=\"2.000000\">1.000000</score>"));
+}
+
+void ResultMergerTest::arfOVALReportsAppended()
+{
+    const QString base = writeARF(QStringList()
+        << "rule_a:fail" << "rule_b:fail");
+    const QString first = writeARF(QStringList()
+        << "rule_b:pass");
+    const QString second = writeARF(QStringList()
+        << "rule_a:pass");
+
+    const QByteArray merged = merge(QStringList() << base << first << second, ResultMerger::PRECEDENCE_LATEST);
+    QCOMPARE(ruleResults(merged), QStringList() << "rule_a:pass" << "rule_b:pass");
+
+    QStringList reportIDs;
+    QStringList subjects;
+    QStringList hrefs;
+
+    QXmlStreamReader reader(merged);
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+        if (!reader.isStartElement())
+            continue;
+
+        if (reader.name() == "report")
+            reportIDs.append(reader.attributes().value("id").toString());
+        else if (reader.name() == "relationship")
+            subjects.append(reader.attributes().value("subject").toString());
+        else if (reader.name() == "check-content-ref")
+            hrefs.append(reader.attributes().value("href").toString());
+    }
+    QVERIFY(!reader.hasError());
+
+    // every input has its own "oval0", none of them may clash
+    QCOMPARE(reportIDs, QStringList() << "xccdf1" << "oval0" << "oval0-merged1" << "oval0-merged2");
+    QCOMPARE(reportIDs.toSet().size(), reportIDs.size());
+
+    // rule_a comes from the second input, rule_b from the first one
+    QCOMPARE(hrefs, QStringList() << "#oval0-merged2" << "#oval0-merged1");
+    for (QStringList::const_iterator it = hrefs.constBegin(); it != hrefs.constEnd(); ++it)
+        QVERIFY(reportIDs.contains(it->mid(1)));
+
+    QCOMPARE(subjects, QStringList() << "xccdf1" << "oval0" << "oval0-merged1" << "oval0-merged2");
+}
+
+QTEST_MAIN(ResultMergerTest)
+#include "ResultMergerTest.moc"
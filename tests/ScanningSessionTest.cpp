@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Authors:
+ *      Martin Preisler <mpreisle@redhat.com>
+ */
+
+
+#include "ScanningSession.h"
+
+extern "C" {
+#include <xccdf_policy.h>
+#include <xccdf_session.h>
+}
+
+#include <QtTest>
+
+class ScanningSessionTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void init();
+        void cleanup();
+
+        void switchTailoringsSharingProfileID();
+        void tailoringShadowsSelectedProfile();
+
+    private:
+        static QString dataPath(const QString& fileName);
+        /// Returns whether given rule is selected in the currently selected profile
+        bool isRuleSelected(const QString& ruleID);
+
+        ScanningSession* mSession;
+};
+
+QString ScanningSessionTest::dataPath(const QString& fileName)
+{
+    return QString(SCAP_WORKBENCH_TEST_DATA_DIR) + "/" + fileName;
+}
+
+bool ScanningSessionTest::isRuleSelected(const QString& ruleID)
+{
+    struct xccdf_policy* policy = xccdf_session_get_xccdf_policy(mSession->getXCCDFSession());
+    if (!policy)
+        return false;
+
+    return xccdf_policy_is_item_selected(policy, ruleID.toUtf8().constData());
+}
+
+void ScanningSessionTest::init()
+{
+    mSession = new ScanningSession();
+    mSession->setSkipValid(true);
+    mSession->openFile(dataPath("tailoring-benchmark.xml"));
+}
+
+void ScanningSessionTest::cleanup()
+{
+    delete mSession;
+    mSession = 0;
+}
+
+void ScanningSessionTest::switchTailoringsSharingProfileID()
+{
+    const QString profileID = "xccdf_org.example_profile_tailored";
+
+    mSession->setTailoringFile(dataPath("tailoring-selects-rule-b.xml"));
+    mSession->setProfile(profileID);
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_b"));
+    QVERIFY(!isRuleSelected("xccdf_org.example_rule_c"));
+
+    // the profile of the previous tailoring must not be used for the new one
+    mSession->setTailoringFile(dataPath("tailoring-selects-rule-c.xml"));
+    mSession->setProfile(profileID);
+    QVERIFY(!isRuleSelected("xccdf_org.example_rule_b"));
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_c"));
+
+    mSession->setTailoringFile(dataPath("tailoring-selects-rule-b.xml"));
+    mSession->setProfile(profileID);
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_b"));
+    QVERIFY(!isRuleSelected("xccdf_org.example_rule_c"));
+
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_a"));
+}
+
+void ScanningSessionTest::tailoringShadowsSelectedProfile()
+{
+    const QString profileID = "xccdf_org.example_profile_base";
+
+    mSession->setProfile(profileID);
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_a"));
+    QVERIFY(!isRuleSelected("xccdf_org.example_rule_c"));
+
+    // the benchmark profile must not be used once the tailoring shadows it
+    mSession->setTailoringFile(dataPath("tailoring-shadows-base.xml"));
+    mSession->setProfile(profileID);
+    QVERIFY(!isRuleSelected("xccdf_org.example_rule_a"));
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_c"));
+
+    mSession->resetTailoring();
+    mSession->setProfile(profileID);
+    QVERIFY(isRuleSelected("xccdf_org.example_rule_a"));
+    QVERIFY(!isRuleSelected("xccdf_org.example_rule_c"));
+}
+
+QTEST_MAIN(ScanningSessionTest)
+#include "ScanningSessionTest.moc"